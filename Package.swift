@@ -5,7 +5,7 @@ import PackageDescription
 let package = Package(
     name: "Zewo",
     products: [
-        .library(name: "Zewo", targets: ["CYAJL", "CHTTPParser", "Core", "IO", "Media", "HTTP", "Zewo"])
+        .library(name: "Zewo", targets: ["CYAJL", "CHTTPParser", "CURing", "CSystem", "CZlib", "Core", "IO", "Media", "HTTP", "Zewo"])
     ],
     dependencies: [
         .package(url: "https://github.com/Zewo/CLibdill.git", from: "2.0.0"),
@@ -16,11 +16,14 @@ let package = Package(
     targets: [
         .target(name: "CYAJL"),
         .target(name: "CHTTPParser"),
+        .target(name: "CURing"),
+        .target(name: "CSystem"),
+        .target(name: "CZlib", linkerSettings: [.linkedLibrary("z")]),
         
-        .target(name: "Core", dependencies: ["Venice"]),
-        .target(name: "IO", dependencies: ["Core"]),
+        .target(name: "Core", dependencies: ["Venice", "CSystem"]),
+        .target(name: "IO", dependencies: ["Core", "CURing", "CSystem"]),
         .target(name: "Media", dependencies: ["Core", "CYAJL"]),
-        .target(name: "HTTP", dependencies: ["Media", "IO", "CHTTPParser"]),
+        .target(name: "HTTP", dependencies: ["Media", "IO", "CHTTPParser", "CZlib"]),
         .target(name: "Zewo", dependencies: ["Core", "IO", "Media", "HTTP"]),
         
         .testTarget(name: "CoreTests", dependencies: ["Core"]),
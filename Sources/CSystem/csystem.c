@@ -0,0 +1,473 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include "csystem.h"
+
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <sys/sendfile.h>
+#elif defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+int csystem_pipe(int fds[2]) {
+#if defined(__linux__)
+    return pipe2(fds, O_NONBLOCK | O_CLOEXEC);
+#else
+    if (pipe(fds) == -1) return -1;
+    for (int i = 0; i < 2; i++) {
+        int flags = fcntl(fds[i], F_GETFL, 0);
+        if (flags == -1 || fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) == -1 ||
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC) == -1) {
+            int error = errno;
+            close(fds[0]);
+            close(fds[1]);
+            errno = error;
+            return -1;
+        }
+    }
+    return 0;
+#endif
+}
+
+ssize_t csystem_splice(int in, int out, size_t length, int more) {
+#if defined(__linux__)
+    unsigned int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    if (more) flags |= SPLICE_F_MORE;
+    return splice(in, NULL, out, NULL, length, flags);
+#else
+    (void) in; (void) out; (void) length; (void) more;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+ssize_t csystem_sendfile(int out, int in, off_t *offset, size_t length) {
+#if defined(__linux__)
+    return sendfile(out, in, offset, length);
+#elif defined(__APPLE__)
+    off_t sent = (off_t) length;
+    int result = sendfile(in, out, *offset, &sent, NULL, 0);
+    *offset += sent;
+    /* Partial sends on non-blocking sockets report EAGAIN alongside progress. */
+    if (result == -1 && !(errno == EAGAIN && sent > 0)) return -1;
+    return (ssize_t) sent;
+#else
+    (void) out; (void) in; (void) offset; (void) length;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int csystem_watch_create(void) {
+#if defined(__linux__)
+    return inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int csystem_watch_add(int fd, const char *path) {
+#if defined(__linux__)
+    uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE |
+        IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    return inotify_add_watch(fd, path, mask);
+#else
+    (void) fd; (void) path;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+int csystem_watch_event(const void *buffer, size_t length, size_t *offset, int *watch, const char **name,
+                        int *removed) {
+#if defined(__linux__)
+    const struct inotify_event *event;
+    if (*offset + sizeof(struct inotify_event) > length) return 0;
+    event = (const struct inotify_event *) ((const char *) buffer + *offset);
+    *offset += sizeof(struct inotify_event) + event->len;
+    *watch = (event->mask & IN_Q_OVERFLOW) ? -1 : event->wd;
+    *name = event->len > 0 ? event->name : "";
+    *removed = (event->mask & IN_IGNORED) != 0;
+    return 1;
+#else
+    (void) buffer; (void) length; (void) offset; (void) watch; (void) name; (void) removed;
+    return 0;
+#endif
+}
+
+#define CSYSTEM_STACK_DEPTH 64
+
+struct csystem_watchdog {
+    pthread_t watched;
+    pthread_t thread;
+    int64_t limit;
+    int64_t heartbeat;
+    int64_t sampled_heartbeat;
+    int stopped;
+    pthread_mutex_t mutex;
+    void *frames[CSYSTEM_STACK_DEPTH];
+    int frame_count;
+};
+
+/* One sample is taken at a time, so the handler writes to a single slot.
+ * Each request is tagged with a sequence number that the handler claims
+ * before it writes; a signal arriving after its request was given up finds
+ * nothing to claim and leaves the slot alone. */
+static pthread_mutex_t sample_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t sample_once = PTHREAD_ONCE_INIT;
+static struct sigaction sample_previous;
+static pthread_t sample_target;
+static uint64_t sample_sequence;
+static uint64_t sample_pending;
+static uint64_t sample_done;
+static void *sample_frames[CSYSTEM_STACK_DEPTH];
+static int sample_count;
+static int sample_installed;
+
+static int64_t monotonic_now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (int64_t) time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+static void sample_handler(int signal, siginfo_t *info, void *context) {
+    int error = errno;
+    uint64_t sequence = __atomic_load_n(&sample_pending, __ATOMIC_ACQUIRE);
+
+    if (sequence != 0 && pthread_equal(pthread_self(), sample_target) &&
+        __atomic_compare_exchange_n(&sample_pending, &sequence, 0, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&sample_count, backtrace(sample_frames, CSYSTEM_STACK_DEPTH), __ATOMIC_RELAXED);
+        __atomic_store_n(&sample_done, sequence, __ATOMIC_RELEASE);
+    } else if (sample_previous.sa_flags & SA_SIGINFO) {
+        /* Not ours, e.g. a profiler's timer: pass it on. */
+        errno = error;
+        sample_previous.sa_sigaction(signal, info, context);
+    } else if (sample_previous.sa_handler != SIG_DFL && sample_previous.sa_handler != SIG_IGN) {
+        errno = error;
+        sample_previous.sa_handler(signal);
+    }
+
+    errno = error;
+}
+
+static void sample_install(void) {
+    struct sigaction action;
+    void *frame;
+    /* backtrace() loads libgcc on first use, which is not safe in a handler. */
+    backtrace(&frame, 1);
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = sample_handler;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    sample_installed = sigaction(SIGPROF, &action, &sample_previous) == 0;
+}
+
+static void watchdog_sample(csystem_watchdog *watchdog) {
+    int64_t deadline = monotonic_now() + watchdog->limit;
+    struct timespec pause = {0, 1000000};
+    uint64_t sequence;
+    int sampled = 0;
+
+    pthread_mutex_lock(&sample_mutex);
+    sequence = ++sample_sequence;
+    sample_target = watchdog->watched;
+    __atomic_store_n(&sample_pending, sequence, __ATOMIC_RELEASE);
+
+    if (pthread_kill(watchdog->watched, SIGPROF) == 0) {
+        while (__atomic_load_n(&sample_done, __ATOMIC_ACQUIRE) != sequence && monotonic_now() < deadline) {
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    /* Withdraws the request. If the handler already claimed it, it is
+     * writing the sample right now and is waited for. */
+    if (__atomic_exchange_n(&sample_pending, 0, __ATOMIC_ACQ_REL) == 0) {
+        while (__atomic_load_n(&sample_done, __ATOMIC_ACQUIRE) != sequence) {
+            nanosleep(&pause, NULL);
+        }
+
+        sampled = 1;
+    }
+
+    if (sampled) {
+        pthread_mutex_lock(&watchdog->mutex);
+        watchdog->frame_count = __atomic_load_n(&sample_count, __ATOMIC_RELAXED);
+        memcpy(watchdog->frames, sample_frames, sizeof(void *) * (size_t) watchdog->frame_count);
+        pthread_mutex_unlock(&watchdog->mutex);
+    }
+
+    pthread_mutex_unlock(&sample_mutex);
+}
+
+static void *watchdog_run(void *argument) {
+    csystem_watchdog *watchdog = argument;
+    int64_t period = watchdog->limit / 4 > 1000000 ? watchdog->limit / 4 : 1000000;
+    struct timespec pause = {(time_t) (period / 1000000000), (long) (period % 1000000000)};
+
+    while (!__atomic_load_n(&watchdog->stopped, __ATOMIC_ACQUIRE)) {
+        int64_t heartbeat;
+        nanosleep(&pause, NULL);
+        heartbeat = __atomic_load_n(&watchdog->heartbeat, __ATOMIC_ACQUIRE);
+
+        if (heartbeat != watchdog->sampled_heartbeat && monotonic_now() - heartbeat > watchdog->limit) {
+            watchdog->sampled_heartbeat = heartbeat;
+            watchdog_sample(watchdog);
+        }
+    }
+
+    return NULL;
+}
+
+csystem_watchdog *csystem_watchdog_start(pthread_t thread, int64_t limit_ns) {
+    csystem_watchdog *watchdog;
+    int error;
+
+    pthread_once(&sample_once, sample_install);
+
+    if (!sample_installed) return NULL;
+
+    watchdog = calloc(1, sizeof(csystem_watchdog));
+
+    if (watchdog == NULL) return NULL;
+
+    watchdog->watched = thread;
+    watchdog->limit = limit_ns;
+    watchdog->heartbeat = monotonic_now();
+    watchdog->sampled_heartbeat = watchdog->heartbeat;
+    pthread_mutex_init(&watchdog->mutex, NULL);
+    error = pthread_create(&watchdog->thread, NULL, watchdog_run, watchdog);
+
+    if (error != 0) {
+        pthread_mutex_destroy(&watchdog->mutex);
+        free(watchdog);
+        errno = error;
+        return NULL;
+    }
+
+    return watchdog;
+}
+
+void csystem_watchdog_beat(csystem_watchdog *watchdog, int64_t now_ns) {
+    __atomic_store_n(&watchdog->heartbeat, now_ns, __ATOMIC_RELEASE);
+}
+
+int csystem_watchdog_take_sample(csystem_watchdog *watchdog, void **frames, int capacity) {
+    int count;
+    pthread_mutex_lock(&watchdog->mutex);
+    count = watchdog->frame_count < capacity ? watchdog->frame_count : capacity;
+    memcpy(frames, watchdog->frames, sizeof(void *) * (size_t) count);
+    watchdog->frame_count = 0;
+    pthread_mutex_unlock(&watchdog->mutex);
+    return count;
+}
+
+void csystem_watchdog_stop(csystem_watchdog *watchdog) {
+    __atomic_store_n(&watchdog->stopped, 1, __ATOMIC_RELEASE);
+    pthread_join(watchdog->thread, NULL);
+    pthread_mutex_destroy(&watchdog->mutex);
+    free(watchdog);
+}
+
+char **csystem_stack_symbols(void *const *frames, int count) {
+    return backtrace_symbols(frames, count);
+}
+
+struct csystem_queue_cell {
+    uint64_t sequence;
+    void *item;
+};
+
+struct csystem_queue {
+    size_t mask;
+    struct csystem_queue_cell *cells;
+    /* Kept on cache lines of their own, producers only touch the first. */
+    uint64_t enqueue_position __attribute__((aligned(64)));
+    uint64_t dequeue_position __attribute__((aligned(64)));
+    uint64_t done;
+    uint64_t dropped;
+    int sleeping;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+};
+
+csystem_queue *csystem_queue_create(size_t capacity) {
+    csystem_queue *queue;
+    size_t size = 2;
+
+    while (size < capacity) size <<= 1;
+
+    if (posix_memalign((void **) &queue, 64, sizeof(csystem_queue)) != 0) return NULL;
+
+    memset(queue, 0, sizeof(csystem_queue));
+    queue->cells = calloc(size, sizeof(struct csystem_queue_cell));
+
+    if (queue->cells == NULL) {
+        free(queue);
+        return NULL;
+    }
+
+    queue->mask = size - 1;
+
+    for (size_t index = 0; index < size; index++) {
+        queue->cells[index].sequence = index;
+    }
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->condition, NULL);
+    return queue;
+}
+
+void csystem_queue_destroy(csystem_queue *queue) {
+    pthread_cond_destroy(&queue->condition);
+    pthread_mutex_destroy(&queue->mutex);
+    free(queue->cells);
+    free(queue);
+}
+
+int csystem_queue_push(csystem_queue *queue, void *item) {
+    uint64_t position = __atomic_load_n(&queue->enqueue_position, __ATOMIC_RELAXED);
+    struct csystem_queue_cell *cell;
+
+    for (;;) {
+        int64_t difference;
+        cell = &queue->cells[position & queue->mask];
+        difference = (int64_t) __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) - (int64_t) position;
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&queue->enqueue_position, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            return 0;
+        } else {
+            position = __atomic_load_n(&queue->enqueue_position, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->item = item;
+    __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&queue->sleeping, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&queue->mutex);
+        pthread_cond_signal(&queue->condition);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    return 1;
+}
+
+static int queue_ready(csystem_queue *queue) {
+    uint64_t position = queue->dequeue_position;
+    struct csystem_queue_cell *cell = &queue->cells[position & queue->mask];
+    return __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) == position + 1;
+}
+
+void *csystem_queue_pop(csystem_queue *queue) {
+    uint64_t position = queue->dequeue_position;
+    struct csystem_queue_cell *cell = &queue->cells[position & queue->mask];
+    void *item;
+
+    if (!queue_ready(queue)) return NULL;
+
+    item = cell->item;
+    __atomic_store_n(&cell->sequence, position + queue->mask + 1, __ATOMIC_RELEASE);
+    queue->dequeue_position = position + 1;
+    return item;
+}
+
+void csystem_queue_wait(csystem_queue *queue, int64_t timeout_ns) {
+    struct timespec deadline;
+
+    /* Producers signal holding the mutex, after the sleeping flag is set
+     * and the queue checked, so no push goes unnoticed. */
+    pthread_mutex_lock(&queue->mutex);
+    __atomic_store_n(&queue->sleeping, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (!queue_ready(queue)) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t) (timeout_ns / 1000000000);
+        deadline.tv_nsec += (long) (timeout_ns % 1000000000);
+
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        pthread_cond_timedwait(&queue->condition, &queue->mutex, &deadline);
+    }
+
+    __atomic_store_n(&queue->sleeping, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+uint64_t csystem_queue_pushed(csystem_queue *queue) {
+    return __atomic_load_n(&queue->enqueue_position, __ATOMIC_ACQUIRE);
+}
+
+uint64_t csystem_queue_done(csystem_queue *queue) {
+    return __atomic_load_n(&queue->done, __ATOMIC_ACQUIRE);
+}
+
+void csystem_queue_set_done(csystem_queue *queue, uint64_t count) {
+    __atomic_store_n(&queue->done, count, __ATOMIC_RELEASE);
+}
+
+void csystem_queue_drop(csystem_queue *queue) {
+    __atomic_fetch_add(&queue->dropped, 1, __ATOMIC_RELAXED);
+}
+
+uint64_t csystem_queue_dropped(csystem_queue *queue) {
+    return __atomic_load_n(&queue->dropped, __ATOMIC_RELAXED);
+}
+
+struct csystem_thread {
+    pthread_t thread;
+    void (*body)(void *);
+    void *context;
+};
+
+static void *thread_run(void *argument) {
+    csystem_thread *thread = argument;
+    thread->body(thread->context);
+    return NULL;
+}
+
+csystem_thread *csystem_thread_start(void (*body)(void *), void *context) {
+    csystem_thread *thread = malloc(sizeof(csystem_thread));
+    int error;
+
+    if (thread == NULL) return NULL;
+
+    thread->body = body;
+    thread->context = context;
+    error = pthread_create(&thread->thread, NULL, thread_run, thread);
+
+    if (error != 0) {
+        free(thread);
+        errno = error;
+        return NULL;
+    }
+
+    return thread;
+}
+
+void csystem_thread_join(csystem_thread *thread) {
+    pthread_join(thread->thread, NULL);
+    free(thread);
+}
@@ -0,0 +1,112 @@
+#ifndef csystem_h
+#define csystem_h
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+/* Portable shims over zero-copy system calls whose prototypes are either
+ * hidden behind _GNU_SOURCE or differ between platforms. Calls that have no
+ * equivalent on the current platform fail with ENOSYS. */
+
+/* Creates a non-blocking, close-on-exec pipe. */
+int csystem_pipe(int fds[2]);
+
+/* Moves up to `length` bytes between `in` and `out`, one of which must be a
+ * pipe, without copying through userspace. `more` hints that further data
+ * follows. */
+ssize_t csystem_splice(int in, int out, size_t length, int more);
+
+/* Sends up to `length` bytes of file `in` starting at `*offset` to socket
+ * `out`, advancing `*offset` by the amount sent. */
+ssize_t csystem_sendfile(int out, int in, off_t *offset, size_t length);
+
+/* Creates a non-blocking, close-on-exec inotify instance. */
+int csystem_watch_create(void);
+
+/* Watches `path`, a directory, for entries being created, modified, moved
+ * or deleted. Returns the watch descriptor. */
+int csystem_watch_add(int fd, const char *path);
+
+/* Decodes the event at `*offset` of `buffer`, which holds `length` bytes
+ * read from the inotify descriptor, and advances `*offset` past it.
+ * Returns 0 once the buffer is exhausted. `*watch` is -1 when the kernel
+ * queue overflowed and events were lost. `*name` is empty for events on the
+ * watched directory itself, and `*removed` is set once its watch is gone. */
+int csystem_watch_event(const void *buffer, size_t length, size_t *offset, int *watch, const char **name,
+                        int *removed);
+
+typedef struct csystem_watchdog csystem_watchdog;
+
+/* Starts a thread that samples the stack of `thread` whenever its heartbeat
+ * is more than `limit_ns` old, once per missed heartbeat. The stack is
+ * captured by interrupting `thread` with SIGPROF, whose handler is
+ * installed by the first call and passes signals it did not ask for on to
+ * the handler it replaced. Returns NULL with errno set on failure. */
+csystem_watchdog *csystem_watchdog_start(pthread_t thread, int64_t limit_ns);
+
+/* Records a heartbeat of the watched thread at CLOCK_MONOTONIC `now_ns`. */
+void csystem_watchdog_beat(csystem_watchdog *watchdog, int64_t now_ns);
+
+/* Moves the latest stack sampled into `frames`, which holds `capacity`
+ * return addresses. Returns the number of frames, 0 if none was sampled
+ * since the last call. */
+int csystem_watchdog_take_sample(csystem_watchdog *watchdog, void **frames, int capacity);
+
+/* Stops and frees `watchdog`. */
+void csystem_watchdog_stop(csystem_watchdog *watchdog);
+
+/* Symbolic names of `count` return addresses, to be released with free(),
+ * or NULL. */
+char **csystem_stack_symbols(void *const *frames, int count);
+
+typedef struct csystem_queue csystem_queue;
+
+/* Creates a bounded lock-free queue of pointers, for any number of
+ * producers and one consumer, holding `capacity` rounded up to a power of
+ * two. Returns NULL on failure. */
+csystem_queue *csystem_queue_create(size_t capacity);
+
+/* Frees `queue`, which must be empty. */
+void csystem_queue_destroy(csystem_queue *queue);
+
+/* Appends `item`, waking the consumer if it waits. Returns 0 if full. */
+int csystem_queue_push(csystem_queue *queue, void *item);
+
+/* Removes the oldest item. Returns NULL if empty. Consumer only. */
+void *csystem_queue_pop(csystem_queue *queue);
+
+/* Waits up to `timeout_ns` for the queue not to be empty. Consumer only. */
+void csystem_queue_wait(csystem_queue *queue, int64_t timeout_ns);
+
+/* Number of items ever pushed, or being pushed. */
+uint64_t csystem_queue_pushed(csystem_queue *queue);
+
+/* Number of items the consumer reported done with, which it sets with
+ * csystem_queue_set_done(). */
+uint64_t csystem_queue_done(csystem_queue *queue);
+void csystem_queue_set_done(csystem_queue *queue, uint64_t count);
+
+/* Counts an item a producer dropped instead of pushing. */
+void csystem_queue_drop(csystem_queue *queue);
+
+/* Number of items producers dropped. */
+uint64_t csystem_queue_dropped(csystem_queue *queue);
+
+typedef struct csystem_thread csystem_thread;
+
+/* Starts a thread running `body(context)`. Returns NULL with errno set on
+ * failure. */
+csystem_thread *csystem_thread_start(void (*body)(void *), void *context);
+
+/* Waits for `thread` to return and frees it. */
+void csystem_thread_join(csystem_thread *thread);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
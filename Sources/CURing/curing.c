@@ -0,0 +1,325 @@
+#include "curing.h"
+
+#include <errno.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+
+#include <linux/io_uring.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+
+#ifndef IORING_ACCEPT_MULTISHOT
+#define IORING_ACCEPT_MULTISHOT (1U << 0)
+#endif
+
+struct curing_ring {
+    int fd;
+
+    void *sq_map;
+    size_t sq_map_size;
+    void *cq_map;
+    size_t cq_map_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    unsigned sq_local_tail;
+    unsigned sq_submitted_tail;
+
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+struct curing_ring *curing_ring_create(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    int fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) return NULL;
+
+    struct curing_ring *ring = calloc(1, sizeof(struct curing_ring));
+    if (!ring) {
+        close(fd);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    ring->fd = fd;
+    ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    int single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap && ring->cq_map_size > ring->sq_map_size)
+        ring->sq_map_size = ring->cq_map_size;
+
+    ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) goto error;
+
+    if (single_mmap) {
+        ring->cq_map = ring->sq_map;
+    } else {
+        ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) goto error;
+    }
+
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) goto error;
+
+    char *sq = ring->sq_map;
+    ring->sq_head = (unsigned *) (sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *) (sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *) (sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) (sq + params.sq_off.array);
+    ring->sq_entries = params.sq_entries;
+    ring->sq_local_tail = *ring->sq_tail;
+    ring->sq_submitted_tail = ring->sq_local_tail;
+
+    char *cq = ring->cq_map;
+    ring->cq_head = (unsigned *) (cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *) (cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *) (cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+    return ring;
+
+error:
+    curing_ring_destroy(ring);
+    return NULL;
+}
+
+void curing_ring_destroy(struct curing_ring *ring) {
+    if (!ring) return;
+    int error = errno;
+    if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_map && ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map)
+        munmap(ring->cq_map, ring->cq_map_size);
+    if (ring->sq_map && ring->sq_map != MAP_FAILED) munmap(ring->sq_map, ring->sq_map_size);
+    close(ring->fd);
+    free(ring);
+    errno = error;
+}
+
+int curing_ring_fd(const struct curing_ring *ring) {
+    return ring->fd;
+}
+
+static struct io_uring_sqe *curing_get_sqe(struct curing_ring *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (ring->sq_local_tail - head >= ring->sq_entries) {
+        errno = EBUSY;
+        return NULL;
+    }
+    unsigned index = ring->sq_local_tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->sq_local_tail++;
+    return sqe;
+}
+
+int curing_prep_accept(struct curing_ring *ring, int fd, int multishot, uint64_t user_data) {
+    struct io_uring_sqe *sqe = curing_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    if (multishot) sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int curing_prep_connect(struct curing_ring *ring, int fd, const struct sockaddr *addr, socklen_t len, uint64_t user_data) {
+    struct io_uring_sqe *sqe = curing_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) addr;
+    sqe->off = len;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int curing_prep_recv(struct curing_ring *ring, int fd, void *buffer, size_t length, uint64_t user_data) {
+    struct io_uring_sqe *sqe = curing_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) buffer;
+    sqe->len = (unsigned) length;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int curing_prep_send(struct curing_ring *ring, int fd, const void *buffer, size_t length, int flags, uint64_t user_data) {
+    struct io_uring_sqe *sqe = curing_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) buffer;
+    sqe->len = (unsigned) length;
+    sqe->msg_flags = (unsigned) flags;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int curing_prep_close(struct curing_ring *ring, int fd, uint64_t user_data) {
+    struct io_uring_sqe *sqe = curing_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+int curing_prep_cancel(struct curing_ring *ring, uint64_t target, uint64_t user_data) {
+    struct io_uring_sqe *sqe = curing_get_sqe(ring);
+    if (!sqe) return -1;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = user_data;
+    return 0;
+}
+
+unsigned curing_pending(const struct curing_ring *ring) {
+    return ring->sq_local_tail - ring->sq_submitted_tail;
+}
+
+int curing_submit(struct curing_ring *ring) {
+    unsigned count = curing_pending(ring);
+    if (count == 0) return 0;
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    int result;
+    do {
+        result = (int) syscall(__NR_io_uring_enter, ring->fd, count, 0, 0, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) return -1;
+    ring->sq_submitted_tail += (unsigned) result;
+    return result;
+}
+
+int curing_wait(struct curing_ring *ring) {
+    unsigned count = curing_pending(ring);
+    __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+    int result;
+    do {
+        result = (int) syscall(__NR_io_uring_enter, ring->fd, count, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) return -1;
+    ring->sq_submitted_tail += (unsigned) result;
+    return 0;
+}
+
+int curing_peek(struct curing_ring *ring, uint64_t *user_data, int32_t *result, uint32_t *flags) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) return 0;
+    struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+    *user_data = cqe->user_data;
+    *result = cqe->res;
+    *flags = cqe->flags;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int curing_has_more(uint32_t flags) {
+#ifdef IORING_CQE_F_MORE
+    return (flags & IORING_CQE_F_MORE) != 0;
+#else
+    (void) flags;
+    return 0;
+#endif
+}
+
+#else
+
+struct curing_ring;
+
+struct curing_ring *curing_ring_create(unsigned entries) {
+    (void) entries;
+    errno = ENOSYS;
+    return NULL;
+}
+
+void curing_ring_destroy(struct curing_ring *ring) { (void) ring; }
+int curing_ring_fd(const struct curing_ring *ring) { (void) ring; return -1; }
+
+int curing_prep_accept(struct curing_ring *ring, int fd, int multishot, uint64_t user_data) {
+    (void) ring; (void) fd; (void) multishot; (void) user_data;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_prep_connect(struct curing_ring *ring, int fd, const struct sockaddr *addr, socklen_t len, uint64_t user_data) {
+    (void) ring; (void) fd; (void) addr; (void) len; (void) user_data;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_prep_recv(struct curing_ring *ring, int fd, void *buffer, size_t length, uint64_t user_data) {
+    (void) ring; (void) fd; (void) buffer; (void) length; (void) user_data;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_prep_send(struct curing_ring *ring, int fd, const void *buffer, size_t length, int flags, uint64_t user_data) {
+    (void) ring; (void) fd; (void) buffer; (void) length; (void) flags; (void) user_data;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_prep_close(struct curing_ring *ring, int fd, uint64_t user_data) {
+    (void) ring; (void) fd; (void) user_data;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_prep_cancel(struct curing_ring *ring, uint64_t target, uint64_t user_data) {
+    (void) ring; (void) target; (void) user_data;
+    errno = ENOSYS;
+    return -1;
+}
+
+unsigned curing_pending(const struct curing_ring *ring) { (void) ring; return 0; }
+
+int curing_submit(struct curing_ring *ring) {
+    (void) ring;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_wait(struct curing_ring *ring) {
+    (void) ring;
+    errno = ENOSYS;
+    return -1;
+}
+
+int curing_peek(struct curing_ring *ring, uint64_t *user_data, int32_t *result, uint32_t *flags) {
+    (void) ring; (void) user_data; (void) result; (void) flags;
+    return 0;
+}
+
+int curing_has_more(uint32_t flags) { (void) flags; return 0; }
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef curing_h
+#define curing_h
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+
+/* Minimal io_uring binding talking to the kernel directly through
+ * io_uring_setup(2)/io_uring_enter(2). On platforms other than Linux every
+ * function fails with ENOSYS. */
+
+struct curing_ring;
+
+struct curing_ring *curing_ring_create(unsigned entries);
+void curing_ring_destroy(struct curing_ring *ring);
+
+/* Descriptor that polls readable while completions are pending. */
+int curing_ring_fd(const struct curing_ring *ring);
+
+/* Queue a submission. Returns 0 on success and -1 with errno set to EBUSY
+ * when the submission queue is full. */
+int curing_prep_accept(struct curing_ring *ring, int fd, int multishot, uint64_t user_data);
+int curing_prep_connect(struct curing_ring *ring, int fd, const struct sockaddr *addr, socklen_t len, uint64_t user_data);
+int curing_prep_recv(struct curing_ring *ring, int fd, void *buffer, size_t length, uint64_t user_data);
+int curing_prep_send(struct curing_ring *ring, int fd, const void *buffer, size_t length, int flags, uint64_t user_data);
+int curing_prep_close(struct curing_ring *ring, int fd, uint64_t user_data);
+int curing_prep_cancel(struct curing_ring *ring, uint64_t target, uint64_t user_data);
+
+/* Number of queued submissions not yet handed to the kernel. */
+unsigned curing_pending(const struct curing_ring *ring);
+
+/* Hand every queued submission to the kernel in one syscall. Returns the
+ * number submitted or -1 with errno set. */
+int curing_submit(struct curing_ring *ring);
+
+/* Hand every queued submission to the kernel and block the thread until at
+ * least one completion is pending. Returns 0 on success or -1 with errno set. */
+int curing_wait(struct curing_ring *ring);
+
+/* Pop one completion. Returns 1 if one was available, 0 otherwise. */
+int curing_peek(struct curing_ring *ring, uint64_t *user_data, int32_t *result, uint32_t *flags);
+
+/* Whether the kernel will post further completions for a multishot request. */
+int curing_has_more(uint32_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,113 @@
+#include "czlib.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <zlib.h>
+
+struct czlib_stream {
+    z_stream z;
+};
+
+struct czlib_stream *czlib_deflate_create(int format, int level) {
+    struct czlib_stream *stream = calloc(1, sizeof(struct czlib_stream));
+    int window_bits = format == CZLIB_GZIP ? MAX_WBITS + 16 : format == CZLIB_RAW ? -MAX_WBITS : MAX_WBITS;
+    if (!stream) return NULL;
+    if (deflateInit2(&stream->z, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+int czlib_deflate_reset(struct czlib_stream *stream) {
+    return deflateReset(&stream->z) == Z_OK ? CZLIB_OK : CZLIB_ERROR;
+}
+
+static int czlib_flush_mode(int flush) {
+    switch (flush) {
+    case CZLIB_SYNC_FLUSH: return Z_SYNC_FLUSH;
+    case CZLIB_FINISH: return Z_FINISH;
+    default: return Z_NO_FLUSH;
+    }
+}
+
+int czlib_deflate(struct czlib_stream *stream, const void *input, size_t input_length, size_t *consumed,
+                  void *output, size_t output_length, size_t *produced, int flush) {
+    uInt available_in = input_length > UINT_MAX ? UINT_MAX : (uInt) input_length;
+    uInt available_out = output_length > UINT_MAX ? UINT_MAX : (uInt) output_length;
+    int result;
+
+    stream->z.next_in = (Bytef *) input;
+    stream->z.avail_in = available_in;
+    stream->z.next_out = (Bytef *) output;
+    stream->z.avail_out = available_out;
+
+    result = deflate(&stream->z, czlib_flush_mode(flush));
+
+    *consumed = available_in - stream->z.avail_in;
+    *produced = available_out - stream->z.avail_out;
+
+    switch (result) {
+    case Z_STREAM_END: return CZLIB_STREAM_END;
+    case Z_OK:
+    case Z_BUF_ERROR: return CZLIB_OK;
+    default: return CZLIB_ERROR;
+    }
+}
+
+void czlib_deflate_destroy(struct czlib_stream *stream) {
+    if (!stream) return;
+    deflateEnd(&stream->z);
+    free(stream);
+}
+
+struct czlib_stream *czlib_inflate_create(int format) {
+    struct czlib_stream *stream = calloc(1, sizeof(struct czlib_stream));
+    int window_bits;
+    switch (format) {
+    case CZLIB_GZIP: window_bits = MAX_WBITS + 16; break;
+    case CZLIB_AUTO: window_bits = MAX_WBITS + 32; break;
+    case CZLIB_RAW: window_bits = -MAX_WBITS; break;
+    default: window_bits = MAX_WBITS; break;
+    }
+    if (!stream) return NULL;
+    if (inflateInit2(&stream->z, window_bits) != Z_OK) {
+        free(stream);
+        return NULL;
+    }
+    return stream;
+}
+
+int czlib_inflate_reset(struct czlib_stream *stream) {
+    return inflateReset(&stream->z) == Z_OK ? CZLIB_OK : CZLIB_ERROR;
+}
+
+int czlib_inflate(struct czlib_stream *stream, const void *input, size_t input_length, size_t *consumed,
+                  void *output, size_t output_length, size_t *produced) {
+    uInt available_in = input_length > UINT_MAX ? UINT_MAX : (uInt) input_length;
+    uInt available_out = output_length > UINT_MAX ? UINT_MAX : (uInt) output_length;
+    int result;
+
+    stream->z.next_in = (Bytef *) input;
+    stream->z.avail_in = available_in;
+    stream->z.next_out = (Bytef *) output;
+    stream->z.avail_out = available_out;
+
+    result = inflate(&stream->z, Z_NO_FLUSH);
+
+    *consumed = available_in - stream->z.avail_in;
+    *produced = available_out - stream->z.avail_out;
+
+    switch (result) {
+    case Z_STREAM_END: return CZLIB_STREAM_END;
+    case Z_OK:
+    case Z_BUF_ERROR: return CZLIB_OK;
+    default: return CZLIB_ERROR;
+    }
+}
+
+void czlib_inflate_destroy(struct czlib_stream *stream) {
+    if (!stream) return;
+    inflateEnd(&stream->z);
+    free(stream);
+}
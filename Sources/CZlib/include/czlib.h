@@ -0,0 +1,61 @@
+#ifndef czlib_h
+#define czlib_h
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/* Opaque wrapper over a zlib stream. zlib's init functions are macros and
+ * z_stream is awkward to drive from Swift, so everything goes through here. */
+
+struct czlib_stream;
+
+/* Formats */
+#define CZLIB_DEFLATE 0 /* zlib wrapper, the "deflate" content coding */
+#define CZLIB_GZIP 1    /* gzip wrapper, the "gzip" content coding */
+#define CZLIB_AUTO 2    /* zlib or gzip wrapper, detected from the header; inflate only */
+#define CZLIB_RAW 3     /* no wrapper, as used by WebSocket permessage-deflate */
+
+/* Flush modes */
+#define CZLIB_NO_FLUSH 0
+#define CZLIB_SYNC_FLUSH 1
+#define CZLIB_FINISH 2
+
+/* Results */
+#define CZLIB_OK 0         /* made progress, call again with more input or output */
+#define CZLIB_STREAM_END 1 /* the stream is complete */
+#define CZLIB_ERROR -1
+
+/* Creates a compressor; `level` ranges from 0 to 9, or -1 for the default. */
+struct czlib_stream *czlib_deflate_create(int format, int level);
+
+/* Prepares a compressor for a new stream, keeping its allocations. */
+int czlib_deflate_reset(struct czlib_stream *stream);
+
+/* Compresses `input`, reporting how much input was consumed and how much
+ * output was produced. Once `flush` is CZLIB_FINISH and all input has been
+ * consumed, call until CZLIB_STREAM_END is returned. */
+int czlib_deflate(struct czlib_stream *stream, const void *input, size_t input_length, size_t *consumed,
+                  void *output, size_t output_length, size_t *produced, int flush);
+
+void czlib_deflate_destroy(struct czlib_stream *stream);
+
+/* Creates a decompressor for `format`. */
+struct czlib_stream *czlib_inflate_create(int format);
+
+/* Prepares a decompressor for a new stream, keeping its allocations. */
+int czlib_inflate_reset(struct czlib_stream *stream);
+
+/* Decompresses `input` like czlib_deflate. Returns CZLIB_STREAM_END once
+ * the end of the compressed stream has been decoded and CZLIB_ERROR for
+ * corrupt input. */
+int czlib_inflate(struct czlib_stream *stream, const void *input, size_t input_length, size_t *consumed,
+                  void *output, size_t output_length, size_t *produced);
+
+void czlib_inflate_destroy(struct czlib_stream *stream);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
@@ -0,0 +1,244 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import CSystem
+
+/// Writes events to a file descriptor from a thread of its own.
+///
+/// Logging describes the message and error on the calling thread, so the
+/// queue never holds on to the values logged, and pushes the resulting
+/// strings onto a bounded lock-free queue. The appender's thread formats
+/// queued events into a buffer and writes it once it is full or the queue
+/// runs dry, so a slow pipe holds up no one but that thread. Output is the
+/// same as `StandardOutputAppender`'s.
+public final class AsyncLogAppender : LogAppender {
+    public enum OverflowPolicy {
+        /// Drops events logged while the queue is full
+        case drop
+        /// Waits for the queue to have room
+        case block
+    }
+
+    /// Appender for standard output, flushed when the process exits.
+    public static let standardOutput: AsyncLogAppender = {
+        let appender = AsyncLogAppender(descriptor: STDOUT_FILENO)
+        atexit { AsyncLogAppender.standardOutput.flush() }
+        return appender
+    }()
+
+    public let levels: Logger.Level
+    public let descriptor: Int32
+    public let overflowPolicy: OverflowPolicy
+
+    /// Bytes formatted before they are written
+    public let bufferSize: Int
+
+    /// What is left of an event once described.
+    private final class Record {
+        let level: Logger.Level
+        let timestamp: Int
+        let locationInfo: Logger.LocationInfo
+        let message: String?
+        let error: String?
+
+        init(event: Logger.Event) {
+            self.level = event.level
+            self.timestamp = event.timestamp
+            self.locationInfo = event.locationInfo
+            self.message = event.message.map({ $0 as? String ?? String(describing: $0) })
+            self.error = event.error.map({ String(describing: $0) })
+        }
+    }
+
+    private let queue: OpaquePointer
+    private let dropped: Counter?
+    private var thread: OpaquePointer?
+    private var stopped = false
+
+    /// Creates an appender writing to `descriptor` with a queue of
+    /// `capacity` events, counting those dropped in `metrics`.
+    public init(
+        levels: Logger.Level = .all,
+        descriptor: Int32 = STDOUT_FILENO,
+        capacity: Int = 8192,
+        overflowPolicy: OverflowPolicy = .drop,
+        bufferSize: Int = 64 * 1024,
+        metrics: MetricsRegistry? = .default
+    ) {
+        self.levels = levels
+        self.descriptor = descriptor
+        self.overflowPolicy = overflowPolicy
+        self.bufferSize = bufferSize
+        self.queue = csystem_queue_create(capacity)!
+
+        dropped = metrics?.counter(
+            "log_events_dropped_total",
+            help: "Log events dropped because the appender's queue was full."
+        )
+
+        let context = Unmanaged.passRetained(self).toOpaque()
+
+        thread = csystem_thread_start({ context in
+            Unmanaged<AsyncLogAppender>.fromOpaque(context!).takeRetainedValue().run()
+        }, context)
+
+        // Events are dropped rather than queued for no one.
+        if thread == nil {
+            Unmanaged<AsyncLogAppender>.fromOpaque(context).release()
+            stopped = true
+        }
+    }
+
+    deinit {
+        csystem_queue_destroy(queue)
+    }
+
+    /// Events dropped by this appender so far.
+    public var droppedEvents: Int {
+        return Int(csystem_queue_dropped(queue))
+    }
+
+    public func append(event: Logger.Event) {
+        guard !stopped else {
+            return drop()
+        }
+
+        let record = Unmanaged.passRetained(Record(event: event)).toOpaque()
+
+        while csystem_queue_push(queue, record) == 0 {
+            guard overflowPolicy == .block else {
+                Unmanaged<Record>.fromOpaque(record).release()
+                return drop()
+            }
+
+            sched_yield()
+        }
+
+        if event.level == .fatal {
+            flush()
+        }
+    }
+
+    /// Waits for the events appended so far to be written.
+    public func flush() {
+        let pushed = csystem_queue_pushed(queue)
+
+        while !stopped, csystem_queue_done(queue) < pushed {
+            var pause = timespec(tv_sec: 0, tv_nsec: 100_000)
+            nanosleep(&pause, nil)
+        }
+    }
+
+    /// Writes the events appended so far and stops the appender's thread.
+    /// Events appended afterwards are dropped.
+    public func close() {
+        guard !stopped, let thread = thread else {
+            return
+        }
+
+        flush()
+        stopped = true
+        csystem_thread_join(thread)
+        self.thread = nil
+    }
+
+    private func drop() {
+        csystem_queue_drop(queue)
+        dropped?.increment()
+    }
+
+    private func run() {
+        var buffer: [UInt8] = []
+        buffer.reserveCapacity(bufferSize + 1024)
+        var done: UInt64 = 0
+
+        while true {
+            guard let item = csystem_queue_pop(queue) else {
+                output(&buffer)
+                csystem_queue_set_done(queue, done)
+
+                if stopped {
+                    return
+                }
+
+                csystem_queue_wait(queue, 100_000_000)
+                continue
+            }
+
+            let record = Unmanaged<Record>.fromOpaque(item).takeRetainedValue()
+            format(record, into: &buffer)
+            done += 1
+
+            if buffer.count >= bufferSize {
+                output(&buffer)
+                csystem_queue_set_done(queue, done)
+            }
+        }
+    }
+
+    private func format(_ record: Record, into buffer: inout [UInt8]) {
+        let level = record.level.description
+
+        if !level.isEmpty {
+            buffer.append(UInt8(ascii: "["))
+            buffer.append(contentsOf: level.utf8)
+            buffer.append(UInt8(ascii: "]"))
+        }
+
+        buffer.append(UInt8(ascii: "["))
+        buffer.append(contentsOf: String(record.timestamp).utf8)
+        buffer.append(contentsOf: "][".utf8)
+        buffer.append(contentsOf: record.locationInfo.file.utf8)
+        buffer.append(UInt8(ascii: ":"))
+        buffer.append(contentsOf: record.locationInfo.function.utf8)
+        buffer.append(UInt8(ascii: ":"))
+        buffer.append(contentsOf: String(record.locationInfo.line).utf8)
+        buffer.append(UInt8(ascii: ":"))
+        buffer.append(contentsOf: String(record.locationInfo.column).utf8)
+        buffer.append(UInt8(ascii: "]"))
+
+        if let message = record.message {
+            buffer.append(UInt8(ascii: ":"))
+            buffer.append(contentsOf: message.utf8)
+        }
+
+        if let error = record.error {
+            buffer.append(UInt8(ascii: ":"))
+            buffer.append(contentsOf: error.utf8)
+        }
+
+        buffer.append(UInt8(ascii: "\n"))
+    }
+
+    /// Writes and empties `buffer`, dropping what cannot be written.
+    private func output(_ buffer: inout [UInt8]) {
+        var written = 0
+
+        while written < buffer.count {
+            let result = buffer.withUnsafeBytes({
+                write(descriptor, $0.baseAddress! + written, $0.count - written)
+            })
+
+            guard result != -1 else {
+                switch errno {
+                case EINTR:
+                    continue
+                case EAGAIN, EWOULDBLOCK:
+                    var writable = pollfd(fd: descriptor, events: Int16(POLLOUT), revents: 0)
+                    poll(&writable, 1, 100)
+                    continue
+                default:
+                    buffer.removeAll(keepingCapacity: true)
+                    return
+                }
+            }
+
+            written += result
+        }
+
+        buffer.removeAll(keepingCapacity: true)
+    }
+}
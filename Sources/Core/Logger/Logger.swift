@@ -54,7 +54,7 @@ public struct Logger {
         }
     }
 
-    public static var appenders: [LogAppender] = [StandardOutputAppender()]
+    public static var appenders: [LogAppender] = [AsyncLogAppender.standardOutput]
     
     private static func log(level: Level, item: Any?, error: Error? = nil, locationInfo: LocationInfo) {
         let (ts, usec) = getTimestamp()
@@ -0,0 +1,117 @@
+import Venice
+
+public enum MemoryError : Error {
+    case budgetExceeded(budget: Int)
+}
+
+extension MemoryError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case let .budgetExceeded(budget):
+            return "The memory budget of \(budget) bytes was exceeded."
+        }
+    }
+}
+
+/// Bytes attributed to an owner, such as a connection or a request.
+///
+/// Charges add up through `parent`, so a request's memory also counts
+/// against its connection and the connection's against its server. The
+/// figures are what the charging code estimates it holds, not what the
+/// allocator hands out. Accounts belong to the thread that charges them.
+public final class MemoryAccount {
+    public struct Statistics {
+        /// Bytes charged now
+        public let current: Int
+
+        /// Most bytes charged at once
+        public let peak: Int
+
+        public let budget: Int?
+    }
+
+    public let parent: MemoryAccount?
+
+    /// Charges that take `current` past this fail.
+    public let budget: Int?
+
+    public private(set) var current = 0
+    public private(set) var peak = 0
+
+    /// Whether a charge ever went over `budget`.
+    public private(set) var exceeded = false
+
+    /// Set by `releaseAll`.
+    public private(set) var isClosed = false
+
+    public init(budget: Int? = nil, parent: MemoryAccount? = nil) {
+        self.budget = budget
+        self.parent = parent
+    }
+
+    public var statistics: Statistics {
+        return Statistics(current: current, peak: peak, budget: budget)
+    }
+
+    /// Adds `bytes` to this account and its ancestors, up to the first
+    /// closed one. Throws `MemoryError.budgetExceeded` if that takes any of
+    /// them over budget; the bytes stay charged either way, so `release`
+    /// still balances.
+    public func charge(_ bytes: Int) throws {
+        var failure: MemoryError?
+        var next: MemoryAccount? = self
+
+        while let account = next, !account.isClosed {
+            account.current += bytes
+            account.peak = max(account.peak, account.current)
+
+            if let budget = account.budget, account.current > budget {
+                account.exceeded = true
+                failure = failure ?? .budgetExceeded(budget: budget)
+            }
+
+            next = account.parent
+        }
+
+        if let failure = failure {
+            throw failure
+        }
+    }
+
+    public func release(_ bytes: Int) {
+        var next: MemoryAccount? = self
+
+        while let account = next, !account.isClosed {
+            account.current -= bytes
+            next = account.parent
+        }
+    }
+
+    /// Releases whatever is still charged and closes the account, once its
+    /// owner is gone. Buffers that outlive the owner may still release what
+    /// they were charged; that stops at the closed account, which already
+    /// gave it back.
+    public func releaseAll() {
+        release(current)
+        isClosed = true
+    }
+}
+
+/// Tells whoever builds values out of `source`'s bytes, such as the JSON
+/// parser, which account to charge them to.
+public final class AccountedReadable : Readable {
+    public let source: Readable
+    public let account: MemoryAccount
+
+    public init(_ source: Readable, account: MemoryAccount) {
+        self.source = source
+        self.account = account
+    }
+
+    public func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        return try source.read(buffer, deadline: deadline)
+    }
+}
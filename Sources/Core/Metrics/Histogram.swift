@@ -0,0 +1,117 @@
+/// Distribution of recorded values, such as latencies in nanoseconds.
+///
+/// Values are counted in log-linear buckets in the manner of an HDR
+/// histogram: exact below 128 and within 1/64 of the value above, up to
+/// `maximumValue`. Larger values count as `maximumValue`, negative ones as
+/// zero. Recording increments two integers of the thread's shard.
+public struct Histogram {
+    /// Latency bounds, in seconds, exported by default
+    public static let defaultBuckets: [Double] = [
+        0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10,
+    ]
+
+    /// Largest value told apart, about 18 minutes in nanoseconds
+    public static let maximumValue = (1 << 40) - 1
+
+    private static let subBucketBits = 6
+    private static let subBucketCount = 1 << subBucketBits
+
+    internal static let bucketCount = index(of: maximumValue) + 1
+
+    /// The buckets followed by the sum of the values
+    internal static let slotCount = bucketCount + 1
+
+    internal let registry: MetricsRegistry
+    internal let slot: Int
+
+    @inline(__always)
+    public func record(_ value: Int) {
+        let values = registry.slot(slot)
+        values[Histogram.index(of: value)] &+= 1
+        values[Histogram.bucketCount] &+= value
+    }
+
+    /// Records the nanoseconds since `start`, a `MonotonicClock.now()`.
+    @inline(__always)
+    public func record(since start: Int) {
+        record(MonotonicClock.now() - start)
+    }
+
+    /// Merges the values recorded by all threads.
+    public var snapshot: Snapshot {
+        let sums = registry.sums(slot, count: Histogram.slotCount)
+        return Snapshot(buckets: Array(sums.dropLast()), sum: sums[Histogram.bucketCount])
+    }
+
+    @inline(__always)
+    internal static func index(of value: Int) -> Int {
+        let value = min(max(value, 0), maximumValue)
+
+        guard value >= 2 * subBucketCount else {
+            return value
+        }
+
+        let shift = Int.bitWidth - value.leadingZeroBitCount - 1 - subBucketBits
+        return shift * subBucketCount + (value >> shift)
+    }
+
+    /// Values in bucket `index`.
+    internal static func range(of index: Int) -> ClosedRange<Int> {
+        guard index >= 2 * subBucketCount else {
+            return index ... index
+        }
+
+        let shift = index / subBucketCount - 1
+        let base = index - shift * subBucketCount
+        return base << shift ... ((base + 1) << shift) - 1
+    }
+
+    public struct Snapshot {
+        internal let buckets: [Int]
+
+        /// Sum of the values recorded
+        public let sum: Int
+
+        /// Number of values recorded
+        public let count: Int
+
+        internal init(buckets: [Int], sum: Int) {
+            self.buckets = buckets
+            self.sum = sum
+            self.count = buckets.reduce(0, +)
+        }
+
+        /// Values up to `value` recorded, counting a bucket only if all of
+        /// it is at or below `value`.
+        public func count(atOrBelow value: Int) -> Int {
+            var count = 0
+
+            for (index, bucketCount) in buckets.enumerated() {
+                guard Histogram.range(of: index).upperBound <= value else {
+                    break
+                }
+
+                count += bucketCount
+            }
+
+            return count
+        }
+
+        /// The value `percentile` percent of the recorded values are at or
+        /// below, as the largest value of its bucket. Zero when empty.
+        public func value(atPercentile percentile: Double) -> Int {
+            let rank = Int((Double(count) * min(max(percentile, 0), 100) / 100).rounded(.up))
+            var seen = 0
+
+            for (index, bucketCount) in buckets.enumerated() where bucketCount > 0 {
+                seen += bucketCount
+
+                if seen >= max(rank, 1) {
+                    return Histogram.range(of: index).upperBound
+                }
+            }
+
+            return 0
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+/// Counters, gauges and histograms cheap enough to update on every request.
+///
+/// Every thread updates a shard of its own, found through a thread-specific
+/// key, so an update is a plain addition without locks or atomics. Reading a
+/// metric merges the shards of all threads under the registry lock, which
+/// registering a metric and a thread's first update also take. A read may
+/// miss updates in flight on other threads; the next one sees them. Shards
+/// outlive their threads so no counts are lost.
+public final class MetricsRegistry {
+    /// Registry `Server` and `Client` report to
+    public static let `default` = MetricsRegistry()
+
+    internal enum Kind {
+        case counter
+        case gauge
+        case histogram(scale: Double, buckets: [Double])
+    }
+
+    internal struct Metric {
+        let name: String
+        let help: String
+        let kind: Kind
+        let labels: [(String, String)]
+        let slot: Int
+    }
+
+    internal static let pageShift = 12
+    internal static let pageSize = 1 << pageShift
+    private static let pageCount = 1024
+
+    private typealias Page = UnsafeMutablePointer<Int>
+    private typealias Table = UnsafeMutablePointer<Page?>
+
+    private var key = pthread_key_t()
+    private let mutex: UnsafeMutablePointer<pthread_mutex_t>
+    private var tables: [Table] = []
+    private var slotCount = 0
+    private var indices: [String: Int] = [:]
+    private var metrics: [Metric] = []
+
+    public init() {
+        mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+        pthread_mutex_init(mutex, nil)
+        pthread_key_create(&key, nil)
+    }
+
+    deinit {
+        pthread_key_delete(key)
+
+        for table in tables {
+            for index in 0 ..< MetricsRegistry.pageCount {
+                table[index]?.deallocate()
+            }
+
+            table.deallocate()
+        }
+
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    public func counter(_ name: String, help: String = "", labels: [String: String] = [:]) -> Counter {
+        return Counter(registry: self, slot: register(name, help: help, kind: .counter, labels: labels, slots: 1))
+    }
+
+    public func gauge(_ name: String, help: String = "", labels: [String: String] = [:]) -> Gauge {
+        return Gauge(registry: self, slot: register(name, help: help, kind: .gauge, labels: labels, slots: 1))
+    }
+
+    /// Values are recorded as integers, such as nanoseconds, and exported
+    /// multiplied by `scale`, such as `1e-9` for seconds, into `buckets`,
+    /// the upper bounds in the exported unit.
+    public func histogram(
+        _ name: String,
+        help: String = "",
+        labels: [String: String] = [:],
+        scale: Double = 1e-9,
+        buckets: [Double] = Histogram.defaultBuckets
+    ) -> Histogram {
+        let slot = register(
+            name,
+            help: help,
+            kind: .histogram(scale: scale, buckets: buckets.sorted()),
+            labels: labels,
+            slots: Histogram.slotCount
+        )
+
+        return Histogram(registry: self, slot: slot)
+    }
+
+    /// Returns the slot of the metric, registering it first if needed. The
+    /// slots of a metric never straddle pages.
+    private func register(
+        _ name: String,
+        help: String,
+        kind: Kind,
+        labels: [String: String],
+        slots: Int
+    ) -> Int {
+        let labels = labels.sorted(by: { $0.key < $1.key }).map({ ($0.key, $0.value) })
+        let identifier = name + "{" + labels.map({ $0.0 + "=" + $0.1 }).joined(separator: ",") + "}"
+
+        return withLock { () -> Int in
+            if let index = indices[identifier] {
+                return metrics[index].slot
+            }
+
+            if (slotCount & (MetricsRegistry.pageSize - 1)) + slots > MetricsRegistry.pageSize {
+                slotCount = (slotCount | (MetricsRegistry.pageSize - 1)) + 1
+            }
+
+            precondition(
+                slotCount + slots <= MetricsRegistry.pageSize * MetricsRegistry.pageCount,
+                "Too many metrics"
+            )
+
+            let slot = slotCount
+            slotCount += slots
+
+            indices[identifier] = metrics.count
+            metrics.append(Metric(name: name, help: help, kind: kind, labels: labels, slot: slot))
+            return slot
+        }
+    }
+
+    /// Every metric registered so far, in registration order.
+    internal var registeredMetrics: [Metric] {
+        return withLock {
+            metrics
+        }
+    }
+
+    /// The calling thread's copy of `slot`.
+    @inline(__always)
+    internal func slot(_ slot: Int) -> UnsafeMutablePointer<Int> {
+        let table: Table
+
+        if let specific = pthread_getspecific(key) {
+            table = specific.assumingMemoryBound(to: Page?.self)
+        } else {
+            table = makeTable()
+        }
+
+        guard let page = table[slot >> MetricsRegistry.pageShift] else {
+            return makePage(in: table, for: slot)
+        }
+
+        return page + (slot & (MetricsRegistry.pageSize - 1))
+    }
+
+    /// The sums of `count` slots from `slot` across all threads.
+    internal func sums(_ slot: Int, count: Int = 1) -> [Int] {
+        var sums = [Int](repeating: 0, count: count)
+
+        withLock {
+            for table in tables {
+                guard let page = table[slot >> MetricsRegistry.pageShift] else {
+                    continue
+                }
+
+                let values = page + (slot & (MetricsRegistry.pageSize - 1))
+
+                for index in 0 ..< count {
+                    sums[index] += values[index]
+                }
+            }
+        }
+
+        return sums
+    }
+
+    private func makeTable() -> Table {
+        let table = Table.allocate(capacity: MetricsRegistry.pageCount)
+        table.initialize(repeating: nil, count: MetricsRegistry.pageCount)
+
+        withLock {
+            tables.append(table)
+        }
+
+        pthread_setspecific(key, table)
+        return table
+    }
+
+    private func makePage(in table: Table, for slot: Int) -> UnsafeMutablePointer<Int> {
+        let page = Page.allocate(capacity: MetricsRegistry.pageSize)
+        page.initialize(repeating: 0, count: MetricsRegistry.pageSize)
+
+        withLock {
+            table[slot >> MetricsRegistry.pageShift] = page
+        }
+
+        return page + (slot & (MetricsRegistry.pageSize - 1))
+    }
+
+    @discardableResult
+    private func withLock<T>(_ body: () throws -> T) rethrows -> T {
+        pthread_mutex_lock(mutex)
+
+        defer {
+            pthread_mutex_unlock(mutex)
+        }
+
+        return try body()
+    }
+}
+
+/// Count that only goes up, such as requests served.
+public struct Counter {
+    internal let registry: MetricsRegistry
+    internal let slot: Int
+
+    @inline(__always)
+    public func increment(by amount: Int = 1) {
+        registry.slot(slot).pointee &+= amount
+    }
+
+    /// Sum over all threads
+    public var value: Int {
+        return registry.sums(slot)[0]
+    }
+}
+
+/// Count that goes up and down, such as open connections.
+public struct Gauge {
+    internal let registry: MetricsRegistry
+    internal let slot: Int
+
+    @inline(__always)
+    public func increment(by amount: Int = 1) {
+        registry.slot(slot).pointee &+= amount
+    }
+
+    @inline(__always)
+    public func decrement(by amount: Int = 1) {
+        registry.slot(slot).pointee &-= amount
+    }
+
+    /// Sum over all threads
+    public var value: Int {
+        return registry.sums(slot)[0]
+    }
+}
@@ -0,0 +1,16 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+/// Time for measuring durations, unaffected by changes to the wall clock.
+public enum MonotonicClock {
+    /// Nanoseconds since an arbitrary point in the past
+    @inline(__always)
+    public static func now() -> Int {
+        var time = timespec()
+        clock_gettime(CLOCK_MONOTONIC, &time)
+        return time.tv_sec * 1_000_000_000 + time.tv_nsec
+    }
+}
@@ -0,0 +1,88 @@
+extension MetricsRegistry {
+    /// Content type of `prometheusExposition()`
+    public static let prometheusContentType = "text/plain; version=0.0.4; charset=utf-8"
+
+    /// Every metric in the Prometheus text exposition format.
+    public func prometheusExposition() -> String {
+        var families: [String: [Metric]] = [:]
+        var names: [String] = []
+
+        for metric in registeredMetrics {
+            if families[metric.name] == nil {
+                names.append(metric.name)
+            }
+
+            families[metric.name, default: []].append(metric)
+        }
+
+        var output = ""
+
+        for name in names {
+            let family = families[name]!
+            let first = family[0]
+
+            if !first.help.isEmpty {
+                output += "# HELP " + name + " " + escape(first.help, quoted: false) + "\n"
+            }
+
+            switch first.kind {
+            case .counter:
+                output += "# TYPE " + name + " counter\n"
+            case .gauge:
+                output += "# TYPE " + name + " gauge\n"
+            case .histogram:
+                output += "# TYPE " + name + " histogram\n"
+            }
+
+            for metric in family {
+                switch metric.kind {
+                case .counter, .gauge:
+                    output += name + labels(metric.labels) + " " + String(sums(metric.slot)[0]) + "\n"
+                case let .histogram(scale, buckets):
+                    let snapshot = Histogram(registry: self, slot: metric.slot).snapshot
+
+                    for bucket in buckets {
+                        let bound = min((bucket / scale).rounded(), Double(Histogram.maximumValue))
+                        let count = snapshot.count(atOrBelow: Int(bound))
+                        let le = labels(metric.labels + [("le", String(bucket))])
+                        output += name + "_bucket" + le + " " + String(count) + "\n"
+                    }
+
+                    let le = labels(metric.labels + [("le", "+Inf")])
+                    output += name + "_bucket" + le + " " + String(snapshot.count) + "\n"
+                    output += name + "_sum" + labels(metric.labels) + " " + String(Double(snapshot.sum) * scale) + "\n"
+                    output += name + "_count" + labels(metric.labels) + " " + String(snapshot.count) + "\n"
+                }
+            }
+        }
+
+        return output
+    }
+
+    private func labels(_ labels: [(String, String)]) -> String {
+        guard !labels.isEmpty else {
+            return ""
+        }
+
+        return "{" + labels.map({ $0.0 + "=\"" + escape($0.1, quoted: true) + "\"" }).joined(separator: ",") + "}"
+    }
+
+    private func escape(_ string: String, quoted: Bool) -> String {
+        var escaped = ""
+
+        for character in string {
+            switch character {
+            case "\\":
+                escaped += "\\\\"
+            case "\n":
+                escaped += "\\n"
+            case "\"" where quoted:
+                escaped += "\\\""
+            default:
+                escaped.append(character)
+            }
+        }
+
+        return escaped
+    }
+}
@@ -7,7 +7,8 @@
 import Venice
 
 public final class ReadableBuffer : Readable {
-    var buffer: UnsafeRawBufferPointer
+    /// Bytes not read yet.
+    public private(set) var buffer: UnsafeRawBufferPointer
     
     public init(_ buffer: UnsafeRawBufferPointer) {
         self.buffer = buffer
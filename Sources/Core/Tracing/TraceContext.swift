@@ -0,0 +1,57 @@
+/// Identifies a span within a distributed trace, as carried by the W3C
+/// `traceparent` header.
+public struct TraceContext {
+    public let traceID: (high: UInt64, low: UInt64)
+    public let spanID: UInt64
+    /// Whether the caller records the trace, so callees should too
+    public let sampled: Bool
+
+    public init(traceID: (high: UInt64, low: UInt64), spanID: UInt64, sampled: Bool) {
+        self.traceID = traceID
+        self.spanID = spanID
+        self.sampled = sampled
+    }
+
+    /// Parses a version `00` header value. Returns `nil` if it is malformed
+    /// or has an all-zero trace or span ID.
+    public init?(traceparent: String) {
+        let fields = traceparent.split(separator: "-", omittingEmptySubsequences: false)
+
+        guard
+            fields.count >= 4,
+            fields[0].count == 2, fields[0] != "ff",
+            fields[1].count == 32, fields[2].count == 16, fields[3].count == 2,
+            let high = UInt64(fields[1].prefix(16), radix: 16),
+            let low = UInt64(fields[1].suffix(16), radix: 16),
+            let spanID = UInt64(fields[2], radix: 16),
+            let flags = UInt8(fields[3], radix: 16),
+            high != 0 || low != 0,
+            spanID != 0
+        else {
+            return nil
+        }
+
+        self.init(traceID: (high, low), spanID: spanID, sampled: flags & 1 == 1)
+    }
+
+    /// The value of a `traceparent` header naming this span.
+    public var traceparent: String {
+        return "00-" + hex(traceID.high) + hex(traceID.low) + "-" + hex(spanID) + (sampled ? "-01" : "-00")
+    }
+
+    /// Trace ID as 32 lowercase hex digits
+    public var traceIDString: String {
+        return hex(traceID.high) + hex(traceID.low)
+    }
+
+    /// A context for a span called from this one, in the same trace.
+    public func child(spanID: UInt64) -> TraceContext {
+        return TraceContext(traceID: traceID, spanID: spanID, sampled: sampled)
+    }
+}
+
+/// `value` as 16 lowercase hex digits.
+internal func hex(_ value: UInt64) -> String {
+    let digits = String(value, radix: 16)
+    return String(repeating: "0", count: 16 - digits.count) + digits
+}
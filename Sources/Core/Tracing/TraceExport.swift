@@ -0,0 +1,199 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+extension TraceRecorder {
+    public enum Format {
+        /// Chrome trace-event JSON, for `chrome://tracing` and Perfetto
+        case chromeTrace
+        /// OTLP/JSON `ExportTraceServiceRequest`, for OpenTelemetry collectors
+        case openTelemetry(serviceName: String)
+    }
+
+    /// The traces kept so far in `format`.
+    public func export(_ format: Format) -> String {
+        switch format {
+        case .chromeTrace:
+            return chromeTrace(traces)
+        case let .openTelemetry(serviceName):
+            return openTelemetry(traces, serviceName: serviceName)
+        }
+    }
+
+    /// Writes the traces kept so far in `format` to the file at `path`,
+    /// replacing it.
+    public func export(_ format: Format, to path: String) throws {
+        let descriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0o644)
+
+        guard descriptor != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        defer {
+            close(descriptor)
+        }
+
+        let bytes = Array(export(format).utf8)
+        var written = 0
+
+        while written < bytes.count {
+            let result = bytes.withUnsafeBytes({ write(descriptor, $0.baseAddress! + written, $0.count - written) })
+
+            guard result != -1 else {
+                switch errno {
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            written += result
+        }
+    }
+
+    private func chromeTrace(_ traces: [Trace]) -> String {
+        var events: [String] = []
+
+        for trace in traces {
+            let arguments = [("trace_id", trace.context.traceIDString)] + trace.attributes
+            events.append(chromeEvent(trace.name, start: trace.start, end: trace.end, thread: trace.thread, arguments: arguments))
+
+            for span in trace.spans {
+                events.append(chromeEvent(span.phase.name, start: span.start, end: span.end, thread: trace.thread, arguments: []))
+            }
+        }
+
+        return "{\"traceEvents\":[" + events.joined(separator: ",") + "],\"displayTimeUnit\":\"ms\"}"
+    }
+
+    private func chromeEvent(_ name: String, start: Int, end: Int, thread: Int, arguments: [(String, String)]) -> String {
+        var event = "{\"name\":" + quote(name) + ",\"cat\":\"http\",\"ph\":\"X\""
+        event += ",\"ts\":" + microseconds(start + wallClockOffset)
+        event += ",\"dur\":" + microseconds(end - start)
+        event += ",\"pid\":" + String(getpid()) + ",\"tid\":" + String(thread)
+        event += ",\"args\":{" + arguments.map({ quote($0.0) + ":" + quote($0.1) }).joined(separator: ",") + "}}"
+        return event
+    }
+
+    private func openTelemetry(_ traces: [Trace], serviceName: String) -> String {
+        var spans: [String] = []
+
+        for trace in traces {
+            let traceID = trace.context.traceIDString
+            let spanID = trace.context.spanID
+
+            spans.append(otlpSpan(
+                traceID: traceID,
+                spanID: spanID,
+                parentSpanID: trace.parentSpanID,
+                name: trace.name,
+                kind: 2,
+                start: trace.start,
+                end: trace.end,
+                attributes: trace.attributes
+            ))
+
+            for span in trace.spans {
+                spans.append(otlpSpan(
+                    traceID: traceID,
+                    spanID: spanID &+ UInt64(span.phase.rawValue + 1),
+                    parentSpanID: spanID,
+                    name: span.phase.name,
+                    kind: 1,
+                    start: span.start,
+                    end: span.end,
+                    attributes: []
+                ))
+            }
+        }
+
+        var json = "{\"resourceSpans\":[{\"resource\":{\"attributes\":["
+        json += otlpAttribute("service.name", serviceName)
+        json += "]},\"scopeSpans\":[{\"scope\":{\"name\":\"zewo\"},\"spans\":["
+        json += spans.joined(separator: ",")
+        json += "]}]}]}"
+        return json
+    }
+
+    private func otlpSpan(
+        traceID: String,
+        spanID: UInt64,
+        parentSpanID: UInt64?,
+        name: String,
+        kind: Int,
+        start: Int,
+        end: Int,
+        attributes: [(String, String)]
+    ) -> String {
+        var span = "{\"traceId\":\"" + traceID + "\",\"spanId\":\"" + hex(spanID) + "\""
+
+        if let parentSpanID = parentSpanID {
+            span += ",\"parentSpanId\":\"" + hex(parentSpanID) + "\""
+        }
+
+        span += ",\"name\":" + quote(name) + ",\"kind\":" + String(kind)
+        span += ",\"startTimeUnixNano\":\"" + String(start + wallClockOffset) + "\""
+        span += ",\"endTimeUnixNano\":\"" + String(end + wallClockOffset) + "\""
+        span += ",\"attributes\":[" + attributes.map({ otlpAttribute($0.0, $0.1) }).joined(separator: ",") + "]}"
+        return span
+    }
+
+    private func otlpAttribute(_ key: String, _ value: String) -> String {
+        return "{\"key\":" + quote(key) + ",\"value\":{\"stringValue\":" + quote(value) + "}}"
+    }
+
+    private func microseconds(_ nanoseconds: Int) -> String {
+        let remainder = nanoseconds % 1000
+        let fraction = String(remainder)
+        return String(nanoseconds / 1000) + "." + String(repeating: "0", count: 3 - fraction.count) + fraction
+    }
+
+    private func quote(_ string: String) -> String {
+        var quoted = "\""
+
+        for scalar in string.unicodeScalars {
+            switch scalar {
+            case "\"":
+                quoted += "\\\""
+            case "\\":
+                quoted += "\\\\"
+            case "\n":
+                quoted += "\\n"
+            case "\r":
+                quoted += "\\r"
+            case "\t":
+                quoted += "\\t"
+            case _ where scalar.value < 0x20:
+                let digits = String(scalar.value, radix: 16)
+                quoted += "\\u" + String(repeating: "0", count: 4 - digits.count) + digits
+            default:
+                quoted.unicodeScalars.append(scalar)
+            }
+        }
+
+        return quoted + "\""
+    }
+}
+
+extension Trace.Phase {
+    public var name: String {
+        switch self {
+        case .accept:
+            return "accept"
+        case .parse:
+            return "parse"
+        case .queue:
+            return "queue"
+        case .respond:
+            return "respond"
+        case .serialize:
+            return "serialize"
+        }
+    }
+}
@@ -0,0 +1,212 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+/// Phase timings of one request, kept if it was sampled or slow.
+public final class Trace {
+    public enum Phase : Int {
+        /// From accepting the connection to the first byte of its first request
+        case accept
+        /// From the first byte to the end of the headers
+        case parse
+        /// From the end of the headers to the respond closure being called
+        case queue
+        case respond
+        /// Writing and flushing the response
+        case serialize
+    }
+
+    public struct Span {
+        public let phase: Phase
+        public let start: Int
+        public let end: Int
+    }
+
+    public let context: TraceContext
+    /// Span of the caller, from its `traceparent`
+    public let parentSpanID: UInt64?
+    public var name: String
+    public var attributes: [(String, String)] = []
+    public private(set) var spans: [Span] = []
+
+    /// Set for the thread that recorded the trace
+    public internal(set) var thread = 0
+
+    internal init(context: TraceContext, parentSpanID: UInt64?, name: String) {
+        self.context = context
+        self.parentSpanID = parentSpanID
+        self.name = name
+        spans.reserveCapacity(5)
+    }
+
+    /// Records `phase` between two `MonotonicClock` times.
+    public func record(_ phase: Phase, from start: Int, to end: Int) {
+        spans.append(Span(phase: phase, start: start, end: end))
+    }
+
+    /// `MonotonicClock` time of the first span, or zero
+    public var start: Int {
+        return spans.map({ $0.start }).min() ?? 0
+    }
+
+    /// `MonotonicClock` time of the end of the last span, or zero
+    public var end: Int {
+        return spans.map({ $0.end }).max() ?? 0
+    }
+}
+
+/// Keeps the phase timings of sampled and slow requests for export.
+///
+/// Each thread writes the traces it finishes into a ring buffer of its own,
+/// overwriting the oldest once `capacity` are kept. Writing takes only the
+/// buffer's lock, which nothing but an export contends for. Requests that
+/// are neither sampled nor can be slow cost no more than a random number.
+public final class TraceRecorder {
+    /// Fraction of requests traced, from 0 to 1
+    public let sampleRate: Double
+
+    /// Requests taking at least this many nanoseconds are kept even when
+    /// not sampled, never when `nil`
+    public let slowThreshold: Int?
+
+    /// Traces kept per thread
+    public let capacity: Int
+
+    private final class Buffer {
+        let index: Int
+        let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+        var traces: [Trace?]
+        var next = 0
+        var random: UInt64
+
+        init(index: Int, capacity: Int) {
+            self.index = index
+            self.traces = [Trace?](repeating: nil, count: capacity)
+            self.random = UInt64.random(in: 1 ... .max)
+            pthread_mutex_init(mutex, nil)
+        }
+
+        deinit {
+            pthread_mutex_destroy(mutex)
+            mutex.deallocate()
+        }
+
+        /// xorshift64*, good enough for IDs and sampling
+        func nextRandom() -> UInt64 {
+            random ^= random >> 12
+            random ^= random << 25
+            random ^= random >> 27
+            return random &* 2685821657736338717
+        }
+
+        func withLock<T>(_ body: () throws -> T) rethrows -> T {
+            pthread_mutex_lock(mutex)
+
+            defer {
+                pthread_mutex_unlock(mutex)
+            }
+
+            return try body()
+        }
+    }
+
+    private var key = pthread_key_t()
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private var buffers: [Buffer] = []
+
+    /// Offset from `MonotonicClock` to Unix time, in nanoseconds
+    internal let wallClockOffset: Int
+
+    public init(sampleRate: Double = 0.01, slowThreshold: Int? = nil, capacity: Int = 1024) {
+        self.sampleRate = sampleRate
+        self.slowThreshold = slowThreshold
+        self.capacity = max(capacity, 1)
+
+        var time = timespec()
+        clock_gettime(CLOCK_REALTIME, &time)
+        wallClockOffset = time.tv_sec * 1_000_000_000 + time.tv_nsec - MonotonicClock.now()
+
+        pthread_mutex_init(mutex, nil)
+        pthread_key_create(&key, nil)
+    }
+
+    deinit {
+        pthread_key_delete(key)
+        pthread_mutex_destroy(mutex)
+        mutex.deallocate()
+    }
+
+    /// Starts a trace, continuing `parent` if given. Returns `nil` if the
+    /// request is neither sampled nor can be kept for being slow.
+    public func begin(name: String, parent: TraceContext? = nil) -> Trace? {
+        let buffer = threadBuffer()
+        let sampled = parent?.sampled ?? (Double(buffer.nextRandom() >> 11) / Double(1 << 53) < sampleRate)
+
+        guard sampled || slowThreshold != nil else {
+            return nil
+        }
+
+        let context = TraceContext(
+            traceID: parent?.traceID ?? (high: buffer.nextRandom(), low: buffer.nextRandom()),
+            spanID: buffer.nextRandom(),
+            sampled: sampled
+        )
+
+        return Trace(context: context, parentSpanID: parent?.spanID, name: name)
+    }
+
+    /// Keeps `trace` if it was sampled or took at least `slowThreshold`.
+    public func finish(_ trace: Trace) {
+        guard trace.context.sampled || slowThreshold.map({ trace.end - trace.start >= $0 }) == true else {
+            return
+        }
+
+        let buffer = threadBuffer()
+        trace.thread = buffer.index
+
+        buffer.withLock {
+            buffer.traces[buffer.next] = trace
+            buffer.next = (buffer.next + 1) % capacity
+        }
+    }
+
+    /// A new span ID, such as for an outgoing request.
+    public func makeSpanID() -> UInt64 {
+        return threadBuffer().nextRandom()
+    }
+
+    /// Every trace kept, oldest first per thread.
+    public var traces: [Trace] {
+        pthread_mutex_lock(mutex)
+        let buffers = self.buffers
+        pthread_mutex_unlock(mutex)
+
+        var traces: [Trace] = []
+
+        for buffer in buffers {
+            buffer.withLock {
+                let ordered = buffer.traces[buffer.next...] + buffer.traces[..<buffer.next]
+                traces.append(contentsOf: ordered.compactMap({ $0 }))
+            }
+        }
+
+        return traces
+    }
+
+    private func threadBuffer() -> Buffer {
+        if let specific = pthread_getspecific(key) {
+            return Unmanaged<Buffer>.fromOpaque(specific).takeUnretainedValue()
+        }
+
+        pthread_mutex_lock(mutex)
+        let buffer = Buffer(index: buffers.count, capacity: capacity)
+        buffers.append(buffer)
+        pthread_mutex_unlock(mutex)
+
+        // Kept alive by `buffers`.
+        pthread_setspecific(key, Unmanaged.passUnretained(buffer).toOpaque())
+        return buffer
+    }
+}
@@ -13,3 +13,32 @@ extension Writable {
         }
     }
 }
+
+/// Representation of a type which buffers written data until flushed.
+public protocol Flushable {
+    /// Write any buffered data timing out at `deadline`.
+    func flush(deadline: Deadline) throws
+}
+
+/// Representation of a type which passes written data through unchanged,
+/// letting zero-copy paths such as `sendfile` bypass it.
+public protocol TransparentWritable : Writable {
+    /// Prepares to have `count` bytes written straight to the returned
+    /// stream, flushing anything buffered first. Returns `nil` if the bytes
+    /// must go through `write` instead.
+    func beginTransparentWrite(count: Int, deadline: Deadline) throws -> Writable?
+}
+
+extension Writable {
+    /// Innermost stream that `count` bytes can be written to directly.
+    public func transparentDestination(count: Int, deadline: Deadline) throws -> Writable {
+        var destination: Writable = self
+        
+        while let transparent = destination as? TransparentWritable,
+            let next = try transparent.beginTransparentWrite(count: count, deadline: deadline) {
+            destination = next
+        }
+        
+        return destination
+    }
+}
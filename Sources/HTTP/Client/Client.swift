@@ -44,6 +44,44 @@ open class Client {
         /// Close connection timeout
         public var closeConnectionTimeout: Duration = 1.minute
         
+        /// Options applied to plain TCP connections
+        public var socketOptions: SocketOptions = .default
+        
+        /// Backend driving plain TCP connections
+        public var socketBackend: SocketBackend = .poll
+        
+        /// Path of a Unix domain socket to connect through instead of TCP.
+        ///
+        /// The URI host and port are still used for the `Host` header.
+        /// Connections over Unix domain sockets are always plaintext.
+        public var unixSocketPath: String? = nil
+        
+        /// Ask for gzip or deflate responses and inflate them while they are
+        /// read. Only applies to requests without their own `Accept-Encoding`.
+        public var decompressResponses: Bool = true
+        
+        /// Largest decompressed to compressed size ratio accepted
+        public var maximumDecompressionRatio: Int = 100
+        
+        /// Bodies of at least this many bytes are sent with
+        /// `Expect: 100-continue`, so the server can refuse them before they
+        /// are uploaded. `nil` only honours an `Expect` header set by the caller.
+        public var expectContinueThreshold: Int? = nil
+        
+        /// How long to wait for `100 Continue` before sending the body anyway
+        public var expectContinueTimeout: Duration = 1.second
+        
+        /// HTTP/2 settings, disabled when `nil`.
+        ///
+        /// Over TLS, HTTP/2 is offered through ALPN and HTTP/1.1 is used if the
+        /// server declines. Cleartext connections assume the server speaks
+        /// h2c, so only enable it for those that are known to.
+        public var http2: HTTP2Settings? = nil
+        
+        /// Registry pool waits, connects and latencies are reported to,
+        /// not reported when `nil`
+        public var metrics: MetricsRegistry? = .default
+        
         public init() {}
         
         public static var `default`: Configuration {
@@ -56,7 +94,14 @@ open class Client {
     
     private let host: String
     private let port: Int
+    private let secure: Bool
     private let pool: Pool
+    private let instruments: ClientMetrics?
+    
+    /// Shared by every request while HTTP/2 is in use
+    private var multiplexed: HTTP2Connection?
+    private var http2Refused = false
+    private let multiplexedLock: CoroutineLock
     
     /// Creates a new HTTP client
     public init(uri: String, configuration: Configuration = .default) throws {
@@ -65,7 +110,10 @@ open class Client {
         
         self.host = host
         self.port = port
+        self.secure = secure
         self.configuration = configuration
+        self.multiplexedLock = try CoroutineLock()
+        self.instruments = ClientMetrics.metrics(for: configuration)
         
         self.pool = try Pool(size: configuration.poolSize) {
             let (stream, serializer, parser) = try Client.connection(
@@ -85,6 +133,7 @@ open class Client {
     
     deinit {
         pool.close()
+        multiplexed?.close()
     }
     
     private static func extract(uri: URI) throws -> (String, Int, Bool) {
@@ -112,32 +161,62 @@ open class Client {
         return (host, port, secure)
     }
     
-    private static func connection(
+    private static func openStream(
         host: String,
         port: Int,
         secure: Bool,
+        alpnProtocols: [String] = [],
         configuration: Configuration
-    ) throws -> (DuplexStream, RequestSerializer, ResponseParser) {
+    ) throws -> DuplexStream {
         let stream: DuplexStream
         
-        if secure {
-            stream = try TLSStream(
+        if let path = configuration.unixSocketPath {
+            stream = UnixStream(path: path)
+        } else if secure {
+            let tls = try TLSStream(
                 host: host,
                 port: port,
                 deadline: configuration.addressResolutionTimeout.fromNow()
             )
+            
+            tls.alpnProtocols = alpnProtocols
+            stream = tls
         } else {
-            stream = try TCPStream(
+            stream = try configuration.socketBackend.stream(
                 host: host,
                 port: port,
+                options: configuration.socketOptions,
                 deadline: configuration.addressResolutionTimeout.fromNow()
             )
         }
         
+        let start = MonotonicClock.now()
         try stream.open(deadline: configuration.connectionTimeout.fromNow())
+        ClientMetrics.metrics(for: configuration)?.connectDuration.record(since: start)
+        return stream
+    }
+    
+    private static func connection(
+        host: String,
+        port: Int,
+        secure: Bool,
+        configuration: Configuration
+    ) throws -> (DuplexStream, RequestSerializer, ResponseParser) {
+        let stream = try openStream(
+            host: host,
+            port: port,
+            secure: secure,
+            configuration: configuration
+        )
+        
+        let output = BufferedStream(
+            stream,
+            readBufferSize: 0,
+            writeBufferSize: configuration.serializerBufferSize
+        )
         
         let serializer = RequestSerializer(
-            stream: stream,
+            stream: output,
             bufferSize: configuration.serializerBufferSize
         )
         
@@ -163,12 +242,161 @@ open class Client {
             request.userAgent = "Zewo"
         }
         
+        if let context = request.traceContext, request.headers["traceparent"] == nil {
+            request.headers["traceparent"] = context.traceparent
+        }
+        
         if closeConnection {
             request.connection = "close"
         }
     }
     
+    /// Adds `Accept-Encoding` unless the caller set it, in which case the
+    /// caller also gets the encoded response. Returns whether it was added.
+    private static func requestCompression(_ request: Request, configuration: Configuration) -> Bool {
+        guard configuration.decompressResponses, request.headers["Accept-Encoding"] == nil else {
+            return false
+        }
+        
+        request.headers["Accept-Encoding"] = "gzip, deflate"
+        return true
+    }
+    
+    /// Takes back the `Accept-Encoding` added by `requestCompression`, so
+    /// the caller's request is left as it was given.
+    private static func withdrawCompression(_ request: Request, added: Bool) {
+        if added {
+            request.headers["Accept-Encoding"] = nil
+        }
+    }
+    
+    /// Adds `Expect: 100-continue` to large bodies. Returns whether the body
+    /// must wait for the server.
+    private static func requestContinue(_ request: Request, configuration: Configuration) -> Bool {
+        guard request.headers["Expect"] == nil else {
+            return request.expectsContinue
+        }
+        
+        guard
+            let threshold = configuration.expectContinueThreshold,
+            let length = request.contentLength ?? request.body.fileLength,
+            length > 0,
+            length >= threshold,
+            request.version.major == 1,
+            request.version.minor >= 1
+        else {
+            return false
+        }
+        
+        request.headers["Expect"] = "100-continue"
+        return true
+    }
+    
+    /// Sends `request` and reads its final response. Returns `false` along
+    /// with a response that arrived before the body was sent, in which case
+    /// the connection must not be reused.
+    private static func exchange(
+        _ request: Request,
+        expectContinue: Bool,
+        serializer: RequestSerializer,
+        parser: ResponseParser,
+        configuration: Configuration
+    ) throws -> (response: Response, reusable: Bool) {
+        guard expectContinue else {
+            try serializer.serialize(
+                request,
+                deadline: configuration.serializeTimeout.fromNow()
+            )
+            
+            return (try finalResponse(request, parser: parser, configuration: configuration), true)
+        }
+        
+        try serializer.serialize(
+            request,
+            includingBody: false,
+            deadline: configuration.serializeTimeout.fromNow()
+        )
+        
+        if let response = try awaitContinue(request, parser: parser, configuration: configuration) {
+            return (response, false)
+        }
+        
+        try serializer.serializeDeferredBody(
+            request,
+            deadline: configuration.serializeTimeout.fromNow()
+        )
+        
+        return (try finalResponse(request, parser: parser, configuration: configuration), true)
+    }
+    
+    /// Waits up to `expectContinueTimeout` for the server to ask for the
+    /// body. Returns the final response if the server answers without it.
+    private static func awaitContinue(
+        _ request: Request,
+        parser: ResponseParser,
+        configuration: Configuration
+    ) throws -> Response? {
+        let deadline = configuration.expectContinueTimeout.fromNow()
+        
+        while true {
+            let response: Response
+            
+            do {
+                response = try parser.parse(deadline: deadline)
+            } catch VeniceError.deadlineReached, SystemError.operationTimedOut {
+                // Servers that predate `Expect` never answer; send anyway.
+                return nil
+            }
+            
+            if response.status == .continue {
+                return nil
+            }
+            
+            if !response.status.isInformational || response.status == .switchingProtocols {
+                return response
+            }
+            
+            request.receiveInterimResponse?(response)
+        }
+    }
+    
+    /// Hands interim `1xx` responses, except `101 Switching Protocols`, to
+    /// `receiveInterimResponse` and returns the response that follows them.
+    private static func finalResponse(
+        _ request: Request,
+        parser: ResponseParser,
+        configuration: Configuration
+    ) throws -> Response {
+        let deadline = configuration.parseTimeout.fromNow()
+        
+        while true {
+            let response = try parser.parse(deadline: deadline)
+            
+            if !response.status.isInformational || response.status == .switchingProtocols {
+                return response
+            }
+            
+            request.receiveInterimResponse?(response)
+        }
+    }
+    
     public static func send(_ request: Request, configuration: Configuration = .default) throws -> Response {
+        let start = MonotonicClock.now()
+        
+        defer {
+            ClientMetrics.metrics(for: configuration)?.requestDuration.record(since: start)
+        }
+        
+        guard let cancellation = request.cancellation else {
+            return try transmit(request, configuration: configuration)
+        }
+        
+        return try cancellation.run {
+            try Client.transmit(request, configuration: configuration)
+        }
+    }
+    
+    private static func transmit(_ request: Request, configuration: Configuration) throws -> Response {
         let (host, port, secure) = try extract(uri: request.uri)
         
         let (stream, serializer, parser) = try connection(
@@ -182,17 +410,28 @@ open class Client {
             request: request,
             host: host,
             port: port,
-            closeConnection: true
+            closeConnection: request.upgradeConnection == nil
         )
         
-        try serializer.serialize(
+        let decompress = requestCompression(request, configuration: configuration)
+        
+        defer {
+            withdrawCompression(request, added: decompress)
+        }
+        
+        let expectContinue = requestContinue(request, configuration: configuration)
+        
+        let (response, _) = try exchange(
             request,
-            deadline: configuration.serializeTimeout.fromNow()
+            expectContinue: expectContinue,
+            serializer: serializer,
+            parser: parser,
+            configuration: configuration
         )
         
-        let response = try parser.parse(
-            deadline: configuration.parseTimeout.fromNow()
-        )
+        if decompress {
+            try response.inflateBody(answering: request, maximumRatio: configuration.maximumDecompressionRatio)
+        }
         
         if let upgrade = request.upgradeConnection {
             try upgrade(response, stream)
@@ -203,13 +442,44 @@ open class Client {
     }
     
     public func send(_ request: Request) throws -> Response {
+        let start = MonotonicClock.now()
+        
+        defer {
+            instruments?.requestDuration.record(since: start)
+        }
+        
+        guard let cancellation = request.cancellation else {
+            return try transmit(request)
+        }
+        
+        return try cancellation.run {
+            try self.transmit(request)
+        }
+    }
+    
+    private func transmit(_ request: Request) throws -> Response {
+        if request.upgradeConnection == nil, let connection = try multiplexedConnection() {
+            return try send(request, on: connection)
+        }
+        
         var retryCount = 0
+        let decompress = Client.requestCompression(request, configuration: configuration)
+        
+        defer {
+            Client.withdrawCompression(request, added: decompress)
+        }
+        
+        let expectContinue = Client.requestContinue(request, configuration: configuration)
         
         loop: while true {
+            let borrowStart = MonotonicClock.now()
+            
             let connection = try pool.borrow(
                 deadline: configuration.borrowTimeout.fromNow()
             )
             
+            instruments?.poolWaitDuration.record(since: borrowStart)
+            
             let stream = connection.stream
             let serializer = connection.serializer
             let parser = connection.parser
@@ -217,16 +487,23 @@ open class Client {
             Client.configureHeaders(request: request, host: host, port: port)
             
             do {
-                try serializer.serialize(
+                let (response, reusable) = try Client.exchange(
                     request,
-                    deadline: configuration.serializeTimeout.fromNow()
+                    expectContinue: expectContinue,
+                    serializer: serializer,
+                    parser: parser,
+                    configuration: configuration
                 )
                 
-                let response = try parser.parse(
-                    deadline: configuration.parseTimeout.fromNow()
-                )
+                if decompress {
+                    try response.inflateBody(answering: request, maximumRatio: configuration.maximumDecompressionRatio)
+                }
                 
-                if let upgrade = request.upgradeConnection {
+                if !reusable {
+                    // The body was never sent, so the connection is left for
+                    // the response body only and dropped with it.
+                    pool.dispose(connection)
+                } else if let upgrade = request.upgradeConnection {
                     try upgrade(response, stream)
                     try stream.close(deadline: configuration.closeConnectionTimeout.fromNow())
                     pool.dispose(connection)
@@ -239,7 +516,7 @@ open class Client {
                 pool.dispose(connection)
                 retryCount += 1
                 
-                guard retryCount < 10 else {
+                guard retryCount < 10, request.cancellation?.isCancelled != true else {
                     throw error
                 }
                 
@@ -247,6 +524,75 @@ open class Client {
             }
         }
     }
+    
+    /// The HTTP/2 connection requests are multiplexed over, opened on first
+    /// use. `nil` when HTTP/2 is disabled or the server declined it.
+    private func multiplexedConnection() throws -> HTTP2Connection? {
+        guard let settings = configuration.http2, !http2Refused else {
+            return nil
+        }
+        
+        return try multiplexedLock.withLock { () -> HTTP2Connection? in
+            if let connection = multiplexed, connection.isUsable {
+                return connection
+            }
+            
+            // Streams still in flight keep a connection that is going away
+            // alive until they are done with it.
+            multiplexed = nil
+            
+            let stream = try Client.openStream(
+                host: host,
+                port: port,
+                secure: secure,
+                alpnProtocols: ["h2", "http/1.1"],
+                configuration: configuration
+            )
+            
+            if let tls = stream as? TLSStream {
+                guard try tls.negotiatedProtocol(deadline: configuration.connectionTimeout.fromNow()) == "h2" else {
+                    http2Refused = true
+                    try? stream.close(deadline: configuration.closeConnectionTimeout.fromNow())
+                    return nil
+                }
+            }
+            
+            let connection = try HTTP2Connection(
+                stream: stream,
+                role: .client,
+                settings: settings,
+                writeTimeout: configuration.serializeTimeout,
+                idleTimeout: configuration.closeConnectionTimeout
+            )
+            
+            try connection.start()
+            multiplexed = connection
+            return connection
+        }
+    }
+    
+    private func send(_ request: Request, on connection: HTTP2Connection) throws -> Response {
+        let decompress = Client.requestCompression(request, configuration: configuration)
+        
+        defer {
+            Client.withdrawCompression(request, added: decompress)
+        }
+        
+        Client.configureHeaders(request: request, host: host, port: port)
+        
+        let response = try connection.send(
+            request,
+            scheme: secure ? "https" : "http",
+            authority: host + ":" + String(port),
+            timeout: configuration.parseTimeout
+        )
+        
+        if decompress {
+            try response.inflateBody(answering: request, maximumRatio: configuration.maximumDecompressionRatio)
+        }
+        
+        return response
+    }
 }
 
 fileprivate class Pool {
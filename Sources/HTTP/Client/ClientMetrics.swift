@@ -0,0 +1,37 @@
+import Core
+
+/// Metrics `Client` reports.
+internal struct ClientMetrics {
+    let poolWaitDuration: Histogram
+    let connectDuration: Histogram
+    let requestDuration: Histogram
+
+    /// Registered once, for the registry clients report to unless told
+    /// otherwise.
+    private static let standard = ClientMetrics(registry: .default)
+
+    init(registry: MetricsRegistry) {
+        poolWaitDuration = registry.histogram(
+            "http_client_pool_wait_duration_seconds",
+            help: "Time spent waiting to borrow a pooled connection."
+        )
+
+        connectDuration = registry.histogram(
+            "http_client_connect_duration_seconds",
+            help: "Time spent opening connections."
+        )
+
+        requestDuration = registry.histogram(
+            "http_client_request_duration_seconds",
+            help: "Time from sending a request to receiving its response head."
+        )
+    }
+
+    static func metrics(for configuration: Client.Configuration) -> ClientMetrics? {
+        guard let registry = configuration.metrics else {
+            return nil
+        }
+
+        return registry === MetricsRegistry.default ? standard : ClientMetrics(registry: registry)
+    }
+}
@@ -0,0 +1,152 @@
+import Core
+import IO
+import Venice
+
+/// Response compression settings for `Server`.
+///
+/// Responses are compressed with `gzip` or `deflate` when the request
+/// accepts it, the media type is allowed, and the body is at least
+/// `minimumSize` bytes long or of unknown length. Compressed bodies are sent
+/// chunked. File bodies are left alone so they stay zero-copy; serve
+/// precompressed siblings with `StaticFiles` instead.
+public struct Compression {
+    /// zlib compression level, from 1 (fastest) to 9 (smallest).
+    public var level: Int
+    
+    /// Bodies with a smaller `Content-Length` are sent as is.
+    public var minimumSize: Int
+    
+    /// Media types worth compressing, matched as prefixes of `Content-Type`.
+    public var mediaTypes: [String]
+    
+    public init(
+        level: Int = 6,
+        minimumSize: Int = 1024,
+        mediaTypes: [String] = Compression.defaultMediaTypes
+    ) {
+        self.level = level
+        self.minimumSize = minimumSize
+        self.mediaTypes = mediaTypes.map({ $0.lowercased() })
+    }
+    
+    public static let defaultMediaTypes = [
+        "text/",
+        "application/json",
+        "application/javascript",
+        "application/xml",
+        "application/xhtml+xml",
+        "application/rss+xml",
+        "application/atom+xml",
+        "application/wasm",
+        "image/svg+xml",
+    ]
+}
+
+/// Compresses the responses of one connection, reusing its zlib streams.
+internal final class ResponseCompressor {
+    private let compression: Compression
+    private let timeout: Duration
+    private var gzip: Deflater?
+    private var deflate: Deflater?
+    
+    internal init(compression: Compression, timeout: Duration) {
+        self.compression = compression
+        self.timeout = timeout
+    }
+    
+    internal func compress(_ response: Response, for request: Request) {
+        guard
+            isCompressible(response, for: request),
+            let accepted = request.headers["Accept-Encoding"].map(AcceptEncoding.init),
+            let deflater = deflater(for: accepted)
+        else {
+            return
+        }
+        
+        let timeout = self.timeout
+        let body = response.body
+        
+        response.body = .writable({ stream in
+            let writer = try deflater.writer(to: stream)
+            
+            switch body {
+            case let .readable(readable):
+                try pipe(from: readable, to: writer, deadline: timeout.fromNow())
+            case let .writable(write):
+                try write(writer)
+            case let .file(file, range):
+                try file.write(range, to: writer, deadline: timeout.fromNow())
+            }
+            
+            try writer.finish(deadline: timeout.fromNow())
+        })
+        
+        response.contentLength = nil
+        response.transferEncoding = "chunked"
+        response.headers["Content-Encoding"] = deflater.coding
+        response.headers["Accept-Ranges"] = nil
+        
+        if let vary = response.headers["Vary"] {
+            if !vary.lowercased().contains("accept-encoding") {
+                response.headers["Vary"] = vary + ", Accept-Encoding"
+            }
+        } else {
+            response.headers["Vary"] = "Accept-Encoding"
+        }
+        
+        // The compressed bytes differ from the identity representation.
+        if let etag = response.headers["ETag"], !etag.hasPrefix("W/") {
+            response.headers["ETag"] = "W/" + etag
+        }
+    }
+    
+    private func isCompressible(_ response: Response, for request: Request) -> Bool {
+        guard
+            request.method != .head,
+            request.version.minor >= 1,
+            [200, 201, 202, 203].contains(response.status.statusCode),
+            response.upgradeConnection == nil,
+            response.headers["Content-Encoding"] == nil,
+            response.headers["Content-Range"] == nil,
+            !response.body.isFile
+        else {
+            return false
+        }
+        
+        if let cacheControl = response.headers["Cache-Control"], cacheControl.lowercased().contains("no-transform") {
+            return false
+        }
+        
+        if let contentLength = response.contentLength, contentLength < max(compression.minimumSize, 1) {
+            return false
+        }
+        
+        guard let contentType = response.headers["Content-Type"]?.lowercased() else {
+            return false
+        }
+        
+        return compression.mediaTypes.contains(where: { contentType.hasPrefix($0) })
+    }
+    
+    private func deflater(for accepted: AcceptEncoding) -> Deflater? {
+        let useGzip = accepted.accepts("gzip") && accepted.quality(of: "gzip") >= accepted.quality(of: "deflate")
+        
+        if useGzip {
+            if gzip == nil {
+                gzip = try? Deflater(gzip: true, level: compression.level)
+            }
+            
+            return gzip
+        }
+        
+        if accepted.accepts("deflate") {
+            if deflate == nil {
+                deflate = try? Deflater(gzip: false, level: compression.level)
+            }
+            
+            return deflate
+        }
+        
+        return nil
+    }
+}
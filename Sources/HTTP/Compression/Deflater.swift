@@ -0,0 +1,142 @@
+import Core
+import CZlib
+import Venice
+
+public enum CompressionError : Error {
+    case initializationFailed
+    case streamError
+    case corruptStream
+    case truncatedStream
+    case ratioExceeded
+}
+
+extension CompressionError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .initializationFailed:
+            return "The compression stream could not be initialized."
+        case .streamError:
+            return "The compression stream is in an inconsistent state."
+        case .corruptStream:
+            return "The compressed data is corrupt."
+        case .truncatedStream:
+            return "The compressed data ended before the end of the stream."
+        case .ratioExceeded:
+            return "The data inflates beyond the maximum decompression ratio."
+        }
+    }
+}
+
+/// zlib compressor whose state is reset, not rebuilt, between bodies.
+internal final class Deflater {
+    internal let coding: String
+    private let stream: OpaquePointer
+    private let output: UnsafeMutableRawBufferPointer
+    
+    internal init(gzip: Bool, level: Int) throws {
+        guard let stream = czlib_deflate_create(gzip ? CZLIB_GZIP : CZLIB_DEFLATE, Int32(level)) else {
+            throw CompressionError.initializationFailed
+        }
+        
+        self.coding = gzip ? "gzip" : "deflate"
+        self.stream = stream
+        
+        self.output = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 16 * 1024,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+    }
+    
+    deinit {
+        czlib_deflate_destroy(stream)
+        output.deallocate()
+    }
+    
+    /// Starts a new compressed body written to `destination`.
+    internal func writer(to destination: Writable) throws -> Writer {
+        guard czlib_deflate_reset(stream) == CZLIB_OK else {
+            throw CompressionError.streamError
+        }
+        
+        return Writer(deflater: self, destination: destination)
+    }
+    
+    /// Feeds `input` through the compressor, writing output as it fills up.
+    /// Returns `true` once the stream has ended.
+    fileprivate func compress(
+        _ input: UnsafeRawBufferPointer,
+        flush: Int32,
+        to destination: Writable,
+        deadline: Deadline
+    ) throws -> Bool {
+        var offset = 0
+        
+        while true {
+            var consumed = 0
+            var produced = 0
+            
+            let result = czlib_deflate(
+                stream,
+                input.baseAddress.map({ $0 + offset }),
+                input.count - offset,
+                &consumed,
+                output.baseAddress,
+                output.count,
+                &produced,
+                flush
+            )
+            
+            guard result != CZLIB_ERROR else {
+                throw CompressionError.streamError
+            }
+            
+            offset += consumed
+            
+            if produced > 0 {
+                try destination.write(UnsafeRawBufferPointer(start: output.baseAddress, count: produced), deadline: deadline)
+            }
+            
+            if result == CZLIB_STREAM_END {
+                return true
+            }
+            
+            // Done once the input is used up and zlib had room to spare.
+            if offset == input.count && produced < output.count && flush != CZLIB_FINISH {
+                return false
+            }
+        }
+    }
+    
+    /// Compresses everything written to it into `destination`.
+    internal final class Writer : Writable, Flushable {
+        private let deflater: Deflater
+        private let destination: Writable
+        
+        fileprivate init(deflater: Deflater, destination: Writable) {
+            self.deflater = deflater
+            self.destination = destination
+        }
+        
+        internal func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+            guard !buffer.isEmpty else {
+                return
+            }
+            
+            _ = try deflater.compress(buffer, flush: CZLIB_NO_FLUSH, to: destination, deadline: deadline)
+        }
+        
+        /// Emits everything compressed so far, e.g. after each event of a
+        /// streaming response.
+        internal func flush(deadline: Deadline) throws {
+            let empty = UnsafeRawBufferPointer(start: nil, count: 0)
+            _ = try deflater.compress(empty, flush: CZLIB_SYNC_FLUSH, to: destination, deadline: deadline)
+            try (destination as? Flushable)?.flush(deadline: deadline)
+        }
+        
+        /// Writes the end of the compressed stream.
+        internal func finish(deadline: Deadline) throws {
+            let empty = UnsafeRawBufferPointer(start: nil, count: 0)
+            _ = try deflater.compress(empty, flush: CZLIB_FINISH, to: destination, deadline: deadline)
+        }
+    }
+}
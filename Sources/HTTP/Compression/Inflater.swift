@@ -0,0 +1,141 @@
+import Core
+import CZlib
+import Venice
+
+/// Readable that inflates a gzip or deflate encoded stream as it is read.
+///
+/// Only one compressed chunk is held in memory at a time, so decoders such
+/// as JSON parse the decompressed bytes as they arrive. Reading throws
+/// `CompressionError.ratioExceeded` once the output outgrows the input by
+/// more than `maximumRatio`, which defuses decompression bombs.
+internal final class InflatingReadable : Readable {
+    private let source: Readable
+    private let maximumRatio: Int
+    private let stream: OpaquePointer
+    private let input: UnsafeMutableRawBufferPointer
+    private var pending = UnsafeRawBufferPointer(start: nil, count: 0)
+    private var compressedCount = 0
+    private var inflatedCount = 0
+    private var ended = false
+    
+    internal init(_ source: Readable, maximumRatio: Int) throws {
+        guard let stream = czlib_inflate_create(CZLIB_AUTO) else {
+            throw CompressionError.initializationFailed
+        }
+        
+        self.source = source
+        self.maximumRatio = maximumRatio
+        self.stream = stream
+        
+        self.input = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 16 * 1024,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+    }
+    
+    deinit {
+        czlib_inflate_destroy(stream)
+        input.deallocate()
+    }
+    
+    internal func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        guard !buffer.isEmpty, !ended else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+        
+        while true {
+            if pending.isEmpty {
+                pending = try source.read(input, deadline: deadline)
+                
+                // An encoding header on an empty body describes nothing.
+                if pending.isEmpty && compressedCount == 0 {
+                    ended = true
+                    return UnsafeRawBufferPointer(start: nil, count: 0)
+                }
+                
+                guard !pending.isEmpty else {
+                    throw CompressionError.truncatedStream
+                }
+                
+                compressedCount += pending.count
+            }
+            
+            var consumed = 0
+            var produced = 0
+            
+            let result = czlib_inflate(
+                stream,
+                pending.baseAddress,
+                pending.count,
+                &consumed,
+                buffer.baseAddress,
+                buffer.count,
+                &produced
+            )
+            
+            guard result != CZLIB_ERROR else {
+                throw CompressionError.corruptStream
+            }
+            
+            #if swift(>=3.2)
+                pending = UnsafeRawBufferPointer(rebasing: pending.suffix(from: consumed))
+            #else
+                pending = pending.suffix(from: consumed)
+            #endif
+            
+            inflatedCount += produced
+            
+            // Small bodies get some slack; their ratio says little.
+            guard inflatedCount <= maximumRatio * max(compressedCount, 1024) else {
+                throw CompressionError.ratioExceeded
+            }
+            
+            if result == CZLIB_STREAM_END {
+                ended = true
+            }
+            
+            if produced > 0 || ended {
+                #if swift(>=3.2)
+                    return UnsafeRawBufferPointer(rebasing: buffer.prefix(produced))
+                #else
+                    return UnsafeRawBufferPointer(buffer.prefix(produced))
+                #endif
+            }
+        }
+    }
+}
+
+extension Message {
+    /// Swaps a gzip or deflate encoded body for one that is inflated while
+    /// it is read, and drops the headers that described the encoded bytes.
+    /// Other codings are left for the application.
+    internal func inflateBody(maximumRatio: Int) throws {
+        guard
+            let coding = headers["Content-Encoding"]?.lowercased(),
+            ["gzip", "x-gzip", "deflate"].contains(coding),
+            case let .readable(readable) = body
+        else {
+            return
+        }
+        
+        body = .readable(try InflatingReadable(readable, maximumRatio: maximumRatio))
+        headers["Content-Encoding"] = nil
+        contentLength = nil
+    }
+}
+
+extension Response {
+    /// Inflates the body of the response to `request`, unless the response
+    /// has none. `Content-Length` of a response to `HEAD` then still gives
+    /// the length of the encoded representation.
+    internal func inflateBody(answering request: Request, maximumRatio: Int) throws {
+        guard request.method != .head, status.statusCode != 204, status.statusCode != 304 else {
+            return
+        }
+        
+        try inflateBody(maximumRatio: maximumRatio)
+    }
+}
@@ -0,0 +1,246 @@
+import Core
+import Venice
+
+/// Fans server-sent events out to `text/event-stream` subscribers.
+///
+/// Each event is formatted once and queued by reference for every
+/// subscriber of its topic, so publishing never waits for a connection.
+/// A subscriber whose queue fills up is evicted: its response ends and
+/// the client reconnects with `Last-Event-ID`, picking up the events it
+/// missed from the replay ring.
+///
+/// Like the rest of the server, a hub belongs to the thread whose
+/// coroutines use it.
+public final class EventHub {
+    public struct Configuration {
+        /// Recent events kept for clients that reconnect
+        public var replayCapacity: Int = 1024
+
+        /// Events queued per subscriber before it is evicted
+        public var queueCapacity: Int = 256
+
+        /// Interval between comments sent to idle subscribers, which also
+        /// reveals connections that went away. `nil` disables them.
+        public var heartbeatInterval: Duration? = 15.seconds
+
+        /// Write timeout
+        public var writeTimeout: Duration = 30.seconds
+
+        /// Milliseconds clients wait before reconnecting, sent when they
+        /// subscribe. `nil` keeps the client's default.
+        public var retry: Int? = nil
+
+        public init() {}
+
+        public static var `default`: Configuration {
+            return Configuration()
+        }
+    }
+
+    public let configuration: Configuration
+
+    /// Subscribers currently connected
+    public var subscriberCount: Int {
+        return subscribers.count
+    }
+
+    /// Subscribers evicted for falling behind
+    public private(set) var evictionCount = 0
+
+    private var subscribers: [ObjectIdentifier: Subscriber] = [:]
+    private var topics: [String: [ObjectIdentifier: Subscriber]] = [:]
+    private var replay: [SerializedEvent?]
+    private var replayNext = 0
+    private var sequence = 0
+    private let heartbeat = SerializedEvent(comment: "heartbeat")
+
+    public init(configuration: Configuration = .default) {
+        self.configuration = configuration
+        self.replay = Array(repeating: nil, count: max(configuration.replayCapacity, 0))
+    }
+
+    /// Queues `event` for every subscriber of `topic` and returns its id.
+    @discardableResult
+    public func publish(_ event: ServerSentEvent, to topic: String) -> String {
+        sequence += 1
+
+        let serialized = SerializedEvent(event, id: event.id ?? String(sequence), topic: topic)
+
+        if !replay.isEmpty {
+            replay[replayNext] = serialized
+            replayNext = (replayNext + 1) % replay.count
+        }
+
+        for subscriber in topics[topic].map({ Array($0.values) }) ?? [] {
+            if !subscriber.enqueue(serialized, capacity: configuration.queueCapacity) {
+                evict(subscriber)
+            }
+        }
+
+        return serialized.id
+    }
+
+    /// Subscribes the client making `request` to `topics` and returns the
+    /// streaming response, which lasts until the client leaves or is
+    /// evicted. Events after `Last-Event-ID` are replayed first.
+    public func subscribe(_ request: Request, to topics: [String]) -> Response {
+        let lastEventID = request.headers["Last-Event-ID"]
+
+        let headers: Headers = [
+            "Content-Type": "text/event-stream",
+            // Compression would hold events back until its buffer fills.
+            "Cache-Control": "no-cache, no-transform",
+            "X-Accel-Buffering": "no",
+        ]
+
+        // Subscribers only join once the body is being sent, so responses
+        // that never get that far, like those to `HEAD`, leave nothing behind.
+        let response = Response(status: .ok, headers: headers) { writable in
+            let subscriber = try Subscriber(topics: topics)
+
+            if let lastEventID = lastEventID {
+                for event in self.missedEvents(after: lastEventID, topics: Set(topics)) {
+                    subscriber.replay(event)
+                }
+            }
+
+            self.register(subscriber)
+
+            defer {
+                self.unregister(subscriber)
+            }
+
+            try self.stream(to: subscriber, through: writable)
+        }
+
+        response.transferEncoding = "chunked"
+        return response
+    }
+
+    private func stream(to subscriber: Subscriber, through writable: Writable) throws {
+        if let retry = configuration.retry {
+            try write(SerializedEvent(retry: retry), to: writable)
+        }
+
+        while !subscriber.evicted {
+            let events = subscriber.drain()
+
+            if events.isEmpty {
+                do {
+                    try subscriber.signal.wait(deadline: configuration.heartbeatInterval?.fromNow() ?? .never)
+                } catch VeniceError.deadlineReached {
+                    try write(heartbeat, to: writable)
+                    try (writable as? Flushable)?.flush(deadline: configuration.writeTimeout.fromNow())
+                }
+
+                continue
+            }
+
+            // Everything queued goes out with a single flush.
+            for event in events {
+                try write(event, to: writable)
+            }
+
+            try (writable as? Flushable)?.flush(deadline: configuration.writeTimeout.fromNow())
+        }
+    }
+
+    private func write(_ event: SerializedEvent, to writable: Writable) throws {
+        let deadline = configuration.writeTimeout.fromNow()
+
+        try event.framed.withUnsafeBytes { (framed: UnsafeRawBufferPointer) -> Void in
+            if let body = writable as? Serializer.BodyStream {
+                try body.write(framed: framed, payload: event.payload, deadline: deadline)
+            } else {
+                try writable.write(UnsafeRawBufferPointer(rebasing: framed[event.payload]), deadline: deadline)
+            }
+        }
+    }
+
+    /// Events of `topics` published after the one with `id`, oldest first.
+    /// Nothing is replayed once `id` has left the ring.
+    private func missedEvents(after id: String, topics: Set<String>) -> [SerializedEvent] {
+        let ordered = (0 ..< replay.count).compactMap({ replay[(replayNext + $0) % replay.count] })
+
+        guard let index = ordered.lastIndex(where: { $0.id == id }) else {
+            return []
+        }
+
+        return ordered[(index + 1)...].filter({ topics.contains($0.topic) })
+    }
+
+    private func register(_ subscriber: Subscriber) {
+        let key = ObjectIdentifier(subscriber)
+        subscribers[key] = subscriber
+
+        for topic in subscriber.topics {
+            topics[topic, default: [:]][key] = subscriber
+        }
+    }
+
+    private func unregister(_ subscriber: Subscriber) {
+        let key = ObjectIdentifier(subscriber)
+
+        guard subscribers.removeValue(forKey: key) != nil else {
+            return
+        }
+
+        for topic in subscriber.topics {
+            topics[topic]?[key] = nil
+
+            if topics[topic]?.isEmpty == true {
+                topics[topic] = nil
+            }
+        }
+    }
+
+    private func evict(_ subscriber: Subscriber) {
+        evictionCount += 1
+        unregister(subscriber)
+        subscriber.evict()
+    }
+}
+
+private final class Subscriber {
+    let topics: [String]
+    let signal: Signal
+    private(set) var evicted = false
+
+    private var queue: [SerializedEvent] = []
+    private var replayed: [SerializedEvent] = []
+
+    init(topics: [String]) throws {
+        self.topics = topics
+        self.signal = try Signal()
+    }
+
+    /// Returns `false` if the queue is full.
+    func enqueue(_ event: SerializedEvent, capacity: Int) -> Bool {
+        guard queue.count < capacity else {
+            return false
+        }
+
+        queue.append(event)
+        signal.broadcast()
+        return true
+    }
+
+    /// Replayed events do not count against the queue capacity.
+    func replay(_ event: SerializedEvent) {
+        replayed.append(event)
+    }
+
+    func drain() -> [SerializedEvent] {
+        let events = replayed + queue
+        replayed.removeAll()
+        queue.removeAll(keepingCapacity: true)
+        return events
+    }
+
+    func evict() {
+        evicted = true
+        queue = []
+        replayed = []
+        signal.broadcast()
+    }
+}
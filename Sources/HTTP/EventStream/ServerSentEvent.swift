@@ -0,0 +1,92 @@
+/// An event of a `text/event-stream` response.
+public struct ServerSentEvent {
+    /// Identifier the client sends back in `Last-Event-ID` when it
+    /// reconnects. `EventHub` numbers events that have none.
+    public var id: String?
+
+    /// Event type, `message` when `nil`
+    public var event: String?
+
+    public var data: String
+
+    /// Milliseconds the client should wait before reconnecting
+    public var retry: Int?
+
+    public init(data: String, event: String? = nil, id: String? = nil, retry: Int? = nil) {
+        self.data = data
+        self.event = event
+        self.id = id
+        self.retry = retry
+    }
+}
+
+/// An event formatted once and shared, by reference, by every subscriber it
+/// is queued for.
+///
+/// `framed` holds the event already wrapped as an HTTP/1.1 chunk, so a
+/// chunked response writes it with a single call. `payload` is the range of
+/// the event itself, for connections that frame it some other way.
+internal final class SerializedEvent {
+    let id: String
+    let topic: String
+    let framed: [UInt8]
+    let payload: Range<Int>
+
+    init(_ event: ServerSentEvent, id: String, topic: String) {
+        self.id = id
+        self.topic = topic
+
+        var text = ""
+
+        if let type = event.event {
+            text += "event: " + SerializedEvent.field(type) + "\n"
+        }
+
+        text += "id: " + SerializedEvent.field(id) + "\n"
+
+        if let retry = event.retry {
+            text += "retry: " + String(retry) + "\n"
+        }
+
+        for line in event.data.split(omittingEmptySubsequences: false, whereSeparator: { $0 == "\n" || $0 == "\r" || $0 == "\r\n" }) {
+            text += "data: " + line + "\n"
+        }
+
+        text += "\n"
+
+        let (framed, payload) = SerializedEvent.frame(Array(text.utf8))
+        self.framed = framed
+        self.payload = payload
+    }
+
+    /// A comment line, sent to keep idle connections and proxies alive.
+    convenience init(comment: String) {
+        self.init(control: ": " + SerializedEvent.field(comment) + "\n\n")
+    }
+
+    /// Sets the reconnection delay without dispatching an event.
+    convenience init(retry: Int) {
+        self.init(control: "retry: " + String(retry) + "\n\n")
+    }
+
+    private init(control text: String) {
+        self.id = ""
+        self.topic = ""
+        let (framed, payload) = SerializedEvent.frame(Array(text.utf8))
+        self.framed = framed
+        self.payload = payload
+    }
+
+    private static func frame(_ bytes: [UInt8]) -> ([UInt8], Range<Int>) {
+        var framed = Array((String(bytes.count, radix: 16) + "\r\n").utf8)
+        let start = framed.count
+        framed.append(contentsOf: bytes)
+        framed.append(contentsOf: [13, 10])
+        return (framed, start ..< start + bytes.count)
+    }
+
+    /// Line breaks would end the field early.
+    private static func field(_ value: String) -> String {
+        return String(value.filter({ $0 != "\n" && $0 != "\r" && $0 != "\r\n" }))
+    }
+}
@@ -0,0 +1,230 @@
+import Core
+import Venice
+
+/// Error codes of `RST_STREAM` and `GOAWAY` frames (RFC 7540, section 7).
+public enum HTTP2ErrorCode : UInt32 {
+    case noError = 0x0
+    case protocolError = 0x1
+    case internalError = 0x2
+    case flowControlError = 0x3
+    case settingsTimeout = 0x4
+    case streamClosed = 0x5
+    case frameSizeError = 0x6
+    case refusedStream = 0x7
+    case cancel = 0x8
+    case compressionError = 0x9
+    case connectError = 0xa
+    case enhanceYourCalm = 0xb
+    case inadequateSecurity = 0xc
+    case http11Required = 0xd
+}
+
+public enum HTTP2Error : Error {
+    /// This side broke the connection off with `GOAWAY`.
+    case connectionError(HTTP2ErrorCode, String)
+    /// The stream was reset, by either side.
+    case streamReset(HTTP2ErrorCode)
+    /// The peer sent `GOAWAY` before processing the stream, which can be
+    /// retried on a new connection.
+    case goingAway(HTTP2ErrorCode)
+    /// The connection ended while the stream was open.
+    case connectionClosed
+}
+
+extension HTTP2Error : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case let .connectionError(code, reason):
+            return "HTTP/2 connection error \(code): \(reason)"
+        case let .streamReset(code):
+            return "HTTP/2 stream reset: \(code)"
+        case let .goingAway(code):
+            return "HTTP/2 connection going away: \(code)"
+        case .connectionClosed:
+            return "HTTP/2 connection closed"
+        }
+    }
+}
+
+internal struct Frame {
+    enum Kind : UInt8 {
+        case data = 0x0
+        case headers = 0x1
+        case priority = 0x2
+        case resetStream = 0x3
+        case settings = 0x4
+        case pushPromise = 0x5
+        case ping = 0x6
+        case goAway = 0x7
+        case windowUpdate = 0x8
+        case continuation = 0x9
+    }
+
+    struct Flags : OptionSet {
+        let rawValue: UInt8
+
+        static let endStream = Flags(rawValue: 0x1)
+        static let acknowledge = Flags(rawValue: 0x1)
+        static let endHeaders = Flags(rawValue: 0x4)
+        static let padded = Flags(rawValue: 0x8)
+        static let priority = Flags(rawValue: 0x20)
+    }
+
+    static let headerSize = 9
+
+    /// `nil` for extension frames, which are ignored.
+    var kind: Kind?
+    var flags: Flags
+    var stream: UInt32
+    var payload: [UInt8]
+
+    init(_ kind: Kind, flags: Flags = [], stream: UInt32 = 0, payload: [UInt8] = []) {
+        self.kind = kind
+        self.flags = flags
+        self.stream = stream
+        self.payload = payload
+    }
+
+    fileprivate init(kind: Kind?, flags: Flags, stream: UInt32, payload: [UInt8]) {
+        self.kind = kind
+        self.flags = flags
+        self.stream = stream
+        self.payload = payload
+    }
+
+    static func appendHeader(
+        kind: Kind,
+        flags: Flags,
+        stream: UInt32,
+        length: Int,
+        to output: inout [UInt8]
+    ) {
+        output.append(UInt8(truncatingIfNeeded: length >> 16))
+        output.append(UInt8(truncatingIfNeeded: length >> 8))
+        output.append(UInt8(truncatingIfNeeded: length))
+        output.append(kind.rawValue)
+        output.append(flags.rawValue)
+        appendInteger(stream & 0x7fffffff, to: &output)
+    }
+
+    func encode(into output: inout [UInt8]) {
+        Frame.appendHeader(kind: kind!, flags: flags, stream: stream, length: payload.count, to: &output)
+        output.append(contentsOf: payload)
+    }
+
+    static func appendInteger(_ value: UInt32, to output: inout [UInt8]) {
+        output.append(UInt8(truncatingIfNeeded: value >> 24))
+        output.append(UInt8(truncatingIfNeeded: value >> 16))
+        output.append(UInt8(truncatingIfNeeded: value >> 8))
+        output.append(UInt8(truncatingIfNeeded: value))
+    }
+
+    static func integer(in bytes: [UInt8], at offset: Int) -> UInt32 {
+        return UInt32(bytes[offset]) << 24
+            | UInt32(bytes[offset + 1]) << 16
+            | UInt32(bytes[offset + 2]) << 8
+            | UInt32(bytes[offset + 3])
+    }
+
+    /// Payload without the padding of `DATA`, `HEADERS` and `PUSH_PROMISE`
+    /// frames, and without the priority fields of `HEADERS`.
+    func content() throws -> ArraySlice<UInt8> {
+        var start = 0
+        var end = payload.count
+
+        if flags.contains(.padded) {
+            guard !payload.isEmpty, Int(payload[0]) < payload.count else {
+                throw HTTP2Error.connectionError(.protocolError, "Padding exceeds the frame")
+            }
+
+            start = 1
+            end -= Int(payload[0])
+        }
+
+        if kind == .headers && flags.contains(.priority) {
+            start += 5
+
+            guard start <= end else {
+                throw HTTP2Error.connectionError(.frameSizeError, "HEADERS too short for its priority")
+            }
+        }
+
+        return payload[start ..< end]
+    }
+}
+
+/// Reads whole frames off a connection.
+internal final class FrameReader {
+    static let preface: [UInt8] = Array("PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n".utf8)
+
+    /// `SETTINGS_MAX_FRAME_SIZE` this side advertised.
+    var maximumFrameSize: Int
+
+    private let stream: Readable
+    private let chunk: UnsafeMutableRawBufferPointer
+    private var bytes: [UInt8] = []
+    private var start = 0
+
+    init(stream: Readable, maximumFrameSize: Int, bufferSize: Int = 16 * 1024) {
+        self.stream = stream
+        self.maximumFrameSize = maximumFrameSize
+
+        self.chunk = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: bufferSize,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+    }
+
+    deinit {
+        chunk.deallocate()
+    }
+
+    func readPreface(deadline: Deadline) throws {
+        try fill(FrameReader.preface.count, deadline: deadline)
+
+        guard bytes[start ..< start + FrameReader.preface.count].elementsEqual(FrameReader.preface) else {
+            throw HTTP2Error.connectionError(.protocolError, "Invalid connection preface")
+        }
+
+        start += FrameReader.preface.count
+    }
+
+    func read(deadline: Deadline) throws -> Frame {
+        try fill(Frame.headerSize, deadline: deadline)
+
+        let length = Int(bytes[start]) << 16 | Int(bytes[start + 1]) << 8 | Int(bytes[start + 2])
+
+        guard length <= maximumFrameSize else {
+            throw HTTP2Error.connectionError(.frameSizeError, "Frame larger than SETTINGS_MAX_FRAME_SIZE")
+        }
+
+        try fill(Frame.headerSize + length, deadline: deadline)
+
+        let frame = Frame(
+            kind: Frame.Kind(rawValue: bytes[start + 3]),
+            flags: Frame.Flags(rawValue: bytes[start + 4]),
+            stream: Frame.integer(in: bytes, at: start + 5) & 0x7fffffff,
+            payload: Array(bytes[start + Frame.headerSize ..< start + Frame.headerSize + length])
+        )
+
+        start += Frame.headerSize + length
+        return frame
+    }
+
+    private func fill(_ count: Int, deadline: Deadline) throws {
+        while bytes.count - start < count {
+            if start > 0 {
+                bytes.removeSubrange(0 ..< start)
+                start = 0
+            }
+
+            let read = try stream.read(chunk, deadline: deadline)
+
+            guard !read.isEmpty else {
+                throw HTTP2Error.connectionClosed
+            }
+
+            bytes.append(contentsOf: read)
+        }
+    }
+}
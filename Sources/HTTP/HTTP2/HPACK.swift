@@ -0,0 +1,422 @@
+/// Errors found while decoding a header block. Any of them breaks the
+/// shared compression state, so they are fatal to the connection.
+internal enum HPACKError : Error {
+    case truncatedBlock
+    case integerOverflow
+    case invalidIndex
+    case invalidHuffmanCode
+    case invalidTableSizeUpdate
+}
+
+internal typealias HeaderField = (name: String, value: String)
+
+/// Header table shared by both directions of HPACK (RFC 7541, section 2.3).
+internal struct HeaderTable {
+    static let entryOverhead = 32
+
+    static let staticEntries: [HeaderField] = [
+        (":authority", ""),
+        (":method", "GET"),
+        (":method", "POST"),
+        (":path", "/"),
+        (":path", "/index.html"),
+        (":scheme", "http"),
+        (":scheme", "https"),
+        (":status", "200"),
+        (":status", "204"),
+        (":status", "206"),
+        (":status", "304"),
+        (":status", "400"),
+        (":status", "404"),
+        (":status", "500"),
+        ("accept-charset", ""),
+        ("accept-encoding", "gzip, deflate"),
+        ("accept-language", ""),
+        ("accept-ranges", ""),
+        ("accept", ""),
+        ("access-control-allow-origin", ""),
+        ("age", ""),
+        ("allow", ""),
+        ("authorization", ""),
+        ("cache-control", ""),
+        ("content-disposition", ""),
+        ("content-encoding", ""),
+        ("content-language", ""),
+        ("content-length", ""),
+        ("content-location", ""),
+        ("content-range", ""),
+        ("content-type", ""),
+        ("cookie", ""),
+        ("date", ""),
+        ("etag", ""),
+        ("expect", ""),
+        ("expires", ""),
+        ("from", ""),
+        ("host", ""),
+        ("if-match", ""),
+        ("if-modified-since", ""),
+        ("if-none-match", ""),
+        ("if-range", ""),
+        ("if-unmodified-since", ""),
+        ("last-modified", ""),
+        ("link", ""),
+        ("location", ""),
+        ("max-forwards", ""),
+        ("proxy-authenticate", ""),
+        ("proxy-authorization", ""),
+        ("range", ""),
+        ("referer", ""),
+        ("refresh", ""),
+        ("retry-after", ""),
+        ("server", ""),
+        ("set-cookie", ""),
+        ("strict-transport-security", ""),
+        ("transfer-encoding", ""),
+        ("user-agent", ""),
+        ("vary", ""),
+        ("via", ""),
+        ("www-authenticate", ""),
+    ]
+
+    /// Static index of every name and of every name-value pair.
+    static let staticNameIndex: [String: Int] = {
+        var index: [String: Int] = [:]
+
+        for (offset, entry) in staticEntries.enumerated().reversed() {
+            index[entry.name] = offset + 1
+        }
+
+        return index
+    }()
+
+    static let staticPairIndex: [String: Int] = {
+        var index: [String: Int] = [:]
+
+        for (offset, entry) in staticEntries.enumerated() where !entry.value.isEmpty {
+            index[entry.name + "\0" + entry.value] = offset + 1
+        }
+
+        return index
+    }()
+
+    /// Newest entry first.
+    private(set) var entries: [HeaderField] = []
+    private(set) var size = 0
+
+    var maximumSize: Int {
+        didSet {
+            evict(toFit: 0)
+        }
+    }
+
+    init(maximumSize: Int) {
+        self.maximumSize = maximumSize
+    }
+
+    static func size(of field: HeaderField) -> Int {
+        return field.name.utf8.count + field.value.utf8.count + entryOverhead
+    }
+
+    /// Field at a 1-based index of the combined static and dynamic table.
+    func field(at index: Int) throws -> HeaderField {
+        if index >= 1 && index <= HeaderTable.staticEntries.count {
+            return HeaderTable.staticEntries[index - 1]
+        }
+
+        let dynamicIndex = index - HeaderTable.staticEntries.count - 1
+
+        guard dynamicIndex >= 0 && dynamicIndex < entries.count else {
+            throw HPACKError.invalidIndex
+        }
+
+        return entries[dynamicIndex]
+    }
+
+    /// Index of an entry matching `field` exactly, or else of one with the
+    /// same name, if any.
+    func search(_ field: HeaderField) -> (index: Int, matchesValue: Bool)? {
+        if let index = HeaderTable.staticPairIndex[field.name + "\0" + field.value] {
+            return (index, true)
+        }
+
+        var nameIndex = HeaderTable.staticNameIndex[field.name]
+
+        for (offset, entry) in entries.enumerated() where entry.name == field.name {
+            let index = HeaderTable.staticEntries.count + offset + 1
+
+            if entry.value == field.value {
+                return (index, true)
+            }
+
+            nameIndex = nameIndex ?? index
+        }
+
+        return nameIndex.map({ ($0, false) })
+    }
+
+    mutating func insert(_ field: HeaderField) {
+        let fieldSize = HeaderTable.size(of: field)
+
+        // An entry larger than the table empties it and is not added.
+        guard fieldSize <= maximumSize else {
+            entries.removeAll()
+            size = 0
+            return
+        }
+
+        evict(toFit: fieldSize)
+        entries.insert(field, at: 0)
+        size += fieldSize
+    }
+
+    private mutating func evict(toFit count: Int) {
+        while size + count > maximumSize, let last = entries.popLast() {
+            size -= HeaderTable.size(of: last)
+        }
+    }
+}
+
+/// Integer and string literal primitives (RFC 7541, sections 5.1 and 5.2).
+internal enum HPACKPrimitive {
+    static func encode(integer: Int, prefixBits: Int, flags: UInt8, into output: inout [UInt8]) {
+        let limit = (1 << prefixBits) - 1
+
+        guard integer >= limit else {
+            output.append(flags | UInt8(integer))
+            return
+        }
+
+        output.append(flags | UInt8(limit))
+        var remainder = integer - limit
+
+        while remainder >= 128 {
+            output.append(UInt8(remainder & 0x7f) | 0x80)
+            remainder >>= 7
+        }
+
+        output.append(UInt8(remainder))
+    }
+
+    static func decodeInteger(_ block: [UInt8], at offset: inout Int, prefixBits: Int) throws -> Int {
+        guard offset < block.count else {
+            throw HPACKError.truncatedBlock
+        }
+
+        let limit = (1 << prefixBits) - 1
+        var value = Int(block[offset]) & limit
+        offset += 1
+
+        guard value == limit else {
+            return value
+        }
+
+        var shift = 0
+
+        while true {
+            guard offset < block.count else {
+                throw HPACKError.truncatedBlock
+            }
+
+            let byte = block[offset]
+            offset += 1
+
+            // Anything past 28 bits of continuation is an attack, not a header.
+            guard shift <= 28 else {
+                throw HPACKError.integerOverflow
+            }
+
+            value += Int(byte & 0x7f) << shift
+            shift += 7
+
+            if byte & 0x80 == 0 {
+                return value
+            }
+        }
+    }
+
+    /// Huffman-codes `string` whenever that makes it shorter.
+    static func encode(string: String, into output: inout [UInt8]) {
+        let utf8 = string.utf8
+        let huffmanCount = Huffman.encodedCount(of: utf8)
+
+        if huffmanCount < utf8.count {
+            encode(integer: huffmanCount, prefixBits: 7, flags: 0x80, into: &output)
+            Huffman.encode(utf8, into: &output)
+        } else {
+            encode(integer: utf8.count, prefixBits: 7, flags: 0, into: &output)
+            output.append(contentsOf: utf8)
+        }
+    }
+
+    static func decodeString(_ block: [UInt8], at offset: inout Int) throws -> String {
+        guard offset < block.count else {
+            throw HPACKError.truncatedBlock
+        }
+
+        let huffman = block[offset] & 0x80 != 0
+        let length = try decodeInteger(block, at: &offset, prefixBits: 7)
+
+        guard length <= block.count - offset else {
+            throw HPACKError.truncatedBlock
+        }
+
+        let bytes = block[offset ..< offset + length]
+        offset += length
+
+        if huffman {
+            return String(decoding: try Huffman.decode(bytes), as: UTF8.self)
+        }
+
+        return String(decoding: bytes, as: UTF8.self)
+    }
+}
+
+internal final class HPACKEncoder {
+    /// Headers that are either secret or too short-lived to be worth a
+    /// table entry. Secrets are also marked never-indexed for proxies.
+    private static let neverIndexed: Set<String> = ["authorization", "proxy-authorization", "cookie", "set-cookie"]
+    private static let notIndexed: Set<String> = [
+        ":path", "content-length", "content-range", "date", "etag", "last-modified",
+        "if-modified-since", "if-none-match", "age", "location",
+    ]
+
+    private var table: HeaderTable
+    private var pendingSizeUpdate: Int?
+
+    /// Largest dynamic table this side is willing to keep for the peer.
+    private let preferredMaximumSize: Int
+
+    init(maximumSize: Int = 4096) {
+        self.preferredMaximumSize = maximumSize
+        self.table = HeaderTable(maximumSize: maximumSize)
+    }
+
+    /// Applies the peer's `SETTINGS_HEADER_TABLE_SIZE`; the change is
+    /// announced at the start of the next header block.
+    func setPeerMaximumSize(_ size: Int) {
+        let size = min(size, preferredMaximumSize)
+
+        guard size != table.maximumSize else {
+            return
+        }
+
+        table.maximumSize = size
+        pendingSizeUpdate = min(pendingSizeUpdate ?? size, size)
+    }
+
+    func encode(_ fields: [HeaderField], into output: inout [UInt8]) {
+        if let update = pendingSizeUpdate {
+            // A shrink followed by a growth must announce both.
+            if update < table.maximumSize {
+                HPACKPrimitive.encode(integer: update, prefixBits: 5, flags: 0x20, into: &output)
+            }
+
+            HPACKPrimitive.encode(integer: table.maximumSize, prefixBits: 5, flags: 0x20, into: &output)
+            pendingSizeUpdate = nil
+        }
+
+        for field in fields {
+            let match = table.search(field)
+
+            if let match = match, match.matchesValue {
+                HPACKPrimitive.encode(integer: match.index, prefixBits: 7, flags: 0x80, into: &output)
+                continue
+            }
+
+            let flags: UInt8
+            let prefixBits: Int
+
+            if HPACKEncoder.neverIndexed.contains(field.name) {
+                flags = 0x10
+                prefixBits = 4
+            } else if HPACKEncoder.notIndexed.contains(field.name)
+                || HeaderTable.size(of: field) > table.maximumSize / 2 {
+                flags = 0x00
+                prefixBits = 4
+            } else {
+                flags = 0x40
+                prefixBits = 6
+            }
+
+            let indexing = flags == 0x40
+
+            if let match = match {
+                HPACKPrimitive.encode(integer: match.index, prefixBits: prefixBits, flags: flags, into: &output)
+            } else {
+                output.append(flags)
+                HPACKPrimitive.encode(string: field.name, into: &output)
+            }
+
+            HPACKPrimitive.encode(string: field.value, into: &output)
+
+            if indexing {
+                table.insert(field)
+            }
+        }
+    }
+}
+
+internal final class HPACKDecoder {
+    private var table: HeaderTable
+
+    /// `SETTINGS_HEADER_TABLE_SIZE` this side advertised.
+    private let maximumSize: Int
+
+    init(maximumSize: Int = 4096) {
+        self.maximumSize = maximumSize
+        self.table = HeaderTable(maximumSize: maximumSize)
+    }
+
+    func decode(_ block: [UInt8]) throws -> [HeaderField] {
+        var fields: [HeaderField] = []
+        var offset = 0
+        var fieldSeen = false
+
+        while offset < block.count {
+            let byte = block[offset]
+
+            if byte & 0x80 != 0 {
+                let index = try HPACKPrimitive.decodeInteger(block, at: &offset, prefixBits: 7)
+                fields.append(try table.field(at: index))
+            } else if byte & 0x40 != 0 {
+                let field = try decodeLiteral(block, at: &offset, prefixBits: 6)
+                table.insert(field)
+                fields.append(field)
+            } else if byte & 0x20 != 0 {
+                // Size updates may only open a block.
+                guard !fieldSeen else {
+                    throw HPACKError.invalidTableSizeUpdate
+                }
+
+                let size = try HPACKPrimitive.decodeInteger(block, at: &offset, prefixBits: 5)
+
+                guard size <= maximumSize else {
+                    throw HPACKError.invalidTableSizeUpdate
+                }
+
+                table.maximumSize = size
+                continue
+            } else {
+                fields.append(try decodeLiteral(block, at: &offset, prefixBits: 4))
+            }
+
+            fieldSeen = true
+        }
+
+        return fields
+    }
+
+    private func decodeLiteral(_ block: [UInt8], at offset: inout Int, prefixBits: Int) throws -> HeaderField {
+        let index = try HPACKPrimitive.decodeInteger(block, at: &offset, prefixBits: prefixBits)
+        let name: String
+
+        if index == 0 {
+            name = try HPACKPrimitive.decodeString(block, at: &offset)
+        } else {
+            name = try table.field(at: index).name
+        }
+
+        let value = try HPACKPrimitive.decodeString(block, at: &offset)
+        return (name, value)
+    }
+}
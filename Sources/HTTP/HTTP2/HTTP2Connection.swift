@@ -0,0 +1,1043 @@
+import Core
+import IO
+import Venice
+import struct Foundation.Data
+
+/// One HTTP/2 connection (RFC 7540), from either side.
+///
+/// A single coroutine reads frames and dispatches them to their streams.
+/// Any number of coroutines write; header blocks are encoded and written
+/// under `writeLock` so HPACK state matches the order frames leave in.
+/// Requests on a server connection run in coroutines of their own, so a
+/// slow handler never holds up the other streams.
+internal final class HTTP2Connection {
+    enum Role {
+        case server
+        case client
+    }
+
+    let role: Role
+    let settings: HTTP2Settings
+
+    private let stream: DuplexStream
+    private let reader: FrameReader
+    private let encoder: HPACKEncoder
+    private let decoder: HPACKDecoder
+    private let writeLock: CoroutineLock
+    private let writeTimeout: Duration
+    private let idleTimeout: Duration
+
+    /// Signalled when send windows grow, streams end or the connection fails.
+    private let progress: Signal
+
+    private var peerInitialWindowSize = HTTP2Settings.defaultWindowSize
+    private var peerMaximumFrameSize = 16 * 1024
+    private var peerMaximumConcurrentStreams = Int.max
+
+    private var sendWindow = HTTP2Settings.defaultWindowSize
+    private var receiveWindow = HTTP2Settings.defaultWindowSize
+    private var unacknowledgedCount = 0
+
+    private var streams: [UInt32: HTTP2Stream] = [:]
+    private var nextStreamID: UInt32 = 1
+    private var lastPeerStreamID: UInt32 = 0
+
+    /// Handlers still running, including those of reset streams.
+    private var activeHandlers = 0
+
+    /// Streams the peer reset since `resetPeriodStart`.
+    private var peerResets = 0
+    private var resetPeriodStart = 0
+
+    /// Header block split across `CONTINUATION` frames.
+    private var pendingBlock: (stream: UInt32, endStream: Bool, block: [UInt8])?
+
+    private var goingAway = false
+    private(set) var failure: HTTP2Error?
+    private var reading: Coroutine?
+
+    init(
+        stream: DuplexStream,
+        role: Role,
+        settings: HTTP2Settings,
+        writeTimeout: Duration,
+        idleTimeout: Duration
+    ) throws {
+        self.stream = stream
+        self.role = role
+        self.settings = settings
+        self.writeTimeout = writeTimeout
+        self.idleTimeout = idleTimeout
+        self.reader = FrameReader(stream: stream, maximumFrameSize: settings.maximumFrameSize)
+        self.encoder = HPACKEncoder()
+        self.decoder = HPACKDecoder(maximumSize: settings.headerTableSize)
+        self.writeLock = try CoroutineLock()
+        self.progress = try Signal()
+    }
+
+    deinit {
+        reading?.cancel()
+    }
+
+    /// Whether new streams can be opened.
+    var isUsable: Bool {
+        return failure == nil && !goingAway
+    }
+
+    // MARK: Server
+
+    /// Serves requests until the client goes away or stays idle for
+    /// `idleTimeout`. `upgradedRequest` is the `Upgrade: h2c` request, which
+    /// is answered on stream 1.
+    func serve(upgradedRequest: Request?, respond: @escaping Respond) throws {
+        let group = Coroutine.Group()
+
+        defer {
+            group.cancel()
+        }
+
+        try writePreamble()
+
+        if let request = upgradedRequest {
+            request.version = .two
+
+            for name in HTTP2Message.connectionSpecific where name != "host" {
+                request.headers[name] = nil
+            }
+
+            let stream = try HTTP2Stream(
+                id: 1,
+                connection: self,
+                sendWindow: peerInitialWindowSize,
+                receiveWindow: settings.initialWindowSize
+            )
+
+            stream.remoteClosed = true
+            streams[1] = stream
+            lastPeerStreamID = 1
+
+            try dispatch(request, on: stream, in: group, with: respond)
+        }
+
+        try reader.readPreface(deadline: idleTimeout.fromNow())
+
+        try readFrames { [unowned self] stream, request in
+            try self.dispatch(request, on: stream, in: group, with: respond)
+        }
+    }
+
+    /// Runs `respond` in a coroutine of its own. The handler counts against
+    /// `maximumConcurrentStreams` until it returns, even once its stream is
+    /// reset, which cancels `request.cancellation`.
+    private func dispatch(
+        _ request: Request,
+        on stream: HTTP2Stream,
+        in group: Coroutine.Group,
+        with respond: @escaping Respond
+    ) throws {
+        let cancellation = Cancellation()
+        request.cancellation = cancellation
+        stream.cancellation = cancellation
+        activeHandlers += 1
+
+        do {
+            try group.addCoroutine { [unowned self] in
+                defer {
+                    self.activeHandlers -= 1
+                }
+
+                self.respond(to: request, on: stream, with: respond)
+            }
+        } catch {
+            activeHandlers -= 1
+            throw error
+        }
+    }
+
+    /// Applies the `HTTP2-Settings` header of an `Upgrade: h2c` request.
+    func applyUpgradeSettings(_ header: String) throws {
+        var base64 = String(header.map { $0 == "-" ? "+" : $0 == "_" ? "/" : $0 })
+
+        while base64.utf8.count % 4 != 0 {
+            base64 += "="
+        }
+
+        guard let payload = Data(base64Encoded: base64) else {
+            throw HTTP2Error.connectionError(.protocolError, "Invalid HTTP2-Settings header")
+        }
+
+        try applyPeerSettings([UInt8](payload))
+    }
+
+    private func respond(to request: Request, on stream: HTTP2Stream, with respond: Respond) {
+        request.interimResponder = { [unowned self] status, headers, deadline in
+            try self.writeHeaders(
+                HTTP2Message.fields(status: status, headers: headers),
+                on: stream,
+                endStream: false,
+                deadline: deadline
+            )
+        }
+
+        let response = respond(request)
+        request.interimResponder = nil
+
+        do {
+            try send(response, includingBody: request.method != .head, on: stream)
+
+            // The response is complete, so whatever body the client is
+            // still sending is not needed.
+            if !stream.remoteClosed && stream.failure == nil {
+                try reset(stream.id, code: .noError)
+            }
+        } catch HTTP2Error.streamReset {
+            return
+        } catch {
+            Logger.error("Error while sending HTTP/2 response.", error: error)
+            try? reset(stream.id, code: .internalError)
+        }
+    }
+
+    private func send(_ response: Response, includingBody: Bool, on stream: HTTP2Stream) throws {
+        let deadline = writeTimeout.fromNow()
+
+        if response.contentLength == nil, let length = response.body.fileLength {
+            response.contentLength = length
+        }
+
+        let fields = HTTP2Message.fields(for: response)
+
+        guard includingBody, response.contentLength != 0 else {
+            try writeHeaders(fields, on: stream, endStream: true, deadline: deadline)
+            return
+        }
+
+        try writeHeaders(fields, on: stream, endStream: false, deadline: deadline)
+        try sendBody(response.body, on: stream, deadline: deadline)
+    }
+
+    // MARK: Client
+
+    /// Sends the preface and starts reading responses.
+    func start() throws {
+        try write(FrameReader.preface, deadline: writeTimeout.fromNow())
+        try writePreamble()
+
+        reading = try Coroutine { [unowned self] in
+            do {
+                try self.readFrames { _, _ in }
+            } catch {
+                // Failures are reported to every open stream.
+            }
+        }
+    }
+
+    /// Sends `request` on a new stream and waits for the head of its
+    /// response. Interim responses go to `receiveInterimResponse`.
+    func send(_ request: Request, scheme: String, authority: String, timeout: Duration) throws -> Response {
+        let deadline = writeTimeout.fromNow()
+
+        let hasBody: Bool
+
+        switch request.body {
+        case .readable:
+            hasBody = (request.contentLength ?? 0) > 0 || request.isChunkEncoded
+        case .writable, .file:
+            hasBody = true
+        }
+
+        while streams.count >= peerMaximumConcurrentStreams && isUsable {
+            try progress.wait(deadline: deadline)
+        }
+
+        let stream = try openStream(
+            HTTP2Message.fields(for: request, scheme: scheme, authority: authority),
+            endStream: !hasBody,
+            deadline: deadline
+        )
+
+        if hasBody {
+            do {
+                try sendBody(request.body, on: stream, deadline: deadline)
+            } catch HTTP2Error.streamReset(.noError) {
+                // The server answered without reading the whole body.
+            }
+        }
+
+        let responseDeadline = timeout.fromNow()
+
+        while true {
+            if !stream.headerBlocks.isEmpty {
+                let fields = stream.headerBlocks.removeFirst()
+                let response: Response
+
+                do {
+                    response = try HTTP2Message.response(from: fields, body: .readable(HTTP2BodyReader(stream)))
+                } catch {
+                    try? reset(stream.id, code: .protocolError)
+                    throw error
+                }
+
+                if response.status.isInformational {
+                    request.receiveInterimResponse?(response)
+                    continue
+                }
+
+                stream.expectedLength = response.contentLength
+                return response
+            }
+
+            if let failure = stream.failure {
+                throw failure
+            }
+
+            guard !stream.remoteClosed else {
+                throw HTTP2Message.malformed
+            }
+
+            try stream.signal.wait(deadline: responseDeadline)
+        }
+    }
+
+    private func openStream(_ fields: [HeaderField], endStream: Bool, deadline: Deadline) throws -> HTTP2Stream {
+        return try writeLock.withLock { () -> HTTP2Stream in
+            if let failure = failure {
+                throw failure
+            }
+
+            guard !goingAway, nextStreamID <= 0x7fffffff else {
+                throw HTTP2Error.goingAway(.noError)
+            }
+
+            let stream = try HTTP2Stream(
+                id: nextStreamID,
+                connection: self,
+                sendWindow: peerInitialWindowSize,
+                receiveWindow: settings.initialWindowSize
+            )
+
+            nextStreamID += 2
+            streams[stream.id] = stream
+
+            // Stream identifiers must reach the peer in increasing order,
+            // so the header block goes out before the lock is released.
+            try writeHeaderBlock(fields, stream: stream.id, endStream: endStream, deadline: deadline)
+
+            if endStream {
+                stream.localClosed = true
+            }
+
+            return stream
+        }
+    }
+
+    /// Stops reading and closes the connection.
+    func close() {
+        reading?.cancel()
+        reading = nil
+        shutdown(.connectionClosed)
+        try? stream.close(deadline: writeTimeout.fromNow())
+    }
+
+    // MARK: Sending
+
+    private func sendBody(_ body: Body, on stream: HTTP2Stream, deadline: Deadline) throws {
+        let writer = HTTP2BodyWriter(stream)
+
+        switch body {
+        case let .readable(readable):
+            let buffer = UnsafeMutableRawBufferPointer.allocate(
+                byteCount: peerMaximumFrameSize,
+                alignment: MemoryLayout<UInt8>.alignment
+            )
+
+            defer {
+                buffer.deallocate()
+            }
+
+            while true {
+                let read = try readable.read(buffer, deadline: deadline)
+
+                guard !read.isEmpty else {
+                    break
+                }
+
+                try writer.write(read, deadline: deadline)
+            }
+        case let .writable(write):
+            try write(writer)
+        case let .file(file, range):
+            try file.write(range, to: writer, deadline: deadline)
+        }
+
+        try sendData(UnsafeRawBufferPointer(start: nil, count: 0), on: stream, endStream: true, deadline: deadline)
+    }
+
+    /// Writes `buffer` as `DATA` frames as fast as the windows allow.
+    func sendData(_ buffer: UnsafeRawBufferPointer, on stream: HTTP2Stream, endStream: Bool, deadline: Deadline) throws {
+        var offset = 0
+
+        repeat {
+            let count = try reserveWindow(on: stream, upTo: buffer.count - offset, deadline: deadline)
+            let last = endStream && offset + count == buffer.count
+
+            var frame: [UInt8] = []
+            frame.reserveCapacity(Frame.headerSize + count)
+
+            Frame.appendHeader(
+                kind: .data,
+                flags: last ? .endStream : [],
+                stream: stream.id,
+                length: count,
+                to: &frame
+            )
+
+            if count > 0 {
+                frame.append(contentsOf: buffer[offset ..< offset + count])
+            }
+
+            try write(frame, deadline: deadline)
+            offset += count
+
+            if last {
+                stream.localClosed = true
+                finish(stream)
+            }
+        } while offset < buffer.count
+    }
+
+    /// Takes up to `count` bytes out of the connection and stream windows,
+    /// parking until some are available.
+    private func reserveWindow(on stream: HTTP2Stream, upTo count: Int, deadline: Deadline) throws -> Int {
+        while true {
+            if let failure = stream.failure ?? failure {
+                throw failure
+            }
+
+            let available = min(count, sendWindow, stream.sendWindow, peerMaximumFrameSize)
+
+            if available > 0 || count == 0 {
+                let reserved = max(available, 0)
+                sendWindow -= reserved
+                stream.sendWindow -= reserved
+                return reserved
+            }
+
+            try progress.wait(deadline: deadline)
+        }
+    }
+
+    private func writeHeaders(_ fields: [HeaderField], on stream: HTTP2Stream, endStream: Bool, deadline: Deadline) throws {
+        try writeLock.withLock { () -> Void in
+            if let failure = stream.failure ?? failure {
+                throw failure
+            }
+
+            try writeHeaderBlock(fields, stream: stream.id, endStream: endStream, deadline: deadline)
+        }
+
+        if endStream {
+            stream.localClosed = true
+            finish(stream)
+        }
+    }
+
+    /// Encodes and writes a header block. Must be called with `writeLock` held.
+    private func writeHeaderBlock(_ fields: [HeaderField], stream: UInt32, endStream: Bool, deadline: Deadline) throws {
+        var block: [UInt8] = []
+        encoder.encode(fields, into: &block)
+
+        var output: [UInt8] = []
+        var offset = 0
+
+        repeat {
+            let count = min(block.count - offset, peerMaximumFrameSize)
+            var flags: Frame.Flags = []
+
+            if offset + count == block.count {
+                flags.insert(.endHeaders)
+            }
+
+            if offset == 0 && endStream {
+                flags.insert(.endStream)
+            }
+
+            Frame.appendHeader(
+                kind: offset == 0 ? .headers : .continuation,
+                flags: flags,
+                stream: stream,
+                length: count,
+                to: &output
+            )
+
+            output.append(contentsOf: block[offset ..< offset + count])
+            offset += count
+        } while offset < block.count
+
+        try writeUnlocked(output, deadline: deadline)
+    }
+
+    private func writePreamble() throws {
+        var output: [UInt8] = []
+        Frame(.settings, payload: settings.payload).encode(into: &output)
+
+        let increment = settings.connectionWindowSize - HTTP2Settings.defaultWindowSize
+
+        if increment > 0 {
+            receiveWindow += increment
+            appendWindowUpdate(stream: 0, increment: increment, to: &output)
+        }
+
+        try write(output, deadline: writeTimeout.fromNow())
+    }
+
+    private func appendWindowUpdate(stream: UInt32, increment: Int, to output: inout [UInt8]) {
+        var payload: [UInt8] = []
+        Frame.appendInteger(UInt32(increment), to: &payload)
+        Frame(.windowUpdate, stream: stream, payload: payload).encode(into: &output)
+    }
+
+    private func write(_ bytes: [UInt8], deadline: Deadline) throws {
+        try writeLock.withLock {
+            try writeUnlocked(bytes, deadline: deadline)
+        }
+    }
+
+    private func writeUnlocked(_ bytes: [UInt8], deadline: Deadline) throws {
+        try bytes.withUnsafeBytes { buffer in
+            try stream.write(buffer, deadline: deadline)
+        }
+    }
+
+    private func reset(_ id: UInt32, code: HTTP2ErrorCode) throws {
+        if let stream = streams.removeValue(forKey: id) {
+            stream.fail(.streamReset(code))
+            release(stream)
+            progress.broadcast()
+        }
+
+        var payload: [UInt8] = []
+        Frame.appendInteger(code.rawValue, to: &payload)
+
+        var output: [UInt8] = []
+        Frame(.resetStream, stream: id, payload: payload).encode(into: &output)
+        try write(output, deadline: writeTimeout.fromNow())
+    }
+
+    private func sendGoAway(_ code: HTTP2ErrorCode) {
+        goingAway = true
+
+        var payload: [UInt8] = []
+        Frame.appendInteger(lastPeerStreamID, to: &payload)
+        Frame.appendInteger(code.rawValue, to: &payload)
+
+        var output: [UInt8] = []
+        Frame(.goAway, payload: payload).encode(into: &output)
+        try? write(output, deadline: writeTimeout.fromNow())
+    }
+
+    /// Credits bytes the application has read back to the peer.
+    func consumed(_ count: Int, on stream: HTTP2Stream, deadline: Deadline) throws {
+        var output: [UInt8] = []
+
+        // Data of a forgotten stream was credited when it was forgotten.
+        guard !stream.isDetached else {
+            return
+        }
+
+        unacknowledgedCount += count
+
+        if unacknowledgedCount >= settings.connectionWindowSize / 2 {
+            appendWindowUpdate(stream: 0, increment: unacknowledgedCount, to: &output)
+            receiveWindow += unacknowledgedCount
+            unacknowledgedCount = 0
+        }
+
+        if !stream.remoteClosed {
+            stream.unacknowledgedCount += count
+
+            if stream.unacknowledgedCount >= settings.initialWindowSize / 2 {
+                appendWindowUpdate(stream: stream.id, increment: stream.unacknowledgedCount, to: &output)
+                stream.receiveWindow += stream.unacknowledgedCount
+                stream.unacknowledgedCount = 0
+            }
+        }
+
+        guard !output.isEmpty, failure == nil else {
+            return
+        }
+
+        try write(output, deadline: deadline)
+    }
+
+    /// Forgets a stream once both sides have ended it.
+    private func finish(_ stream: HTTP2Stream) {
+        guard stream.localClosed && stream.remoteClosed, streams[stream.id] === stream else {
+            return
+        }
+
+        streams[stream.id] = nil
+        release(stream)
+        progress.broadcast()
+    }
+
+    /// Credits the data of a forgotten stream the application has not read
+    /// back to the connection window, which it would otherwise never leave.
+    private func release(_ stream: HTTP2Stream) {
+        guard !stream.isDetached else {
+            return
+        }
+
+        stream.isDetached = true
+        try? consumedByConnection(stream.inboundCount)
+    }
+
+    private func shutdown(_ error: HTTP2Error) {
+        if failure == nil {
+            failure = error
+        }
+
+        for stream in streams.values {
+            stream.fail(error)
+            release(stream)
+        }
+
+        streams.removeAll()
+        progress.broadcast()
+    }
+
+    // MARK: Receiving
+
+    private func readFrames(onRequest: (HTTP2Stream, Request) throws -> Void) throws {
+        do {
+            while true {
+                let deadline: Deadline = streams.isEmpty ? idleTimeout.fromNow() : .never
+                let frame: Frame
+
+                do {
+                    frame = try reader.read(deadline: deadline)
+                } catch VeniceError.deadlineReached, SystemError.operationTimedOut {
+                    guard streams.isEmpty else {
+                        continue
+                    }
+
+                    sendGoAway(.noError)
+                    shutdown(.connectionClosed)
+                    return
+                }
+
+                try process(frame, onRequest: onRequest)
+            }
+        } catch HTTP2Error.connectionClosed {
+            shutdown(.connectionClosed)
+        } catch let HTTP2Error.connectionError(code, reason) {
+            sendGoAway(code)
+            shutdown(.connectionError(code, reason))
+            throw HTTP2Error.connectionError(code, reason)
+        } catch {
+            shutdown(.connectionClosed)
+            throw error
+        }
+    }
+
+    private func process(_ frame: Frame, onRequest: (HTTP2Stream, Request) throws -> Void) throws {
+        if let pending = pendingBlock {
+            guard frame.kind == .continuation, frame.stream == pending.stream else {
+                throw HTTP2Error.connectionError(.protocolError, "Header block interrupted")
+            }
+
+            let block = pending.block + frame.payload
+
+            // Decoded lists are checked later; this only bounds the memory
+            // an endless run of CONTINUATION frames can take.
+            guard block.count <= settings.maximumHeaderListSize else {
+                throw HTTP2Error.connectionError(.enhanceYourCalm, "Header block too large")
+            }
+
+            if frame.flags.contains(.endHeaders) {
+                pendingBlock = nil
+                try receiveHeaders(block, stream: pending.stream, endStream: pending.endStream, onRequest: onRequest)
+            } else {
+                pendingBlock = (pending.stream, pending.endStream, block)
+            }
+
+            return
+        }
+
+        guard let kind = frame.kind else {
+            // Unknown frame types must be ignored.
+            return
+        }
+
+        switch kind {
+        case .data:
+            try receiveData(frame)
+        case .headers:
+            guard frame.stream != 0 else {
+                throw HTTP2Error.connectionError(.protocolError, "HEADERS on stream 0")
+            }
+
+            let block = Array(try frame.content())
+            let endStream = frame.flags.contains(.endStream)
+
+            if frame.flags.contains(.endHeaders) {
+                try receiveHeaders(block, stream: frame.stream, endStream: endStream, onRequest: onRequest)
+            } else {
+                pendingBlock = (frame.stream, endStream, block)
+            }
+        case .priority:
+            guard frame.stream != 0 else {
+                throw HTTP2Error.connectionError(.protocolError, "PRIORITY on stream 0")
+            }
+
+            // Prioritisation is advisory; streams are served as they come.
+            if frame.payload.count != 5 {
+                try reset(frame.stream, code: .frameSizeError)
+            }
+        case .resetStream:
+            guard frame.stream != 0, frame.payload.count == 4 else {
+                throw HTTP2Error.connectionError(.protocolError, "Invalid RST_STREAM")
+            }
+
+            guard !isIdle(frame.stream) else {
+                throw HTTP2Error.connectionError(.protocolError, "RST_STREAM on idle stream")
+            }
+
+            if let stream = streams.removeValue(forKey: frame.stream) {
+                let code = HTTP2ErrorCode(rawValue: Frame.integer(in: frame.payload, at: 0)) ?? .internalError
+                stream.fail(.streamReset(code))
+                release(stream)
+                progress.broadcast()
+            }
+
+            try countPeerReset()
+        case .settings:
+            guard frame.stream == 0 else {
+                throw HTTP2Error.connectionError(.protocolError, "SETTINGS on a stream")
+            }
+
+            if frame.flags.contains(.acknowledge) {
+                guard frame.payload.isEmpty else {
+                    throw HTTP2Error.connectionError(.frameSizeError, "SETTINGS acknowledgement with a payload")
+                }
+
+                return
+            }
+
+            try applyPeerSettings(frame.payload)
+
+            var output: [UInt8] = []
+            Frame(.settings, flags: .acknowledge).encode(into: &output)
+            try write(output, deadline: writeTimeout.fromNow())
+        case .pushPromise:
+            throw HTTP2Error.connectionError(.protocolError, "Server push is disabled")
+        case .ping:
+            guard frame.stream == 0, frame.payload.count == 8 else {
+                throw HTTP2Error.connectionError(.frameSizeError, "Invalid PING")
+            }
+
+            if !frame.flags.contains(.acknowledge) {
+                var output: [UInt8] = []
+                Frame(.ping, flags: .acknowledge, payload: frame.payload).encode(into: &output)
+                try write(output, deadline: writeTimeout.fromNow())
+            }
+        case .goAway:
+            guard frame.stream == 0, frame.payload.count >= 8 else {
+                throw HTTP2Error.connectionError(.protocolError, "Invalid GOAWAY")
+            }
+
+            let lastStreamID = Frame.integer(in: frame.payload, at: 0) & 0x7fffffff
+            let code = HTTP2ErrorCode(rawValue: Frame.integer(in: frame.payload, at: 4)) ?? .internalError
+            receiveGoAway(lastStreamID: lastStreamID, code: code)
+        case .windowUpdate:
+            guard frame.payload.count == 4 else {
+                throw HTTP2Error.connectionError(.frameSizeError, "Invalid WINDOW_UPDATE")
+            }
+
+            let increment = Int(Frame.integer(in: frame.payload, at: 0) & 0x7fffffff)
+            try receiveWindowUpdate(increment, stream: frame.stream)
+        case .continuation:
+            throw HTTP2Error.connectionError(.protocolError, "CONTINUATION without a header block")
+        }
+    }
+
+    /// Whether `id` names a stream that was never opened.
+    private func isIdle(_ id: UInt32) -> Bool {
+        let peerInitiated = (id % 2 == 1) == (role == .server)
+        return peerInitiated ? id > lastPeerStreamID : id >= nextStreamID
+    }
+
+    private func receiveData(_ frame: Frame) throws {
+        guard frame.stream != 0, !isIdle(frame.stream) else {
+            throw HTTP2Error.connectionError(.protocolError, "DATA on an idle stream")
+        }
+
+        let length = frame.payload.count
+
+        guard length <= receiveWindow else {
+            throw HTTP2Error.connectionError(.flowControlError, "Connection window exceeded")
+        }
+
+        receiveWindow -= length
+
+        guard let stream = streams[frame.stream], !stream.remoteClosed else {
+            try consumedByConnection(length)
+            try reset(frame.stream, code: .streamClosed)
+            return
+        }
+
+        guard length <= stream.receiveWindow else {
+            try consumedByConnection(length)
+            try reset(frame.stream, code: .flowControlError)
+            return
+        }
+
+        stream.receiveWindow -= length
+
+        let content = try frame.content()
+
+        // Padding is never read by the application; credit it right away.
+        if content.count < length {
+            try consumed(length - content.count, on: stream, deadline: writeTimeout.fromNow())
+        }
+
+        stream.append(content)
+
+        if let expected = stream.expectedLength, stream.receivedLength > expected {
+            try reset(stream.id, code: .protocolError)
+            return
+        }
+
+        if frame.flags.contains(.endStream) {
+            if let expected = stream.expectedLength, stream.receivedLength != expected {
+                try reset(stream.id, code: .protocolError)
+                return
+            }
+
+            stream.remoteClosed = true
+            finish(stream)
+        }
+
+        stream.signal.broadcast()
+    }
+
+    private func consumedByConnection(_ count: Int) throws {
+        unacknowledgedCount += count
+
+        guard unacknowledgedCount >= settings.connectionWindowSize / 2, failure == nil else {
+            return
+        }
+
+        var output: [UInt8] = []
+        appendWindowUpdate(stream: 0, increment: unacknowledgedCount, to: &output)
+        receiveWindow += unacknowledgedCount
+        unacknowledgedCount = 0
+        try write(output, deadline: writeTimeout.fromNow())
+    }
+
+    private func receiveHeaders(
+        _ block: [UInt8],
+        stream id: UInt32,
+        endStream: Bool,
+        onRequest: (HTTP2Stream, Request) throws -> Void
+    ) throws {
+        let fields: [HeaderField]
+
+        do {
+            fields = try decoder.decode(block)
+        } catch {
+            throw HTTP2Error.connectionError(.compressionError, "Invalid header block: \(error)")
+        }
+
+        let listSize = fields.reduce(0) { $0 + HeaderTable.size(of: $1) }
+
+        if let stream = streams[id] {
+            guard !stream.remoteClosed else {
+                try reset(id, code: .streamClosed)
+                return
+            }
+
+            stream.headerBlocks.append(fields)
+
+            if endStream {
+                stream.remoteClosed = true
+                finish(stream)
+            }
+
+            stream.signal.broadcast()
+            return
+        }
+
+        guard role == .server else {
+            // A response to a stream this side already reset.
+            guard !isIdle(id) else {
+                throw HTTP2Error.connectionError(.protocolError, "HEADERS on an idle stream")
+            }
+
+            return
+        }
+
+        guard id % 2 == 1, id > lastPeerStreamID else {
+            throw HTTP2Error.connectionError(.protocolError, "HEADERS on a closed stream")
+        }
+
+        lastPeerStreamID = id
+
+        guard !goingAway else {
+            return
+        }
+
+        guard listSize <= settings.maximumHeaderListSize else {
+            try reset(id, code: .enhanceYourCalm)
+            return
+        }
+
+        guard streams.count < settings.maximumConcurrentStreams,
+            activeHandlers < settings.maximumConcurrentStreams
+        else {
+            try reset(id, code: .refusedStream)
+            return
+        }
+
+        let stream = try HTTP2Stream(
+            id: id,
+            connection: self,
+            sendWindow: peerInitialWindowSize,
+            receiveWindow: settings.initialWindowSize
+        )
+
+        stream.remoteClosed = endStream
+
+        let request: Request
+
+        do {
+            request = try HTTP2Message.request(from: fields, body: .readable(HTTP2BodyReader(stream)))
+        } catch {
+            try reset(id, code: .protocolError)
+            return
+        }
+
+        stream.expectedLength = request.contentLength
+
+        if endStream, let expected = stream.expectedLength, expected != 0 {
+            try reset(id, code: .protocolError)
+            return
+        }
+
+        streams[id] = stream
+        try onRequest(stream, request)
+    }
+
+    private func receiveWindowUpdate(_ increment: Int, stream id: UInt32) throws {
+        guard id != 0 else {
+            guard increment > 0 else {
+                throw HTTP2Error.connectionError(.protocolError, "WINDOW_UPDATE of 0")
+            }
+
+            sendWindow += increment
+
+            guard sendWindow <= HTTP2Settings.maximumWindowSize else {
+                throw HTTP2Error.connectionError(.flowControlError, "Connection window overflow")
+            }
+
+            progress.broadcast()
+            return
+        }
+
+        guard !isIdle(id) else {
+            throw HTTP2Error.connectionError(.protocolError, "WINDOW_UPDATE on an idle stream")
+        }
+
+        guard let stream = streams[id] else {
+            return
+        }
+
+        guard increment > 0 else {
+            try reset(id, code: .protocolError)
+            return
+        }
+
+        stream.sendWindow += increment
+
+        guard stream.sendWindow <= HTTP2Settings.maximumWindowSize else {
+            try reset(id, code: .flowControlError)
+            return
+        }
+
+        progress.broadcast()
+    }
+
+    private func applyPeerSettings(_ payload: [UInt8]) throws {
+        for (parameter, value) in try HTTP2Settings.parameters(in: payload) {
+            switch parameter {
+            case .headerTableSize:
+                encoder.setPeerMaximumSize(value)
+            case .enablePush:
+                guard value <= 1 else {
+                    throw HTTP2Error.connectionError(.protocolError, "Invalid SETTINGS_ENABLE_PUSH")
+                }
+            case .maximumConcurrentStreams:
+                peerMaximumConcurrentStreams = value
+            case .initialWindowSize:
+                guard value <= HTTP2Settings.maximumWindowSize else {
+                    throw HTTP2Error.connectionError(.flowControlError, "Invalid SETTINGS_INITIAL_WINDOW_SIZE")
+                }
+
+                // Open streams move by the difference, possibly below zero.
+                let delta = value - peerInitialWindowSize
+                peerInitialWindowSize = value
+
+                for stream in streams.values {
+                    stream.sendWindow += delta
+                }
+            case .maximumFrameSize:
+                guard value >= 16 * 1024 && value <= 16 * 1024 * 1024 - 1 else {
+                    throw HTTP2Error.connectionError(.protocolError, "Invalid SETTINGS_MAX_FRAME_SIZE")
+                }
+
+                peerMaximumFrameSize = value
+            case .maximumHeaderListSize:
+                // Responses are sent as the application built them.
+                break
+            }
+        }
+
+        progress.broadcast()
+    }
+
+    private func receiveGoAway(lastStreamID: UInt32, code: HTTP2ErrorCode) {
+        goingAway = true
+
+        // Streams the peer never saw can be retried elsewhere.
+        for (id, stream) in streams where id > lastStreamID && !isPeerInitiated(id) {
+            streams[id] = nil
+            stream.fail(.goingAway(code))
+            release(stream)
+        }
+
+        progress.broadcast()
+    }
+
+    /// Breaks the connection off once the peer resets more than
+    /// `maximumResetRate` streams in a second. Opening and resetting
+    /// streams costs a client nothing and the server a handler each
+    /// (rapid reset, CVE-2023-44487).
+    private func countPeerReset() throws {
+        let now = MonotonicClock.now()
+
+        if now - resetPeriodStart >= 1_000_000_000 {
+            resetPeriodStart = now
+            peerResets = 0
+        }
+
+        peerResets += 1
+
+        guard peerResets <= settings.maximumResetRate else {
+            throw HTTP2Error.connectionError(.enhanceYourCalm, "Too many streams reset")
+        }
+    }
+
+    private func isPeerInitiated(_ id: UInt32) -> Bool {
+        return (id % 2 == 1) == (role == .server)
+    }
+}
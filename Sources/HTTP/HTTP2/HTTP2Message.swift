@@ -0,0 +1,183 @@
+import Core
+
+/// Maps header lists to `Request` and `Response` and back (RFC 7540,
+/// section 8.1.2).
+internal enum HTTP2Message {
+    /// Headers that only mean something to an HTTP/1 connection.
+    static let connectionSpecific: Set<String> = [
+        "connection", "keep-alive", "proxy-connection", "transfer-encoding", "upgrade", "http2-settings", "host",
+    ]
+
+    /// Malformed messages reset their stream.
+    static let malformed = HTTP2Error.streamReset(.protocolError)
+
+    static func request(from fields: [HeaderField], body: Body) throws -> Request {
+        var method: String?
+        var scheme: String?
+        var authority: String?
+        var path: String?
+
+        let headers = try regularHeaders(in: fields) { name, value in
+            switch name {
+            case ":method" where method == nil:
+                method = value
+            case ":scheme" where scheme == nil:
+                scheme = value
+            case ":authority" where authority == nil:
+                authority = value
+            case ":path" where path == nil && !value.isEmpty:
+                path = value
+            default:
+                throw malformed
+            }
+        }
+
+        // CONNECT tunnels are not supported, so every request names a path.
+        guard let requestMethod = method, scheme != nil, let requestPath = path else {
+            throw malformed
+        }
+
+        let request = Request(
+            method: Request.Method(requestMethod),
+            uri: try URI(requestPath),
+            headers: headers,
+            version: .two,
+            body: body
+        )
+
+        if let authority = authority {
+            request.headers["Host"] = authority
+        }
+
+        return request
+    }
+
+    static func response(from fields: [HeaderField], body: Body) throws -> Response {
+        var status: Int?
+
+        let headers = try regularHeaders(in: fields) { name, value in
+            guard name == ":status", status == nil, let code = Int(value) else {
+                throw malformed
+            }
+
+            status = code
+        }
+
+        guard let statusCode = status else {
+            throw malformed
+        }
+
+        return Response(
+            status: Response.Status(statusCode: statusCode),
+            headers: headers,
+            version: .two,
+            body: body
+        )
+    }
+
+    static func fields(for request: Request, scheme: String, authority: String) -> [HeaderField] {
+        var path = request.uri.path ?? "/"
+
+        if path.isEmpty {
+            path = "/"
+        }
+
+        if let query = request.uri.query {
+            path += "?" + query
+        }
+
+        var fields: [HeaderField] = [
+            (":method", request.method.description),
+            (":scheme", scheme),
+            (":authority", request.host ?? authority),
+            (":path", path),
+        ]
+
+        appendRegularHeaders(request.headers, to: &fields)
+        return fields
+    }
+
+    static func fields(for response: Response) -> [HeaderField] {
+        var fields = self.fields(status: response.status, headers: response.headers)
+
+        for cookie in response.cookieHeaders {
+            fields.append(("set-cookie", cookie))
+        }
+
+        return fields
+    }
+
+    static func fields(status: Response.Status, headers: Headers) -> [HeaderField] {
+        var fields: [HeaderField] = [(":status", status.statusCodeString)]
+        appendRegularHeaders(headers, to: &fields)
+        return fields
+    }
+
+    private static func appendRegularHeaders(_ headers: Headers, to fields: inout [HeaderField]) {
+        for (name, value) in headers where !connectionSpecific.contains(name.original) {
+            if name.original == "te" && value.lowercased() != "trailers" {
+                continue
+            }
+
+            fields.append((name.original, value))
+        }
+    }
+
+    /// Collects the regular headers of `fields`, passing pseudo-headers,
+    /// which must come first, to `pseudoHeader`.
+    private static func regularHeaders(
+        in fields: [HeaderField],
+        pseudoHeader: (String, String) throws -> Void
+    ) throws -> Headers {
+        var headers: Headers = [:]
+        var regular = false
+
+        for (name, value) in fields {
+            if name.hasPrefix(":") {
+                guard !regular else {
+                    throw malformed
+                }
+
+                try pseudoHeader(name, value)
+                continue
+            }
+
+            regular = true
+
+            guard
+                !name.utf8.contains(where: { $0 >= 65 && $0 <= 90 }),
+                !connectionSpecific.contains(name) || name == "host",
+                name != "te" || value == "trailers"
+            else {
+                throw malformed
+            }
+
+            if let existing = headers[name] {
+                // Cookies may be split into crumbs for better compression.
+                headers[name] = existing + (name == "cookie" ? "; " : ", ") + value
+            } else {
+                headers[name] = value
+            }
+        }
+
+        return headers
+    }
+}
+
+extension Request {
+    /// `HTTP2-Settings` of an HTTP/1.1 request asking to continue as h2c.
+    /// Requests with a body are answered over HTTP/1.1 instead, which the
+    /// upgrade rules allow.
+    internal var h2cUpgradeSettings: String? {
+        guard
+            version.major == 1, version.minor >= 1,
+            upgrade?.lowercased() == "h2c",
+            let settings = headers["HTTP2-Settings"],
+            (contentLength ?? 0) == 0, !isChunkEncoded
+        else {
+            return nil
+        }
+
+        return settings
+    }
+}
@@ -0,0 +1,87 @@
+/// Limits this side of an HTTP/2 connection advertises to its peer.
+public struct HTTP2Settings {
+    /// Bytes of HPACK dynamic table kept for the peer's header blocks
+    public var headerTableSize: Int = 4096
+
+    /// Streams the peer may have open at once
+    public var maximumConcurrentStreams: Int = 100
+
+    /// Bytes the peer may send on a stream before it is read
+    public var initialWindowSize: Int = 1024 * 1024
+
+    /// Bytes the peer may send on the whole connection before it is read
+    public var connectionWindowSize: Int = 4 * 1024 * 1024
+
+    /// Largest frame payload accepted
+    public var maximumFrameSize: Int = 16 * 1024
+
+    /// Largest decoded header list accepted
+    public var maximumHeaderListSize: Int = 64 * 1024
+
+    /// Streams the peer may reset per second before the connection is
+    /// closed with `ENHANCE_YOUR_CALM`
+    public var maximumResetRate: Int = 200
+
+    public init() {}
+
+    public static var `default`: HTTP2Settings {
+        return HTTP2Settings()
+    }
+}
+
+extension HTTP2Settings {
+    internal enum Parameter : UInt16 {
+        case headerTableSize = 0x1
+        case enablePush = 0x2
+        case maximumConcurrentStreams = 0x3
+        case initialWindowSize = 0x4
+        case maximumFrameSize = 0x5
+        case maximumHeaderListSize = 0x6
+    }
+
+    internal static let defaultWindowSize = 65535
+    internal static let maximumWindowSize = Int(Int32.max)
+
+    /// Payload of the `SETTINGS` frame announcing these settings. Server
+    /// push is always disabled.
+    internal var payload: [UInt8] {
+        let parameters: [(Parameter, Int)] = [
+            (.headerTableSize, headerTableSize),
+            (.enablePush, 0),
+            (.maximumConcurrentStreams, maximumConcurrentStreams),
+            (.initialWindowSize, initialWindowSize),
+            (.maximumFrameSize, maximumFrameSize),
+            (.maximumHeaderListSize, maximumHeaderListSize),
+        ]
+
+        var payload: [UInt8] = []
+
+        for (parameter, value) in parameters {
+            payload.append(UInt8(parameter.rawValue >> 8))
+            payload.append(UInt8(parameter.rawValue & 0xff))
+            Frame.appendInteger(UInt32(value), to: &payload)
+        }
+
+        return payload
+    }
+
+    /// Parameters of a `SETTINGS` payload in order, unknown ones skipped.
+    internal static func parameters(in payload: [UInt8]) throws -> [(Parameter, Int)] {
+        guard payload.count % 6 == 0 else {
+            throw HTTP2Error.connectionError(.frameSizeError, "SETTINGS payload is not a multiple of 6")
+        }
+
+        var parameters: [(Parameter, Int)] = []
+
+        for offset in stride(from: 0, to: payload.count, by: 6) {
+            let identifier = UInt16(payload[offset]) << 8 | UInt16(payload[offset + 1])
+            let value = Int(Frame.integer(in: payload, at: offset + 2))
+
+            if let parameter = Parameter(rawValue: identifier) {
+                parameters.append((parameter, value))
+            }
+        }
+
+        return parameters
+    }
+}
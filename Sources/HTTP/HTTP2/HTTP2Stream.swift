@@ -0,0 +1,151 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+import Venice
+
+/// State of one stream of an `HTTP2Connection`.
+internal final class HTTP2Stream {
+    let id: UInt32
+    unowned let connection: HTTP2Connection
+
+    /// Signalled when headers or data arrive and when the stream fails.
+    let signal: Signal
+
+    var sendWindow: Int
+    var receiveWindow: Int
+    /// Bytes read by the application but not yet credited to the peer.
+    var unacknowledgedCount = 0
+
+    /// Header blocks received, oldest first. The first final one is the
+    /// head of the message, a later one holds its trailers.
+    var headerBlocks: [[HeaderField]] = []
+
+    private(set) var inbound: [UInt8] = []
+    private var inboundStart = 0
+
+    /// `content-length` announced by the peer, checked against the data.
+    var expectedLength: Int?
+    var receivedLength = 0
+
+    var remoteClosed = false
+    var localClosed = false
+    var failure: HTTP2Error?
+
+    /// Set once the connection forgot the stream. Its unread data was
+    /// credited back to the connection window then.
+    var isDetached = false
+
+    /// Cancelled when the stream fails, for the handler serving it.
+    var cancellation: Cancellation?
+
+    init(id: UInt32, connection: HTTP2Connection, sendWindow: Int, receiveWindow: Int) throws {
+        self.id = id
+        self.connection = connection
+        self.sendWindow = sendWindow
+        self.receiveWindow = receiveWindow
+        self.signal = try Signal()
+    }
+
+    var inboundCount: Int {
+        return inbound.count - inboundStart
+    }
+
+    func append(_ data: ArraySlice<UInt8>) {
+        if inboundStart > 0 && inboundStart == inbound.count {
+            inbound.removeAll(keepingCapacity: true)
+            inboundStart = 0
+        }
+
+        inbound.append(contentsOf: data)
+        receivedLength += data.count
+    }
+
+    /// Moves buffered data into `buffer` and returns how much was moved.
+    func take(into buffer: UnsafeMutableRawBufferPointer) -> Int {
+        let count = min(buffer.count, inboundCount)
+
+        guard count > 0, let destination = buffer.baseAddress else {
+            return 0
+        }
+
+        inbound.withUnsafeBytes { bytes in
+            _ = memcpy(destination, bytes.baseAddress! + inboundStart, count)
+        }
+
+        inboundStart += count
+
+        if inboundStart == inbound.count {
+            inbound.removeAll(keepingCapacity: true)
+            inboundStart = 0
+        }
+
+        return count
+    }
+
+    func fail(_ error: HTTP2Error) {
+        if failure == nil {
+            failure = error
+        }
+
+        cancellation?.cancel()
+        signal.broadcast()
+    }
+}
+
+/// Body of a message received on an HTTP/2 stream.
+///
+/// Window updates are sent as the application reads, so a slow reader
+/// stops the peer instead of buffering without bound.
+internal final class HTTP2BodyReader : Readable {
+    private let stream: HTTP2Stream
+    /// Streams only hold their connection unowned; a body may outlive
+    /// every other reference to it.
+    private let connection: HTTP2Connection
+
+    init(_ stream: HTTP2Stream) {
+        self.stream = stream
+        self.connection = stream.connection
+    }
+
+    func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        while true {
+            let count = stream.take(into: buffer)
+
+            if count > 0 {
+                try connection.consumed(count, on: stream, deadline: deadline)
+                return UnsafeRawBufferPointer(start: buffer.baseAddress, count: count)
+            }
+
+            if stream.remoteClosed {
+                return UnsafeRawBufferPointer(start: nil, count: 0)
+            }
+
+            if let failure = stream.failure {
+                throw failure
+            }
+
+            try stream.signal.wait(deadline: deadline)
+        }
+    }
+}
+
+/// Sends a message body as `DATA` frames, within the flow-control windows.
+internal final class HTTP2BodyWriter : Writable {
+    private let stream: HTTP2Stream
+
+    init(_ stream: HTTP2Stream) {
+        self.stream = stream
+    }
+
+    func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        guard !buffer.isEmpty else {
+            return
+        }
+
+        try stream.connection.sendData(buffer, on: stream, endStream: false, deadline: deadline)
+    }
+}
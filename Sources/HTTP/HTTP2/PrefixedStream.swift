@@ -0,0 +1,82 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+import IO
+import Venice
+
+/// Replays bytes already read from `stream` before reading from it again,
+/// so a connection can be inspected before choosing its protocol.
+internal final class PrefixedStream : DuplexStream {
+    private let stream: DuplexStream
+    private var prefix: [UInt8]
+
+    init(_ stream: DuplexStream, prefix: [UInt8]) {
+        self.stream = stream
+        self.prefix = prefix
+    }
+
+    func open(deadline: Deadline) throws {
+        try stream.open(deadline: deadline)
+    }
+
+    func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        guard !prefix.isEmpty else {
+            return try stream.read(buffer, deadline: deadline)
+        }
+
+        let count = min(buffer.count, prefix.count)
+
+        prefix.withUnsafeBytes { bytes in
+            _ = memcpy(buffer.baseAddress!, bytes.baseAddress!, count)
+        }
+
+        prefix.removeFirst(count)
+        return UnsafeRawBufferPointer(start: buffer.baseAddress, count: count)
+    }
+
+    func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        try stream.write(buffer, deadline: deadline)
+    }
+
+    func close(deadline: Deadline) throws {
+        try stream.close(deadline: deadline)
+    }
+
+    /// Reads from `stream` until its first bytes either match or rule out
+    /// the HTTP/2 connection preface. The bytes read are replayed by the
+    /// returned stream either way.
+    static func sniffPreface(on stream: DuplexStream, deadline: Deadline) throws -> (matches: Bool, stream: PrefixedStream) {
+        let preface = FrameReader.preface
+        var prefix: [UInt8] = []
+
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: preface.count,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+
+        defer {
+            buffer.deallocate()
+        }
+
+        while prefix.count < preface.count {
+            let remaining = UnsafeMutableRawBufferPointer(rebasing: buffer[..<(preface.count - prefix.count)])
+            let read = try stream.read(remaining, deadline: deadline)
+
+            guard !read.isEmpty else {
+                break
+            }
+
+            prefix.append(contentsOf: read)
+
+            guard prefix.elementsEqual(preface.prefix(prefix.count)) else {
+                return (false, PrefixedStream(stream, prefix: prefix))
+            }
+        }
+
+        return (prefix.count == preface.count, PrefixedStream(stream, prefix: prefix))
+    }
+}
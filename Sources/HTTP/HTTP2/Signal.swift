@@ -0,0 +1,73 @@
+import Venice
+
+/// Parks coroutines until another coroutine reports progress.
+///
+/// A signal with nobody waiting is lost, so waiters re-check their
+/// condition in a loop around `wait`.
+internal final class Signal {
+    private let channel: Channel<Void>
+
+    init() throws {
+        self.channel = try Channel()
+    }
+
+    func wait(deadline: Deadline) throws {
+        try channel.receive(deadline: deadline)
+    }
+
+    /// Resumes every coroutine parked in `wait`.
+    func broadcast() {
+        while (try? channel.send((), deadline: .immediately)) != nil {}
+    }
+}
+
+/// Mutual exclusion between coroutines, e.g. to keep frames that are written
+/// in several parts from interleaving. Ownership is handed to waiters in
+/// the order they arrived.
+internal final class CoroutineLock {
+    private let channel: Channel<Void>
+    private var locked = false
+    private var waiting = 0
+
+    init() throws {
+        self.channel = try Channel()
+    }
+
+    func lock() throws {
+        guard locked else {
+            locked = true
+            return
+        }
+
+        waiting += 1
+
+        do {
+            try channel.receive(deadline: .never)
+        } catch {
+            waiting -= 1
+            throw error
+        }
+    }
+
+    func unlock() {
+        while waiting > 0 {
+            waiting -= 1
+
+            if (try? channel.send((), deadline: .immediately)) != nil {
+                return
+            }
+        }
+
+        locked = false
+    }
+
+    func withLock<R>(_ body: () throws -> R) throws -> R {
+        try lock()
+
+        defer {
+            unlock()
+        }
+
+        return try body()
+    }
+}
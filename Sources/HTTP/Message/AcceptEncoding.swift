@@ -0,0 +1,33 @@
+import Foundation
+
+/// Parsed `Accept-Encoding` header (RFC 7231, section 5.3.4).
+internal struct AcceptEncoding {
+    private var qualities: [String: Double] = [:]
+    
+    internal init(_ header: String) {
+        for element in header.split(separator: ",") {
+            let parameters = element.split(separator: ";")
+            
+            guard let coding = parameters.first?.trimmingCharacters(in: .whitespaces).lowercased(),
+                !coding.isEmpty else {
+                continue
+            }
+            
+            let quality = parameters.dropFirst().lazy
+                .map({ $0.trimmingCharacters(in: .whitespaces) })
+                .first(where: { $0.hasPrefix("q=") })
+                .flatMap({ Double($0.dropFirst(2)) }) ?? 1
+            
+            qualities[coding] = quality
+        }
+    }
+    
+    /// Quality the client assigned to `coding`, falling back to `*`.
+    internal func quality(of coding: String) -> Double {
+        return qualities[coding] ?? qualities["*"] ?? 0
+    }
+    
+    internal func accepts(_ coding: String) -> Bool {
+        return quality(of: coding) > 0
+    }
+}
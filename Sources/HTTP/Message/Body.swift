@@ -5,6 +5,7 @@
 #endif
 
 import Core
+import IO
 import Venice
 
 public enum Body {
@@ -12,6 +13,9 @@ public enum Body {
    
     case readable(Readable)
     case writable(Write)
+    /// Sends `range` of `file`, or all of it if `nil`, without copying it
+    /// through userspace when the connection allows.
+    case file(File, range: Range<Int>?)
 }
 
 extension Body {
@@ -47,6 +51,10 @@ extension Body {
             let writable = WritableBuffer()
             try write(writable)
             return ReadableBytes(writable.buffer)
+        case let .file(file, range):
+            let writable = WritableBuffer()
+            try file.write(range, to: writable, deadline: .never)
+            return ReadableBytes(writable.buffer)
         }
     }
     
@@ -65,6 +73,23 @@ extension Body {
             return nil
         }
     }
+    
+    public var isFile: Bool {
+        switch self {
+        case .file: return true
+        default: return false
+        }
+    }
+    
+    /// Number of bytes a file body sends, known before it is written.
+    public var fileLength: Int? {
+        switch self {
+        case let .file(file, range):
+            return range?.count ?? file.size
+        default:
+            return nil
+        }
+    }
 }
 
 fileprivate final class ReadableBytes : Readable {
@@ -0,0 +1,150 @@
+import Core
+import IO
+import Venice
+
+/// Request body size limits for `Server`.
+///
+/// A request whose `Content-Length` exceeds its limit is answered with
+/// `413 Request Entity Too Large` before any of the body is read. Bodies of
+/// unknown length fail with `MessageError.bodyTooLarge` as soon as they
+/// cross the limit, and the server answers `413` in place of whatever the
+/// handler returned. Either way the connection is closed rather than
+/// drained.
+public struct BodyLimits {
+    /// Largest body accepted, unlimited when `nil`
+    public var maximumSize: Int?
+
+    /// Limits for requests whose path starts with a key, overriding
+    /// `maximumSize`. The longest matching prefix wins.
+    public var routes: [String: Int]
+
+    /// Bodies are read in full before the handler runs, kept in memory up
+    /// to this many bytes and in a temporary file past it. Bodies are
+    /// streamed to the handler when `nil`.
+    public var spoolThreshold: Int?
+
+    /// Directory of spooled bodies, `TemporaryFile.defaultDirectory` when `nil`
+    public var spoolDirectory: String?
+
+    /// Time allowed to receive a spooled body
+    public var spoolTimeout: Duration
+
+    public init(
+        maximumSize: Int? = 1024 * 1024,
+        routes: [String: Int] = [:],
+        spoolThreshold: Int? = nil,
+        spoolDirectory: String? = nil,
+        spoolTimeout: Duration = 5.minutes
+    ) {
+        self.maximumSize = maximumSize
+        self.routes = routes
+        self.spoolThreshold = spoolThreshold
+        self.spoolDirectory = spoolDirectory
+        self.spoolTimeout = spoolTimeout
+    }
+
+    /// Limit for the body of `request`.
+    public func maximumSize(for request: Request) -> Int? {
+        let path = request.uri.path ?? "/"
+
+        let route = routes
+            .filter({ path.hasPrefix($0.key) })
+            .max(by: { $0.key.count < $1.key.count })
+
+        return route?.value ?? maximumSize
+    }
+
+    /// Applies the limits to `request`, spooling its body if configured.
+    /// Throws `MessageError.bodyTooLarge` if the body is over its limit.
+    internal func apply(to request: Request) throws {
+        if let maximumSize = maximumSize(for: request) {
+            try request.limitBody(to: maximumSize)
+        }
+
+        if let spoolThreshold = spoolThreshold {
+            try request.spoolBody(
+                memoryLimit: spoolThreshold,
+                directory: spoolDirectory,
+                deadline: spoolTimeout.fromNow()
+            )
+        }
+    }
+}
+
+extension Request {
+    /// Makes reading the body past `maximumSize` bytes fail with
+    /// `MessageError.bodyTooLarge`, and fails right away if `Content-Length`
+    /// is already over it. Handlers call it to tighten or relax the limit
+    /// set by `Server` before they read.
+    public func limitBody(to maximumSize: Int) throws {
+        if let limiter = bodyLimiter {
+            limiter.maximumSize = maximumSize
+        } else if case let .readable(readable) = body {
+            let limiter = BodyLimiter(readable, maximumSize: maximumSize)
+            body = .readable(limiter)
+            bodyLimiter = limiter
+        }
+
+        if let contentLength = contentLength, contentLength > maximumSize {
+            bodyLimiter?.exceeded = true
+            throw MessageError.bodyTooLarge
+        }
+    }
+
+    /// Whether the body went over the limit set with `limitBody(to:)`.
+    public var bodyExceededLimit: Bool {
+        return bodyLimiter?.exceeded ?? false
+    }
+
+    /// Reads the whole body now, keeping up to `memoryLimit` bytes of it in
+    /// memory and the rest in a temporary file, and replaces it with what
+    /// was read. `Content-Length` is set to its size.
+    public func spoolBody(memoryLimit: Int, directory: String? = nil, deadline: Deadline) throws {
+        guard case let .readable(readable) = body else {
+            return
+        }
+
+        let spooled = SpooledBuffer(
+            memoryLimit: memoryLimit,
+            directory: directory,
+            account: memoryAccount
+        )
+        try pipe(from: readable, to: spooled, deadline: deadline)
+
+        body = .readable(spooled.makeReadable())
+        headers["Transfer-Encoding"] = nil
+        contentLength = spooled.size
+    }
+}
+
+/// Request body that fails once more than `maximumSize` bytes were read.
+internal final class BodyLimiter : Readable {
+    private let source: Readable
+    var maximumSize: Int
+    var exceeded = false
+    private var count = 0
+
+    internal init(_ source: Readable, maximumSize: Int) {
+        self.source = source
+        self.maximumSize = maximumSize
+    }
+
+    internal func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        guard !exceeded else {
+            throw MessageError.bodyTooLarge
+        }
+
+        let read = try source.read(buffer, deadline: deadline)
+        count += read.count
+
+        guard count <= maximumSize else {
+            exceeded = true
+            throw MessageError.bodyTooLarge
+        }
+
+        return read
+    }
+}
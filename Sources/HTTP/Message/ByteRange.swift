@@ -0,0 +1,254 @@
+import Core
+import IO
+import Venice
+
+/// A range of the `Range: bytes=...` header (RFC 7233).
+public enum ByteRange {
+    /// `first-last`, both inclusive.
+    case bounded(first: Int, last: Int)
+    /// `first-`, up to the end of the representation.
+    case from(first: Int)
+    /// `-length`, the final `length` bytes.
+    case suffix(length: Int)
+}
+
+extension ByteRange {
+    /// Offsets this range covers in a representation of `length` bytes, or
+    /// `nil` if it is not satisfiable.
+    public func resolved(length: Int) -> Range<Int>? {
+        switch self {
+        case let .bounded(first, last):
+            guard first < length else {
+                return nil
+            }
+
+            // `last` may be `Int.max`; adding to it traps.
+            return first ..< (last >= length - 1 ? length : last + 1)
+        case let .from(first):
+            guard first < length else {
+                return nil
+            }
+
+            return first ..< length
+        case let .suffix(suffixLength):
+            guard suffixLength > 0, length > 0 else {
+                return nil
+            }
+
+            return max(length - suffixLength, 0) ..< length
+        }
+    }
+
+    /// Parses the value of a `Range` header. Returns `nil` for anything but
+    /// a well-formed `bytes` range set, which servers must then ignore.
+    public static func ranges(from header: String) -> [ByteRange]? {
+        let parts = header.split(separator: "=", maxSplits: 1)
+
+        guard parts.count == 2, parts[0].lowercased() == "bytes" else {
+            return nil
+        }
+
+        var ranges: [ByteRange] = []
+
+        for element in parts[1].split(separator: ",") {
+            let spec = element.filter({ $0 != " " && $0 != "\t" })
+
+            guard let dash = spec.firstIndex(of: "-") else {
+                return nil
+            }
+
+            let firstText = spec[..<dash]
+            let lastText = spec[spec.index(after: dash)...]
+
+            switch (Int(firstText), Int(lastText)) {
+            case let (first?, last?) where first >= 0 && last >= first:
+                ranges.append(.bounded(first: first, last: last))
+            case let (first?, nil) where first >= 0 && lastText.isEmpty:
+                ranges.append(.from(first: first))
+            case let (nil, length?) where firstText.isEmpty && length >= 0:
+                ranges.append(.suffix(length: length))
+            default:
+                return nil
+            }
+        }
+
+        return ranges.isEmpty ? nil : ranges
+    }
+}
+
+extension Request {
+    /// Ranges requested through the `Range` header, if it is well formed.
+    public var byteRanges: [ByteRange]? {
+        return headers["Range"].flatMap(ByteRange.ranges(from:))
+    }
+}
+
+/// Representation whose bytes can be written starting at any offset.
+public protocol ByteRangeSource {
+    /// Total number of bytes.
+    var byteCount: Int { get }
+
+    /// Writes the bytes in `range` to `stream`.
+    func write(bytesIn range: Range<Int>, to stream: Writable, deadline: Deadline) throws
+
+    /// Body sending the bytes in `range` on its own.
+    func body(for range: Range<Int>) -> Body
+}
+
+extension File : ByteRangeSource {
+    public var byteCount: Int {
+        return size
+    }
+
+    public func write(bytesIn range: Range<Int>, to stream: Writable, deadline: Deadline) throws {
+        try write(Optional(range), to: stream, deadline: deadline)
+    }
+
+    public func body(for range: Range<Int>) -> Body {
+        return .file(self, range: range)
+    }
+}
+
+extension ReadableBuffer : ByteRangeSource {
+    public var byteCount: Int {
+        return buffer.count
+    }
+
+    public func write(bytesIn range: Range<Int>, to stream: Writable, deadline: Deadline) throws {
+        #if swift(>=3.2)
+            try stream.write(UnsafeRawBufferPointer(rebasing: buffer[range]), deadline: deadline)
+        #else
+            try stream.write(UnsafeRawBufferPointer(buffer[range]), deadline: deadline)
+        #endif
+    }
+
+    public func body(for range: Range<Int>) -> Body {
+        #if swift(>=3.2)
+            return .readable(ReadableBuffer(UnsafeRawBufferPointer(rebasing: buffer[range])))
+        #else
+            return .readable(ReadableBuffer(UnsafeRawBufferPointer(buffer[range])))
+        #endif
+    }
+}
+
+extension Response {
+    /// Most ranges honoured in one request; larger range sets get the
+    /// whole representation, which also defuses overlapping-range abuse.
+    public static var maximumByteRangeCount = 16
+
+    /// Answers `request` with the parts of `source` it asks for.
+    ///
+    /// Responds `200 OK` with everything when there is no usable `Range`
+    /// header or `If-Range` does not match the `ETag` or `Last-Modified`
+    /// in `headers`, `206 Partial Content` with one range or a
+    /// `multipart/byteranges` body for several, and
+    /// `416 Range Not Satisfiable` when no range overlaps the source.
+    /// `Content-Length` is always set; file sources stay zero-copy.
+    public convenience init(
+        request: Request,
+        source: ByteRangeSource,
+        headers: Headers = [:],
+        timeout: Duration = 5.minutes
+    ) {
+        let length = source.byteCount
+        var headers = headers
+        headers["Accept-Ranges"] = "bytes"
+
+        guard
+            request.method == .get,
+            Response.isIfRangeSatisfied(request, headers: headers),
+            let requested = request.byteRanges,
+            requested.count <= Response.maximumByteRangeCount
+        else {
+            self.init(status: .ok, headers: headers, version: .oneDotOne, body: source.body(for: 0 ..< length))
+            self.contentLength = length
+            return
+        }
+
+        let ranges = Response.coalesce(requested.compactMap({ $0.resolved(length: length) }))
+
+        guard let first = ranges.first else {
+            headers["Content-Range"] = "bytes */\(length)"
+            self.init(status: .requestedRangeNotSatisfiable, headers: headers)
+            return
+        }
+
+        guard ranges.count > 1 else {
+            headers["Content-Range"] = Response.contentRange(first, length: length)
+            self.init(status: .partialContent, headers: headers, version: .oneDotOne, body: source.body(for: first))
+            self.contentLength = first.count
+            return
+        }
+
+        let boundary = String(UInt64.random(in: .min ... .max), radix: 16)
+            + String(UInt64.random(in: .min ... .max), radix: 16)
+
+        let partType = headers["Content-Type"]
+
+        let heads = ranges.map { range -> String in
+            var head = "\r\n--" + boundary + "\r\n"
+
+            if let partType = partType {
+                head += "Content-Type: " + partType + "\r\n"
+            }
+
+            head += "Content-Range: " + Response.contentRange(range, length: length) + "\r\n\r\n"
+            return head
+        }
+
+        let tail = "\r\n--" + boundary + "--\r\n"
+
+        headers["Content-Type"] = "multipart/byteranges; boundary=" + boundary
+
+        self.init(
+            status: .partialContent,
+            headers: headers,
+            version: .oneDotOne,
+            body: .writable({ stream in
+                let deadline = timeout.fromNow()
+
+                for (head, range) in zip(heads, ranges) {
+                    try stream.write(head, deadline: deadline)
+                    try source.write(bytesIn: range, to: stream, deadline: deadline)
+                }
+
+                try stream.write(tail, deadline: deadline)
+            })
+        )
+
+        self.contentLength = zip(heads, ranges).reduce(tail.utf8.count) { $0 + $1.0.utf8.count + $1.1.count }
+    }
+
+    private static func contentRange(_ range: Range<Int>, length: Int) -> String {
+        return "bytes \(range.lowerBound)-\(range.upperBound - 1)/\(length)"
+    }
+
+    /// `If-Range` holds either a strong entity tag or the exact
+    /// `Last-Modified` date of the representation.
+    private static func isIfRangeSatisfied(_ request: Request, headers: Headers) -> Bool {
+        guard let ifRange = request.headers["If-Range"] else {
+            return true
+        }
+
+        if ifRange.hasPrefix("\"") {
+            return headers["ETag"] == ifRange
+        }
+
+        return headers["Last-Modified"] == ifRange
+    }
+
+    /// Sorts ranges and merges the ones that overlap or touch.
+    private static func coalesce(_ ranges: [Range<Int>]) -> [Range<Int>] {
+        var merged: [Range<Int>] = []
+
+        for range in ranges.sorted(by: { $0.lowerBound < $1.lowerBound }) {
+            if let last = merged.last, range.lowerBound <= last.upperBound {
+                merged[merged.count - 1] = last.lowerBound ..< max(last.upperBound, range.upperBound)
+            } else {
+                merged.append(range)
+            }
+        }
+
+        return merged
+    }
+}
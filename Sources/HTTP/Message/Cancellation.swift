@@ -0,0 +1,99 @@
+import Venice
+
+public enum CancellationError : Error {
+    case cancelled
+}
+
+extension CancellationError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .cancelled:
+            return "The operation was cancelled."
+        }
+    }
+}
+
+/// Tells work done for a request that nobody waits for its outcome anymore.
+///
+/// `Server` gives each request one that is cancelled when the client
+/// disconnects while the handler runs. Handlers pass it on to requests they
+/// send with `Client`, which are abandoned once it fires.
+public final class Cancellation {
+    public private(set) var isCancelled = false
+    private var observers: [Int: () -> Void] = [:]
+    private var nextObserver = 0
+
+    public init() {}
+
+    public func cancel() {
+        guard !isCancelled else {
+            return
+        }
+
+        isCancelled = true
+
+        let observers = self.observers
+        self.observers = [:]
+
+        for observer in observers.values {
+            observer()
+        }
+    }
+
+    /// Throws `CancellationError.cancelled` once cancelled.
+    public func check() throws {
+        if isCancelled {
+            throw CancellationError.cancelled
+        }
+    }
+
+    /// Calls `observer` when cancelled, or right away if it already is.
+    /// Returns a key for `removeObserver`.
+    @discardableResult
+    public func observe(_ observer: @escaping () -> Void) -> Int {
+        guard !isCancelled else {
+            observer()
+            return -1
+        }
+
+        nextObserver += 1
+        observers[nextObserver] = observer
+        return nextObserver
+    }
+
+    public func removeObserver(_ key: Int) {
+        observers[key] = nil
+    }
+
+    /// Runs `body` in a coroutine of its own and waits for it, canceling the
+    /// coroutine and throwing `CancellationError.cancelled` if this fires
+    /// first.
+    public func run<T>(_ body: @escaping () throws -> T) throws -> T {
+        try check()
+
+        let done = try Signal()
+        var result: Result<T, Error>?
+
+        let coroutine = try Coroutine {
+            result = Result(catching: body)
+            done.broadcast()
+        }
+
+        let key = observe({ done.broadcast() })
+
+        defer {
+            removeObserver(key)
+            coroutine.cancel()
+        }
+
+        while result == nil && !isCancelled {
+            try done.wait(deadline: .never)
+        }
+
+        guard let outcome = result else {
+            throw CancellationError.cancelled
+        }
+
+        return try outcome.get()
+    }
+}
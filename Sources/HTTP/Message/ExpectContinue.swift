@@ -0,0 +1,50 @@
+import Core
+import Venice
+
+extension Request {
+    /// Whether the client waits for `100 Continue` before sending the body.
+    public var expectsContinue: Bool {
+        guard version.major == 1, version.minor >= 1, let expect = headers["Expect"] else {
+            return false
+        }
+
+        return expect.lowercased() == "100-continue"
+    }
+}
+
+/// Request body that asks the client for its bytes on the first read.
+///
+/// Handlers that answer without touching the body never trigger
+/// `100 Continue`, so a rejected upload is never sent.
+internal final class ContinueReadable : Readable {
+    private let source: Readable
+    private var sendContinue: ((Deadline) throws -> Void)?
+
+    internal init(_ source: Readable, sendContinue: @escaping (Deadline) throws -> Void) {
+        self.source = source
+        self.sendContinue = sendContinue
+    }
+
+    internal func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        if let sendContinue = sendContinue {
+            self.sendContinue = nil
+            try sendContinue(deadline)
+        }
+
+        return try source.read(buffer, deadline: deadline)
+    }
+
+    /// Stops `100 Continue` from going out once the final response has
+    /// started. Returns `true` if it was never sent, in which case the body
+    /// may or may not follow and the connection cannot be reused.
+    internal func withdraw() -> Bool {
+        defer {
+            sendContinue = nil
+        }
+
+        return sendContinue != nil
+    }
+}
@@ -0,0 +1,32 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+/// IMF-fixdate formatting and parsing (RFC 7231, section 7.1.1.1).
+internal enum HTTPDate {
+    private static let format = "%a, %d %b %Y %H:%M:%S GMT"
+    
+    /// Formats seconds since the epoch, e.g. `Sun, 06 Nov 1994 08:49:37 GMT`.
+    internal static func string(from seconds: Int) -> String {
+        var time = time_t(seconds)
+        var parts = tm()
+        gmtime_r(&time, &parts)
+        
+        var buffer = [CChar](repeating: 0, count: 64)
+        strftime(&buffer, buffer.count, format, &parts)
+        return String(cString: buffer)
+    }
+    
+    /// Parses an IMF-fixdate into seconds since the epoch.
+    internal static func seconds(from string: String) -> Int? {
+        var parts = tm()
+        
+        guard strptime(string, format, &parts) != nil else {
+            return nil
+        }
+        
+        return Int(timegm(&parts))
+    }
+}
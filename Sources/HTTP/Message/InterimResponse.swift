@@ -0,0 +1,45 @@
+import Core
+import Venice
+
+extension Request {
+    /// Whether `sendInterimResponse` reaches the client: the request came
+    /// through `Server` from an HTTP/1.1 client and the final response has
+    /// not started.
+    public var acceptsInterimResponses: Bool {
+        return interimResponder != nil
+    }
+
+    /// Writes a `1xx` response to the connection ahead of the final response,
+    /// e.g. while the handler is still computing it.
+    ///
+    /// Interim responses are advisory, so this does nothing when
+    /// `acceptsInterimResponses` is `false`. `101 Switching Protocols` is a
+    /// final response and must go through `upgradeConnection` instead.
+    public func sendInterimResponse(
+        _ status: Response.Status,
+        headers: Headers = [:],
+        deadline: Deadline = 5.seconds.fromNow()
+    ) throws {
+        precondition(
+            status.isInformational && status != .switchingProtocols,
+            "Interim responses must have a 1xx status other than 101"
+        )
+
+        try interimResponder?(status, headers, deadline)
+    }
+
+    /// Sends `103 Early Hints` so the client can start fetching resources
+    /// the final response will need. Each element of `links` is a `Link`
+    /// value such as `</app.css>; rel=preload; as=style`.
+    public func sendEarlyHints(links: [String], deadline: Deadline = 5.seconds.fromNow()) throws {
+        guard !links.isEmpty else {
+            return
+        }
+
+        try sendInterimResponse(
+            .earlyHints,
+            headers: ["Link": links.joined(separator: ", ")],
+            deadline: deadline
+        )
+    }
+}
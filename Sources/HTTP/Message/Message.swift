@@ -9,6 +9,7 @@ public enum MessageError : Error {
     case unsupportedMediaType
     case noDefaultContentType
     case notContentRepresentable
+    case bodyTooLarge
     case valueNotFound(key: String)
     case incompatibleType(requestedType: Any.Type, actualType: Any.Type)
 }
@@ -26,6 +27,8 @@ extension MessageError : CustomStringConvertible {
             return "No Default Content Type"
         case .notContentRepresentable:
             return "No Content Representable"
+        case .bodyTooLarge:
+            return "Body Too Large"
         case let .valueNotFound(key):
             return "Value Not Found; Key: \(key)"
         case let .incompatibleType(requestedType, actualType):
@@ -128,7 +131,7 @@ extension Message {
             throw MessageError.noContentTypeHeader
         }
         
-        guard let readable = try? body.convertedToReadable() else {
+        guard let readable = try? accountedReadable() else {
             throw MessageError.noReadableBody
         }
         
@@ -140,10 +143,23 @@ extension Message {
         deadline: Deadline = 5.minutes.fromNow(),
         userInfo: [CodingUserInfoKey: Any] = [:]
     ) throws -> Content {
-        guard let readable = try? body.convertedToReadable() else {
+        guard let readable = try? accountedReadable() else {
             throw MessageError.noReadableBody
         }
         
         return try Content(from: readable, deadline: deadline)
     }
 }
+
+extension Message {
+    /// The body, tagged with the request's account so decoders charge it.
+    fileprivate func accountedReadable() throws -> Readable {
+        let readable = try body.convertedToReadable()
+        
+        guard let account = (self as? Request)?.memoryAccount else {
+            return readable
+        }
+        
+        return AccountedReadable(readable, account: account)
+    }
+}
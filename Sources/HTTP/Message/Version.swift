@@ -9,6 +9,7 @@ public struct Version {
 
     public static let oneDotZero = Version(major: 1, minor: 0)
     public static let oneDotOne = Version(major: 1, minor: 1)
+    public static let two = Version(major: 2, minor: 0)
 }
 
 extension Version : Hashable {
@@ -0,0 +1,74 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+/// Boyer-Moore-Horspool search for a multipart delimiter.
+///
+/// Delimiters are long and their bytes mostly differ from each other, so
+/// most probes skip ahead by nearly the whole delimiter length.
+internal struct BoundarySearch {
+    let pattern: [UInt8]
+    private var skip: [Int]
+
+    init(_ pattern: [UInt8]) {
+        precondition(!pattern.isEmpty, "Empty search pattern")
+
+        self.pattern = pattern
+        self.skip = Array(repeating: pattern.count, count: 256)
+
+        for index in 0 ..< pattern.count - 1 {
+            skip[Int(pattern[index])] = pattern.count - 1 - index
+        }
+    }
+
+    /// Offset of the first whole occurrence of the pattern in `haystack`.
+    func firstIndex(in haystack: UnsafeRawBufferPointer) -> Int? {
+        let count = pattern.count
+
+        guard haystack.count >= count, let baseAddress = haystack.baseAddress else {
+            return nil
+        }
+
+        let last = pattern[count - 1]
+        var index = 0
+
+        while index <= haystack.count - count {
+            let byte = haystack[index + count - 1]
+
+            if byte == last && matches(baseAddress + index, count: count - 1) {
+                return index
+            }
+
+            index += skip[Int(byte)]
+        }
+
+        return nil
+    }
+
+    /// Length of the prefix of `haystack` that no occurrence of the pattern
+    /// continuing past its end can start in. Call when `firstIndex` found
+    /// nothing.
+    func safePrefixLength(in haystack: UnsafeRawBufferPointer) -> Int {
+        guard let baseAddress = haystack.baseAddress else {
+            return 0
+        }
+
+        var index = max(haystack.count - (pattern.count - 1), 0)
+
+        while index < haystack.count {
+            if haystack[index] == pattern[0] && matches(baseAddress + index, count: haystack.count - index) {
+                return index
+            }
+
+            index += 1
+        }
+
+        return haystack.count
+    }
+
+    private func matches(_ bytes: UnsafeRawPointer, count: Int) -> Bool {
+        return pattern.withUnsafeBytes({ memcmp(bytes, $0.baseAddress!, count) == 0 })
+    }
+}
@@ -0,0 +1,411 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+import IO
+import Media
+import Venice
+import Foundation
+
+public enum MultipartError : Error {
+    case missingBoundary
+    case malformedBody
+    case headersTooLarge
+    case unexpectedEnd
+}
+
+extension MultipartError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .missingBoundary:
+            return "The message is not multipart or has no boundary."
+        case .malformedBody:
+            return "The multipart body is malformed."
+        case .headersTooLarge:
+            return "The headers of a part exceed the maximum header size."
+        case .unexpectedEnd:
+            return "The multipart body ended before its closing boundary."
+        }
+    }
+}
+
+/// Streaming `multipart/form-data` (RFC 7578) parser.
+///
+/// Parts are read one after the other straight from the body, through a
+/// single buffer of `bufferSize` bytes, so memory stays bounded however
+/// large the parts are. Use `MultipartPart.spool` to keep a part around,
+/// on disk once it grows past a limit.
+public final class MultipartParser {
+    private enum State {
+        case body
+        case delimiter
+        case finished
+    }
+
+    private let stream: Readable
+    private let search: BoundarySearch
+    private let maximumHeaderSize: Int
+    private let buffer: UnsafeMutableRawBufferPointer
+    private var start = 0
+    private var end = 0
+    /// Bytes before this index are part content.
+    private var contentEnd = 0
+    /// Whether a delimiter starts at `contentEnd`.
+    private var delimiterFound = false
+    private var state: State = .body
+    private var part = 0
+    /// Charged for the buffer and for parts spooled in memory.
+    fileprivate var account: MemoryAccount?
+
+    public init(
+        stream: Readable,
+        boundary: String,
+        bufferSize: Int = 64 * 1024,
+        maximumHeaderSize: Int = 16 * 1024
+    ) {
+        let delimiter = Array(("\r\n--" + boundary).utf8)
+
+        self.stream = stream
+        self.search = BoundarySearch(delimiter)
+        self.maximumHeaderSize = maximumHeaderSize
+
+        self.buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: max(bufferSize, delimiter.count * 2, 256),
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+
+        // The first delimiter has no line break of its own. Starting with
+        // one lets the preamble be skipped like any other content.
+        buffer[0] = 13
+        buffer[1] = 10
+        end = 2
+    }
+
+    /// Parses the body of `request`, which must be `multipart/form-data`.
+    public convenience init(_ request: Request, bufferSize: Int = 64 * 1024) throws {
+        guard
+            let contentType = request.headers["Content-Type"],
+            contentType.lowercased().hasPrefix("multipart/"),
+            let boundary = MultipartParser.parameters(of: contentType)["boundary"],
+            (1 ... 70).contains(boundary.utf8.count)
+        else {
+            throw MultipartError.missingBoundary
+        }
+
+        let stream = try request.body.convertedToReadable()
+        self.init(stream: stream, boundary: boundary, bufferSize: bufferSize)
+
+        if let account = request.memoryAccount {
+            self.account = account
+            try account.charge(buffer.count)
+        }
+    }
+
+    deinit {
+        account?.release(buffer.count)
+        buffer.deallocate()
+    }
+
+    /// Skips what is left of the current part and returns the next one, or
+    /// `nil` after the last.
+    public func nextPart(deadline: Deadline) throws -> MultipartPart? {
+        if state == .body {
+            try skipContent(deadline: deadline)
+        }
+
+        guard state == .delimiter else {
+            return nil
+        }
+
+        // Transport padding may follow the delimiter.
+        while true {
+            while start < end && (buffer[start] == 32 || buffer[start] == 9) {
+                start += 1
+            }
+
+            if end - start >= 2 {
+                break
+            }
+
+            guard try fill(deadline: deadline) else {
+                throw MultipartError.unexpectedEnd
+            }
+        }
+
+        switch (buffer[start], buffer[start + 1]) {
+        case (45, 45):
+            // The epilogue is left unread.
+            state = .finished
+            return nil
+        case (13, 10):
+            start += 2
+        default:
+            throw MultipartError.malformedBody
+        }
+
+        let headers = try readHeaders(deadline: deadline)
+        part += 1
+        state = .body
+        contentEnd = start
+        delimiterFound = false
+        return MultipartPart(parser: self, index: part, headers: headers)
+    }
+
+    fileprivate func read(
+        _ output: UnsafeMutableRawBufferPointer,
+        part: Int,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        guard part == self.part, state == .body, let baseAddress = output.baseAddress else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+
+        while start == contentEnd {
+            if delimiterFound {
+                start += search.pattern.count
+                state = .delimiter
+                return UnsafeRawBufferPointer(start: nil, count: 0)
+            }
+
+            try scan(deadline: deadline)
+        }
+
+        let count = min(contentEnd - start, output.count)
+        memcpy(baseAddress, buffer.baseAddress! + start, count)
+        start += count
+        return UnsafeRawBufferPointer(start: baseAddress, count: count)
+    }
+
+    private func skipContent(deadline: Deadline) throws {
+        while state == .body {
+            if start == contentEnd {
+                if delimiterFound {
+                    start += search.pattern.count
+                    state = .delimiter
+                    return
+                }
+
+                try scan(deadline: deadline)
+            }
+
+            start = contentEnd
+        }
+    }
+
+    /// Moves `contentEnd` forward, reading more of the body if needed.
+    private func scan(deadline: Deadline) throws {
+        while true {
+            let pending = UnsafeRawBufferPointer(rebasing: buffer[start ..< end])
+
+            if let index = search.firstIndex(in: pending) {
+                contentEnd = start + index
+                delimiterFound = true
+                return
+            }
+
+            contentEnd = start + search.safePrefixLength(in: pending)
+
+            if contentEnd > start {
+                return
+            }
+
+            guard try fill(deadline: deadline) else {
+                throw MultipartError.unexpectedEnd
+            }
+        }
+    }
+
+    private func readHeaders(deadline: Deadline) throws -> Headers {
+        var headers: Headers = [:]
+        var size = 0
+
+        while true {
+            guard let lineEnd = try lineEnd(deadline: deadline) else {
+                throw MultipartError.headersTooLarge
+            }
+
+            let line = String(decoding: UnsafeRawBufferPointer(rebasing: buffer[start ..< lineEnd]), as: UTF8.self)
+            size += lineEnd + 2 - start
+            start = lineEnd + 2
+
+            guard size <= maximumHeaderSize else {
+                throw MultipartError.headersTooLarge
+            }
+
+            if line.isEmpty {
+                return headers
+            }
+
+            guard let colon = line.firstIndex(of: ":") else {
+                throw MultipartError.malformedBody
+            }
+
+            let field = Headers.Field(String(line[..<colon]).trimmingCharacters(in: .whitespaces))
+            let value = String(line[line.index(after: colon)...]).trimmingCharacters(in: .whitespaces)
+
+            if let existing = headers[field] {
+                headers[field] = existing + ", " + value
+            } else {
+                headers[field] = value
+            }
+        }
+    }
+
+    /// Index of the `CRLF` ending the line at `start`, or `nil` if the line
+    /// does not fit in the buffer.
+    private func lineEnd(deadline: Deadline) throws -> Int? {
+        var index = start
+
+        while true {
+            while index + 1 < end {
+                if buffer[index] == 13 && buffer[index + 1] == 10 {
+                    return index
+                }
+
+                index += 1
+            }
+
+            let offset = start
+
+            guard end - start < buffer.count else {
+                return nil
+            }
+
+            guard try fill(deadline: deadline) else {
+                throw MultipartError.unexpectedEnd
+            }
+
+            index -= offset - start
+        }
+    }
+
+    /// Moves pending bytes to the front of the buffer and reads more after
+    /// them. Returns `false` once the body has ended.
+    private func fill(deadline: Deadline) throws -> Bool {
+        if start > 0 {
+            let pending = end - start
+            memmove(buffer.baseAddress!, buffer.baseAddress! + start, pending)
+            contentEnd -= start
+            start = 0
+            end = pending
+        }
+
+        guard end < buffer.count else {
+            return true
+        }
+
+        let read = try stream.read(UnsafeMutableRawBufferPointer(rebasing: buffer[end...]), deadline: deadline)
+        end += read.count
+        return !read.isEmpty
+    }
+
+    /// Parameters of a header value like `form-data; name="file"`. Names are
+    /// lowercased and quoted values unescaped.
+    internal static func parameters(of value: String) -> [String: String] {
+        var parameters: [String: String] = [:]
+        var characters = Substring(value)
+
+        // Skip the value itself.
+        guard let semicolon = characters.firstIndex(of: ";") else {
+            return parameters
+        }
+
+        characters = characters[characters.index(after: semicolon)...]
+
+        while !characters.isEmpty {
+            let name = characters.prefix(while: { $0 != "=" && $0 != ";" })
+            characters = characters[name.endIndex...]
+            var parameter = ""
+
+            if characters.first == "=" {
+                characters = characters.dropFirst().drop(while: { $0 == " " || $0 == "\t" })
+
+                if characters.first == "\"" {
+                    characters = characters.dropFirst()
+
+                    while let character = characters.popFirst(), character != "\"" {
+                        if character == "\\", let escaped = characters.popFirst() {
+                            parameter.append(escaped)
+                        } else {
+                            parameter.append(character)
+                        }
+                    }
+                }
+
+                let rest = characters.prefix(while: { $0 != ";" })
+                parameter += rest.trimmingCharacters(in: .whitespaces)
+                characters = characters[rest.endIndex...]
+            }
+
+            let key = name.trimmingCharacters(in: .whitespaces).lowercased()
+
+            if !key.isEmpty {
+                parameters[key] = parameter
+            }
+
+            characters = characters.dropFirst()
+        }
+
+        return parameters
+    }
+}
+
+/// A part of a multipart body, readable until the next part is requested.
+public final class MultipartPart : Readable {
+    public let headers: Headers
+    private let parser: MultipartParser
+    private let index: Int
+    private let disposition: [String: String]
+
+    fileprivate init(parser: MultipartParser, index: Int, headers: Headers) {
+        self.parser = parser
+        self.index = index
+        self.headers = headers
+        self.disposition = headers["Content-Disposition"].map(MultipartParser.parameters(of:)) ?? [:]
+    }
+
+    /// Form field name
+    public var name: String? {
+        return disposition["name"]
+    }
+
+    /// Name of the uploaded file, if the part is one
+    public var filename: String? {
+        if let encoded = disposition["filename*"], let quote = encoded.range(of: "''") {
+            return encoded[quote.upperBound...].removingPercentEncoding
+        }
+
+        return disposition["filename"]
+    }
+
+    public var contentType: MediaType? {
+        return headers["Content-Type"].flatMap({ try? MediaType(string: $0) })
+    }
+
+    public func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        return try parser.read(buffer, part: index, deadline: deadline)
+    }
+
+    /// Reads the rest of the part into memory, or into a temporary file
+    /// once it grows past `memoryLimit` bytes.
+    public func spool(
+        memoryLimit: Int = 1024 * 1024,
+        directory: String? = nil,
+        deadline: Deadline
+    ) throws -> SpooledBuffer {
+        let spooled = SpooledBuffer(
+            memoryLimit: memoryLimit,
+            directory: directory,
+            account: parser.account
+        )
+
+        try pipe(from: self, to: spooled, deadline: deadline)
+        return spooled
+    }
+}
@@ -17,11 +17,33 @@ internal class Parser {
         var bodyBuffer = UnsafeRawBufferPointer(start: nil, count: 0)
         
         private let parser: Parser
+        private var detached: UnsafeMutableRawBufferPointer?
         
         public init(parser: Parser) {
             self.parser = parser
         }
         
+        deinit {
+            detached?.deallocate()
+        }
+        
+        /// Copies the unread part of a complete body out of the parser's
+        /// buffer, so the parser can move on to the next message.
+        func detach() {
+            guard complete, detached == nil, let baseAddress = bodyBuffer.baseAddress, !bodyBuffer.isEmpty else {
+                return
+            }
+            
+            let copy = UnsafeMutableRawBufferPointer.allocate(
+                byteCount: bodyBuffer.count,
+                alignment: MemoryLayout<UInt8>.alignment
+            )
+            
+            memcpy(copy.baseAddress!, baseAddress, bodyBuffer.count)
+            detached = copy
+            bodyBuffer = UnsafeRawBufferPointer(copy)
+        }
+        
         func read(
             _ buffer: UnsafeMutableRawBufferPointer,
             deadline: Deadline
@@ -99,6 +121,17 @@ internal class Parser {
     private var context = Context()
     private var bytes: [UInt8] = []
     
+    /// Charged for the start line and header bytes buffered while they are
+    /// parsed. Parsing fails once it is over budget.
+    internal var account: MemoryAccount?
+    private var charged = 0
+    
+    /// Bytes read from the stream so far
+    internal private(set) var bytesRead = 0
+    
+    /// `MonotonicClock` time the current message started arriving at
+    internal private(set) var messageStart = 0
+    
     public init(stream: Readable, bufferSize: Int = 2048, type: http_parser_type) {
         self.stream = stream
         self.bufferSize = bufferSize
@@ -131,6 +164,7 @@ internal class Parser {
     }
     
     deinit {
+        account?.release(charged)
         buffer.deallocate()
     }
     
@@ -140,6 +174,7 @@ internal class Parser {
     
     func read(deadline: Deadline) throws {
         let read = try stream.read(buffer, deadline: deadline)
+        bytesRead += read.count
         try parse(read)
     }
     
@@ -227,8 +262,14 @@ internal class Parser {
             }
             
             bytes = []
+            account?.release(charged)
+            charged = 0
             state = newState
             
+            if state == .messageBegin {
+                messageStart = MonotonicClock.now()
+            }
+            
             if state == .messageComplete {
                 context.bodyStream?.complete = true
                 context = Context()
@@ -244,6 +285,14 @@ internal class Parser {
             context.bodyStream?.bodyBuffer = data
         default:
             bytes.append(contentsOf: data)
+            
+            if let account = account {
+                charged += data.count
+                
+                guard (try? account.charge(data.count)) != nil else {
+                    return 1
+                }
+            }
         }
         
         return 0
@@ -5,6 +5,7 @@ import Venice
 
 public final class Request : Message {
     public typealias UpgradeConnection = (Response, DuplexStream) throws -> Void
+    public typealias ReceiveInterimResponse = (Response) -> Void
     
     public var method: Method
     public var uri: URI
@@ -15,6 +16,33 @@ public final class Request : Message {
     public var storage: Storage = [:]
     public var upgradeConnection: UpgradeConnection?
     
+    /// Fires when nobody waits for the response anymore. Set by `Server`
+    /// for the requests it receives; `Client` abandons requests it sends
+    /// once theirs fires.
+    public var cancellation: Cancellation?
+    
+    /// Charged for what is built out of the request, such as its decoded
+    /// content. Set by `Server` when memory accounting is on.
+    public var memoryAccount: MemoryAccount?
+    
+    /// Span the request belongs to. `Server` sets it from the request's
+    /// `traceparent` or the trace it records; `Client` sends it as the
+    /// `traceparent` of requests it is set on, so handlers propagate it
+    /// by copying it to the requests they send.
+    public var traceContext: TraceContext?
+    
+    /// Set by `Server` for requests it traces.
+    internal var trace: Trace?
+    
+    /// Called by `Client` with every `1xx` response that precedes the final one.
+    public var receiveInterimResponse: ReceiveInterimResponse?
+    
+    /// Set by `Server` while the final response has not started.
+    internal var interimResponder: ((Response.Status, Headers, Deadline) throws -> Void)?
+    
+    /// Set by `limitBody(to:)`.
+    internal var bodyLimiter: BodyLimiter?
+    
     public init(
         method: Method,
         uri: URI,
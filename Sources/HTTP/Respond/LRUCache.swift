@@ -0,0 +1,128 @@
+/// Least recently used cache bounded by a total cost and an entry count.
+internal final class LRUCache<Key : Hashable, Value> {
+    private final class Node {
+        let key: Key
+        var value: Value
+        var cost: Int
+        var previous: Node?
+        var next: Node?
+        
+        init(key: Key, value: Value, cost: Int) {
+            self.key = key
+            self.value = value
+            self.cost = cost
+        }
+    }
+    
+    internal let capacity: Int
+    internal let countLimit: Int
+    internal private(set) var totalCost = 0
+    
+    private var nodes: [Key: Node] = [:]
+    private var head: Node?
+    private var tail: Node?
+    
+    internal init(capacity: Int, countLimit: Int = .max) {
+        self.capacity = capacity
+        self.countLimit = countLimit
+    }
+    
+    internal var count: Int {
+        return nodes.count
+    }
+    
+    /// Returns the value for `key` and marks it as most recently used.
+    internal func value(forKey key: Key) -> Value? {
+        guard let node = nodes[key] else {
+            return nil
+        }
+        
+        moveToFront(node)
+        return node.value
+    }
+    
+    /// Inserts or replaces the value for `key`, evicting the least recently
+    /// used entries until the cache fits. Values costlier than the whole
+    /// capacity are not cached.
+    internal func setValue(_ value: Value, forKey key: Key, cost: Int) {
+        removeValue(forKey: key)
+        
+        guard cost <= capacity, countLimit > 0 else {
+            return
+        }
+        
+        let node = Node(key: key, value: value, cost: cost)
+        nodes[key] = node
+        totalCost += cost
+        insertAtFront(node)
+        
+        while totalCost > capacity || nodes.count > countLimit, let last = tail {
+            remove(last)
+        }
+    }
+    
+    @discardableResult
+    internal func removeValue(forKey key: Key) -> Value? {
+        guard let node = nodes[key] else {
+            return nil
+        }
+        
+        remove(node)
+        return node.value
+    }
+    
+    internal func removeAll(where shouldRemove: (Key) -> Bool) {
+        for (key, node) in nodes where shouldRemove(key) {
+            remove(node)
+        }
+    }
+    
+    internal func removeAll() {
+        nodes.removeAll()
+        head = nil
+        tail = nil
+        totalCost = 0
+    }
+    
+    private func remove(_ node: Node) {
+        unlink(node)
+        nodes[node.key] = nil
+        totalCost -= node.cost
+    }
+    
+    private func moveToFront(_ node: Node) {
+        guard head !== node else {
+            return
+        }
+        
+        unlink(node)
+        insertAtFront(node)
+    }
+    
+    private func insertAtFront(_ node: Node) {
+        node.next = head
+        head?.previous = node
+        head = node
+        
+        if tail == nil {
+            tail = node
+        }
+    }
+    
+    private func unlink(_ node: Node) {
+        if let previous = node.previous {
+            previous.next = node.next
+        } else if head === node {
+            head = node.next
+        }
+        
+        if let next = node.next {
+            next.previous = node.previous
+        } else if tail === node {
+            tail = node.previous
+        }
+        
+        node.previous = nil
+        node.next = nil
+    }
+}
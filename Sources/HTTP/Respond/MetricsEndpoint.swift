@@ -0,0 +1,37 @@
+import Core
+
+/// Serves the metrics of a registry in the Prometheus text format.
+///
+/// ```swift
+/// let metrics = MetricsEndpoint()
+///
+/// let server = Server { request in
+///     if request.uri.path == "/metrics" {
+///         return metrics.respond(to: request)
+///     }
+///
+///     return Response(status: .notFound)
+/// }
+/// ```
+public struct MetricsEndpoint {
+    public let registry: MetricsRegistry
+
+    public init(registry: MetricsRegistry = .default) {
+        self.registry = registry
+    }
+
+    public func respond(to request: Request) -> Response {
+        switch request.method {
+        case .get, .head:
+            break
+        default:
+            return Response(status: .methodNotAllowed, headers: ["Allow": "GET, HEAD"])
+        }
+
+        return Response(
+            status: .ok,
+            headers: ["Content-Type": MetricsRegistry.prometheusContentType],
+            body: registry.prometheusExposition()
+        )
+    }
+}
@@ -0,0 +1,395 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+import Foundation
+import IO
+import Media
+import Venice
+
+/// Serves the files below a root directory.
+///
+/// Files up to `maximumCachedFileSize` bytes are kept in memory, in an LRU
+/// cache bounded by `cacheCapacity` bytes, together with their response
+/// headers, so a cache hit costs neither a `stat` nor a `read`. Larger files
+/// are kept open in the same cache and sent with `Body.file`. `.br` and
+/// `.gz` siblings of a file are served to clients that accept them, and
+/// conditional requests are answered with `304 Not Modified` from the
+/// cached validators.
+///
+/// On Linux cached entries are dropped as soon as inotify reports a change.
+/// Elsewhere they are reloaded once they are `revalidationInterval` seconds old.
+///
+/// ```swift
+/// let files = StaticFiles(root: "/var/www")
+/// let server = Server(respond: files.respond)
+/// ```
+public final class StaticFiles {
+    public let root: String
+    public let indexFile: String
+    public let maximumCachedFileSize: Int
+    public let cacheCapacity: Int
+    public let revalidationInterval: Int
+
+    private let cache: LRUCache<String, Entry>
+    private var watcher: DirectoryWatcher?
+    private var watching: Coroutine?
+    private var watcherFailed = false
+
+    public init(
+        root: String,
+        indexFile: String = "index.html",
+        maximumCachedFileSize: Int = 64 * 1024,
+        cacheCapacity: Int = 32 * 1024 * 1024,
+        revalidationInterval: Int = 1
+    ) {
+        self.root = root.hasSuffix("/") ? String(root.dropLast()) : root
+        self.indexFile = indexFile
+        self.maximumCachedFileSize = maximumCachedFileSize
+        self.cacheCapacity = cacheCapacity
+        self.revalidationInterval = revalidationInterval
+        self.cache = LRUCache(capacity: cacheCapacity, countLimit: 1024)
+    }
+
+    deinit {
+        watching?.cancel()
+    }
+
+    public func respond(to request: Request) -> Response {
+        switch request.method {
+        case .get, .head:
+            break
+        default:
+            return Response(status: .methodNotAllowed, headers: ["Allow": "GET, HEAD"])
+        }
+
+        guard let path = resolve(request.uri.path ?? "/") else {
+            return Response(status: .notFound)
+        }
+
+        let entry: Entry
+
+        do {
+            entry = try lookup(path)
+        } catch SystemError.noSuchFileOrDirectory, SystemError.notADirectory, FileError.notRegularFile {
+            return Response(status: .notFound)
+        } catch SystemError.permissionDenied {
+            return Response(status: .forbidden)
+        } catch {
+            Logger.error("Error while loading static file.", error: error)
+            return Response(status: .internalServerError)
+        }
+
+        let variant = entry.variant(accepting: request.headers["Accept-Encoding"])
+
+        if variant.isNotModified(for: request) {
+            return Response(status: .notModified, headers: variant.validators)
+        }
+
+        return Response(request: request, source: variant.source, headers: variant.headers)
+    }
+
+    /// Maps a request path to a file below `root`, rejecting `..` segments.
+    private func resolve(_ path: String) -> String? {
+        var resolved = root
+
+        for segment in path.split(separator: "/", omittingEmptySubsequences: true) {
+            guard segment != "..", !segment.contains("\0") else {
+                return nil
+            }
+
+            if segment != "." {
+                resolved += "/"
+                resolved += segment
+            }
+        }
+
+        if path.hasSuffix("/") {
+            resolved += "/"
+            resolved += indexFile
+        }
+
+        return resolved
+    }
+
+    private func lookup(_ path: String) throws -> Entry {
+        if let entry = cache.value(forKey: path) {
+            if watcher != nil || time(nil) < entry.loadedAt + revalidationInterval {
+                return entry
+            }
+
+            cache.removeValue(forKey: path)
+        }
+
+        let entry = try Entry(path: path, maximumInMemorySize: maximumCachedFileSize)
+        watch(directory: entry.directory)
+        cache.setValue(entry, forKey: path, cost: entry.cost)
+        return entry
+    }
+
+    private func watch(directory: String) {
+        guard !watcherFailed else {
+            return
+        }
+
+        do {
+            if watcher == nil {
+                let watcher = try DirectoryWatcher()
+
+                watching = try Coroutine { [unowned self] in
+                    while true {
+                        guard let changes = try? watcher.changes(deadline: .never) else {
+                            return
+                        }
+
+                        self.invalidate(changes)
+                    }
+                }
+
+                self.watcher = watcher
+            }
+
+            try watcher?.watch(directory: directory)
+        } catch {
+            // No inotify, or out of watches: fall back to periodic reloads.
+            watcherFailed = true
+            watching?.cancel()
+            watching = nil
+            watcher = nil
+            cache.removeAll()
+        }
+    }
+
+    private func invalidate(_ changes: [DirectoryWatcher.Change]) {
+        for change in changes {
+            switch change {
+            case .overflow:
+                cache.removeAll()
+            case let .entry(directory, name) where name.isEmpty:
+                cache.removeAll(where: { $0.hasPrefix(directory + "/") })
+            case let .entry(directory, name):
+                var path = directory + "/" + name
+
+                for suffix in [".gz", ".br"] where path.hasSuffix(suffix) {
+                    path = String(path.dropLast(suffix.count))
+                }
+
+                cache.removeValue(forKey: path)
+            }
+        }
+    }
+}
+
+extension StaticFiles {
+    private final class Entry {
+        let directory: String
+        let loadedAt: Int
+        let variants: [Variant]
+
+        init(path: String, maximumInMemorySize: Int) throws {
+            let name = path.split(separator: "/").last.map(String.init) ?? ""
+            let fileExtension = name.split(separator: ".").dropFirst().last.map({ $0.lowercased() })
+            let contentType = fileExtension.flatMap(MediaType.from(fileExtension:))
+
+            self.directory = String(path.dropLast(name.count + 1))
+            self.loadedAt = time(nil)
+
+            var variants = [
+                try Variant(
+                    file: File(path: path),
+                    encoding: nil,
+                    contentType: contentType,
+                    maximumInMemorySize: maximumInMemorySize
+                )
+            ]
+
+            for (suffix, encoding) in [(".br", "br"), (".gz", "gzip")] {
+                guard let file = try? File(path: path + suffix) else {
+                    continue
+                }
+
+                variants.append(
+                    try Variant(
+                        file: file,
+                        encoding: encoding,
+                        contentType: contentType,
+                        maximumInMemorySize: maximumInMemorySize
+                    )
+                )
+            }
+
+            if variants.count > 1 {
+                for variant in variants {
+                    variant.headers["Vary"] = "Accept-Encoding"
+                    variant.validators["Vary"] = "Accept-Encoding"
+                }
+            }
+
+            self.variants = variants
+        }
+
+        var cost: Int {
+            return variants.reduce(0, { $0 + $1.cost })
+        }
+
+        /// Picks the smallest variant whose encoding the client accepts.
+        func variant(accepting header: String?) -> Variant {
+            guard variants.count > 1, let header = header else {
+                return variants[0]
+            }
+
+            let accepted = AcceptEncoding(header)
+            var best = variants[0]
+
+            for variant in variants.dropFirst() {
+                guard let encoding = variant.encoding else {
+                    continue
+                }
+
+                if accepted.accepts(encoding) && variant.size < best.size {
+                    best = variant
+                }
+            }
+
+            return best
+        }
+    }
+
+    private final class Variant {
+        let encoding: String?
+        let size: Int
+        let etag: String
+        let modificationTime: Int
+        var headers: Headers
+        var validators: Headers
+
+        /// In-memory copy of small files; large files are sent from `file`.
+        private let contents: Contents?
+        private let file: File?
+
+        init(file: File, encoding: String?, contentType: MediaType?, maximumInMemorySize: Int) throws {
+            self.encoding = encoding
+            self.size = file.size
+            self.modificationTime = file.modificationTime
+
+            self.etag = "\"" + [file.inode, UInt64(file.modificationTime), UInt64(file.size)]
+                .map({ String($0, radix: 16) })
+                .joined(separator: "-") + "\""
+
+            let validators: Headers = [
+                "ETag": etag,
+                "Last-Modified": HTTPDate.string(from: file.modificationTime),
+            ]
+
+            var headers = validators
+            headers["Content-Type"] = contentType?.description ?? "application/octet-stream"
+            headers["Content-Length"] = String(file.size)
+            headers["Content-Encoding"] = encoding
+
+            self.validators = validators
+            self.headers = headers
+
+            if file.size <= maximumInMemorySize {
+                let contents = Contents(count: file.size)
+                try file.write(to: contents, deadline: .never)
+                self.contents = contents
+                self.file = nil
+            } else {
+                self.contents = nil
+                self.file = file
+            }
+        }
+
+        /// Bytes held in memory, plus a rough allowance for the headers.
+        var cost: Int {
+            return (contents?.count ?? 0) + 512
+        }
+
+        var source: ByteRangeSource {
+            return contents ?? file!
+        }
+
+        func isNotModified(for request: Request) -> Bool {
+            if let ifNoneMatch = request.headers["If-None-Match"] {
+                return ifNoneMatch.split(separator: ",").contains { tag in
+                    var tag = tag.trimmingCharacters(in: .whitespaces)
+
+                    if tag.hasPrefix("W/") {
+                        tag = String(tag.dropFirst(2))
+                    }
+
+                    return tag == "*" || tag == etag
+                }
+            }
+
+            if let ifModifiedSince = request.headers["If-Modified-Since"],
+                let date = HTTPDate.seconds(from: ifModifiedSince) {
+                return modificationTime <= date
+            }
+
+            return false
+        }
+    }
+
+    /// Fixed-size byte buffer filled once by `File.write`.
+    private final class Contents : Writable, ByteRangeSource {
+        let bytes: UnsafeMutableRawBufferPointer
+        private(set) var count = 0
+
+        init(count: Int) {
+            self.bytes = UnsafeMutableRawBufferPointer.allocate(
+                byteCount: count,
+                alignment: MemoryLayout<UInt8>.alignment
+            )
+        }
+
+        deinit {
+            bytes.deallocate()
+        }
+
+        func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+            guard let source = buffer.baseAddress, count + buffer.count <= bytes.count else {
+                throw FileError.rangeOutOfBounds
+            }
+
+            memcpy(bytes.baseAddress! + count, source, buffer.count)
+            count += buffer.count
+        }
+
+        var byteCount: Int {
+            return count
+        }
+
+        func write(bytesIn range: Range<Int>, to stream: Writable, deadline: Deadline) throws {
+            try stream.write(UnsafeRawBufferPointer(rebasing: bytes[range]), deadline: deadline)
+        }
+
+        /// Reads through the serializer, under its deadline.
+        func body(for range: Range<Int>) -> Body {
+            return .readable(ContentsReader(contents: self, range: range))
+        }
+    }
+
+    /// Reads a range of the cached bytes, keeping them alive if they are
+    /// evicted while the response is in flight.
+    private final class ContentsReader : Readable {
+        private let contents: Contents
+        private var range: Range<Int>
+
+        init(contents: Contents, range: Range<Int>) {
+            self.contents = contents
+            self.range = range
+        }
+
+        func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+            let count = min(buffer.count, range.count)
+            let chunk = range.lowerBound ..< range.lowerBound + count
+            buffer.copyMemory(from: UnsafeRawBufferPointer(rebasing: contents.bytes[chunk]))
+            range = chunk.upperBound ..< range.upperBound
+            return UnsafeRawBufferPointer(rebasing: buffer[0 ..< count])
+        }
+    }
+}
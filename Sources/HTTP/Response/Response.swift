@@ -32,6 +32,7 @@ public final class Response : Message {
         case `continue`
         case switchingProtocols
         case processing
+        case earlyHints
         
         case ok
         case created
@@ -136,6 +137,23 @@ extension Response {
         )
     }
 
+    /// Sends `range` of `file`, or all of it, with a matching `Content-Length`.
+    public convenience init(
+        status: Status,
+        headers: Headers = [:],
+        file: File,
+        range: Range<Int>? = nil
+    ) {
+        self.init(
+            status: status,
+            headers: headers,
+            version: .oneDotOne,
+            body: .file(file, range: range)
+        )
+        
+        contentLength = range?.count ?? file.size
+    }
+    
     public convenience init(
         status: Status,
         headers: Headers = [:],
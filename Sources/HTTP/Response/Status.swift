@@ -30,6 +30,7 @@ extension Response.Status {
             case Response.Status.continue.statusCode:                      self = .continue
             case Response.Status.switchingProtocols.statusCode:            self = .switchingProtocols
             case Response.Status.processing.statusCode:                    self = .processing
+            case Response.Status.earlyHints.statusCode:                    self = .earlyHints
 
             case Response.Status.ok.statusCode:                            self = .ok
             case Response.Status.created.statusCode:                       self = .created
@@ -100,6 +101,7 @@ extension Response.Status {
         case .continue:                      return 100
         case .switchingProtocols:            return 101
         case .processing:                    return 102
+        case .earlyHints:                    return 103
 
         case .ok:                            return 200
         case .created:                       return 201
@@ -168,6 +170,7 @@ extension Response.Status {
         case .continue:                      return "100"
         case .switchingProtocols:            return "101"
         case .processing:                    return "102"
+        case .earlyHints:                    return "103"
             
         case .ok:                            return "200"
         case .created:                       return "201"
@@ -238,6 +241,7 @@ extension Response.Status {
         case .continue:                      return "Continue"
         case .switchingProtocols:            return "Switching Protocols"
         case .processing:                    return "Processing"
+        case .earlyHints:                    return "Early Hints"
 
         case .ok:                            return "OK"
         case .created:                       return "Created"
@@ -2,11 +2,26 @@ import Core
 import Venice
 
 internal final class RequestSerializer : Serializer {
-    internal func serialize(_ request: Request, deadline: Deadline) throws {
+    /// Pass `includingBody: false` to hold the body back until the server
+    /// answers `Expect: 100-continue`, then send it with `serializeDeferredBody`.
+    internal func serialize(_ request: Request, includingBody: Bool = true, deadline: Deadline) throws {
+        setFileContentLength(request)
         try checkHeaders(request)
-        try serializeRequestLine(request, deadline: deadline)
-        try serializeHeaders(request, deadline: deadline)
-        try serializeBody(request, deadline: deadline)
+        
+        try corked(deadline: deadline) {
+            try serializeRequestLine(request, deadline: deadline)
+            try serializeHeaders(request, deadline: deadline)
+            
+            if includingBody {
+                try serializeBody(request, deadline: deadline)
+            }
+        }
+    }
+    
+    internal func serializeDeferredBody(_ request: Request, deadline: Deadline) throws {
+        try corked(deadline: deadline) {
+            try serializeBody(request, deadline: deadline)
+        }
     }
     
     @inline(__always)
@@ -2,13 +2,49 @@ import Core
 import Venice
 
 internal final class ResponseSerializer : Serializer {
-    internal func serialize(_ response: Response, deadline: Deadline) throws -> Bool {
-        try serializeStatusLine(response, deadline: deadline)
-        try serializeHeaders(response, deadline: deadline)
-        try serializeBody(response, deadline: deadline)
+    /// Pass `includingBody: false` when answering `HEAD`; the headers still
+    /// describe the body that a `GET` would have returned.
+    internal func serialize(
+        _ response: Response,
+        includingBody: Bool = true,
+        deadline: Deadline
+    ) throws -> Bool {
+        setFileContentLength(response)
+        
+        try corked(deadline: deadline) {
+            try serializeStatusLine(response, deadline: deadline)
+            try serializeHeaders(response, deadline: deadline)
+            
+            if includingBody {
+                try serializeBody(response, deadline: deadline)
+            }
+        }
+        
         return response.contentLength != nil || response.isChunkEncoded
     }
     
+    /// Writes a `1xx` interim response and flushes it right away. Any number
+    /// of these may precede the final response to a request.
+    internal func serializeInterim(_ status: Response.Status, headers: Headers = [:], deadline: Deadline) throws {
+        var header = Version.oneDotOne.description
+        header += " "
+        header += status.description
+        header += "\r\n"
+        
+        for (name, value) in headers {
+            header += name.description
+            header += ": "
+            header += value
+            header += "\r\n"
+        }
+        
+        header += "\r\n"
+        
+        try corked(deadline: deadline) {
+            try stream.write(header, deadline: deadline)
+        }
+    }
+    
     @inline(__always)
     private func serializeStatusLine(_ response: Response, deadline: Deadline) throws {
         var header = response.version.description
@@ -1,4 +1,5 @@
 import Core
+import IO
 import Venice
 
 // TODO: Make CustomStringConvertible
@@ -9,7 +10,7 @@ public enum SerializerError : Error {
 }
 
 internal class Serializer {
-    final class BodyStream : Writable {
+    final class BodyStream : Writable, Flushable, TransparentWritable {
         enum Mode {
             case contentLength(Int)
             case chunkedEncoding
@@ -49,6 +50,38 @@ internal class Serializer {
                 try stream.write("\r\n", deadline: deadline)
             }
         }
+        
+        /// Writes `chunk`, which holds `payload` already framed as a chunk,
+        /// in one go. Lets content shared by many responses be framed once.
+        func write(framed chunk: UnsafeRawBufferPointer, payload: Range<Int>, deadline: Deadline) throws {
+            switch mode {
+            case .contentLength:
+                try write(UnsafeRawBufferPointer(rebasing: chunk[payload]), deadline: deadline)
+            case .chunkedEncoding:
+                try stream.write(chunk, deadline: deadline)
+            }
+        }
+        
+        /// Pushes buffered body bytes to the connection, e.g. after each
+        /// event of a streaming response.
+        func flush(deadline: Deadline) throws {
+            try (stream as? Flushable)?.flush(deadline: deadline)
+        }
+        
+        /// Content-length bodies go out unframed, so file ranges can be
+        /// sent to the connection directly.
+        func beginTransparentWrite(count: Int, deadline: Deadline) throws -> Writable? {
+            guard case .contentLength = mode else {
+                return nil
+            }
+            
+            if bytesRemaining - count < 0 {
+                throw SerializerError.writeExceedsContentLength
+            }
+            
+            bytesRemaining -= count
+            return stream
+        }
     }
     
     internal let stream: Writable
@@ -69,6 +102,30 @@ internal class Serializer {
         buffer.deallocate()
     }
     
+    /// Runs `body` with the underlying TCP socket corked, if enabled, and
+    /// flushes any write-behind buffer before uncorking, so the head and body
+    /// of a message leave in as few segments as possible.
+    internal func corked<R>(deadline: Deadline, _ body: () throws -> R) throws -> R {
+        let buffered = stream as? BufferedStream
+        let tcp = (buffered?.stream ?? stream) as? TCPStream
+        
+        try tcp?.cork()
+        let result = try body()
+        try buffered?.flush(deadline: deadline)
+        try tcp?.uncork()
+        return result
+    }
+    
+    /// File bodies know their length up front, so they go out with a
+    /// `Content-Length` unless the message already frames its body.
+    internal func setFileContentLength(_ message: Message) {
+        guard let length = message.body.fileLength, message.contentLength == nil, !message.isChunkEncoded else {
+            return
+        }
+        
+        message.contentLength = length
+    }
+    
     internal func serializeHeaders(_ message: Message, deadline: Deadline) throws {
         var header = ""
         
@@ -104,6 +161,31 @@ internal class Serializer {
             throw SerializerError.invalidContentLength
         }
         
+        if case let .file(file, range) = message.body {
+            guard message.body.fileLength == contentLength else {
+                throw SerializerError.invalidContentLength
+            }
+            
+            try file.write(range, to: stream, deadline: deadline)
+            return
+        }
+        
+        if case let .readable(readable) = message.body {
+            // Bodies that fit the output buffer go out with the headers in
+            // one write. Larger ones are worth flushing for, as plain
+            // sockets on both ends let `pipe` splice them in the kernel.
+            let written = try fitsOutputBuffer(contentLength)
+                ? copyBody(from: readable, count: contentLength, deadline: deadline)
+                : pipe(from: readable, to: stream, count: contentLength, deadline: deadline)
+            
+            if written < contentLength {
+                throw SerializerError.invalidContentLength
+            }
+            
+            try assertExhausted(readable, deadline: deadline)
+            return
+        }
+        
         let bodyStream = BodyStream(stream, mode: .contentLength(contentLength))
         try write(to: bodyStream, body: message.body, deadline: deadline)
         
@@ -112,6 +194,46 @@ internal class Serializer {
         }
     }
     
+    private func fitsOutputBuffer(_ count: Int) -> Bool {
+        guard let buffered = stream as? BufferedStream else {
+            return false
+        }
+        
+        return count <= buffered.writeBufferSize - buffered.bufferedWriteCount
+    }
+    
+    /// Copies up to `count` bytes of `readable` to `stream`.
+    private func copyBody(from readable: Readable, count: Int, deadline: Deadline) throws -> Int {
+        var written = 0
+        
+        while written < count {
+            let chunk = UnsafeMutableRawBufferPointer(rebasing: buffer[0 ..< min(buffer.count, count - written)])
+            let read = try readable.read(chunk, deadline: deadline)
+            
+            guard !read.isEmpty else {
+                break
+            }
+            
+            try stream.write(read, deadline: deadline)
+            written += read.count
+        }
+        
+        return written
+    }
+    
+    /// Throws if `readable` holds more than its `Content-Length` claimed.
+    private func assertExhausted(_ readable: Readable, deadline: Deadline) throws {
+        var byte: UInt8 = 0
+        
+        let exhausted = try withUnsafeMutableBytes(of: &byte) { probe in
+            try readable.read(probe, deadline: deadline).isEmpty
+        }
+        
+        guard exhausted else {
+            throw SerializerError.writeExceedsContentLength
+        }
+    }
+    
     @inline(__always)
     private func writeChunkEncodedBody(_ message: Message, deadline: Deadline) throws {
         let bodyStream = BodyStream(stream, mode: .chunkedEncoding)
@@ -134,6 +256,8 @@ internal class Serializer {
             }
         case let .writable(write):
             try write(writable)
+        case let .file(file, range):
+            try file.write(range, to: writable, deadline: deadline)
         }
     }
 }
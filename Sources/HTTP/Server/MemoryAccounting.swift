@@ -0,0 +1,47 @@
+import Core
+
+/// Memory budgets for `Server`.
+///
+/// Each connection gets a `MemoryAccount` charged for its parser and
+/// serializer buffers and for the start line and headers being parsed.
+/// Each request gets a child account, `Request.memoryAccount`, charged for
+/// its headers and for what is built from its body: decoded JSON content,
+/// spooled bodies and multipart buffers. The request account is released
+/// once the response was sent.
+///
+/// Parsing fails once the connection is over budget, and a connection that
+/// went over budget is closed after its current response.
+public struct MemoryAccounting {
+    /// Bytes a connection may hold, unlimited when `nil`
+    public var connectionBudget: Int?
+
+    /// Bytes a request may hold, unlimited when `nil`
+    public var requestBudget: Int?
+
+    public init(connectionBudget: Int? = nil, requestBudget: Int? = nil) {
+        self.connectionBudget = connectionBudget
+        self.requestBudget = requestBudget
+    }
+}
+
+/// Memory charged to a server's connections.
+public struct MemoryStatistics {
+    /// All connections together
+    public let total: MemoryAccount.Statistics
+
+    /// Open connections
+    public let connections: [MemoryAccount.Statistics]
+}
+
+extension Request {
+    /// Rough size of the URI and headers once parsed.
+    internal var estimatedHeaderSize: Int {
+        var size = uri.description.utf8.count
+
+        for (field, value) in headers {
+            size += field.original.utf8.count + value.utf8.count
+        }
+
+        return size
+    }
+}
@@ -0,0 +1,110 @@
+import Venice
+
+/// Handles the pipelined requests of one connection concurrently, each in
+/// a coroutine of its own, and writes their responses in request order.
+///
+/// At most `depth` requests are pending at a time; `dispatch` waits for the
+/// oldest response to go out before taking more.
+internal final class ResponsePipeline {
+    typealias Write = (Request, Response) throws -> Bool
+
+    private final class Slot {
+        let request: Request
+        var result: Result<Response, Error>?
+
+        init(_ request: Request) {
+            self.request = request
+        }
+    }
+
+    private let depth: Int
+    private let write: Write
+    private let progress: Signal
+    private let handlers = Coroutine.Group()
+    private var writer: Coroutine?
+    private var slots: [Slot] = []
+    private var error: Error?
+
+    /// Whether a response ended the connection or could not be written.
+    private(set) var closed = false
+
+    /// `write` sends a response and returns whether the connection stays open.
+    init(depth: Int, write: @escaping Write) throws {
+        self.depth = max(depth, 1)
+        self.write = write
+        self.progress = try Signal()
+    }
+
+    /// Starts handling `request` with `handle` once fewer than `depth`
+    /// requests are pending.
+    func dispatch(_ request: Request, handle: @escaping () throws -> Response) throws {
+        while slots.count >= depth && !closed {
+            try progress.wait(deadline: .never)
+        }
+
+        guard !closed else {
+            return
+        }
+
+        let slot = Slot(request)
+        slots.append(slot)
+
+        try handlers.addCoroutine { [unowned self] in
+            slot.result = Result(catching: handle)
+            self.progress.broadcast()
+        }
+
+        if writer == nil {
+            writer = try Coroutine { [unowned self] in
+                self.writeResponses()
+            }
+        }
+    }
+
+    /// Waits until every dispatched response was written, and throws the
+    /// error handling or writing one failed with.
+    func drain() throws {
+        while !slots.isEmpty && !closed {
+            try progress.wait(deadline: .never)
+        }
+
+        if let error = error {
+            throw error
+        }
+    }
+
+    /// Abandons pending requests. Must be called once the connection is done.
+    func close() {
+        closed = true
+        slots = []
+        handlers.cancel()
+        writer?.cancel()
+        writer = nil
+    }
+
+    private func writeResponses() {
+        while !closed {
+            guard let slot = slots.first, let result = slot.result else {
+                do {
+                    try progress.wait(deadline: .never)
+                    continue
+                } catch {
+                    return
+                }
+            }
+
+            slots.removeFirst()
+
+            do {
+                if try !write(slot.request, result.get()) {
+                    closed = true
+                }
+            } catch {
+                self.error = error
+                closed = true
+            }
+
+            progress.broadcast()
+        }
+    }
+}
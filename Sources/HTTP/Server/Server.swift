@@ -18,9 +18,52 @@ public final class Server {
     /// Close connection timeout
     public let closeConnectionTimeout: Duration
     
+    /// Maximum number of pending connections accepted per wakeup
+    public let acceptBatchSize: Int
+    
+    /// Response compression, disabled when `nil`
+    public let compression: Compression?
+    
+    /// Inflate gzip and deflate encoded request bodies while they are read
+    public let decompressRequests: Bool
+    
+    /// Largest decompressed to compressed size ratio accepted
+    public let maximumDecompressionRatio: Int
+    
+    /// Request body size limits, unlimited when `nil`
+    public let bodyLimits: BodyLimits?
+    
+    /// Cancel `Request.cancellation` when the client disconnects while the
+    /// handler runs
+    public let cancelOnDisconnect: Bool
+    
+    /// Pipelined requests handled at once per connection, their responses
+    /// still sent in request order. `1` handles them one after the other.
+    public let pipelineDepth: Int
+    
+    /// Connection and request memory budgets, not accounted when `nil`
+    public let memoryAccounting: MemoryAccounting?
+    
+    /// Registry connections, requests and latencies are reported to,
+    /// not reported when `nil`
+    public let metrics: MetricsRegistry?
+    
+    /// Recorder of per-request phase timings, not traced when `nil`
+    public let tracing: TraceRecorder?
+    
+    /// Detector of handlers that keep the server's thread from yielding,
+    /// started and stopped with the server
+    public let stallDetector: StallDetector?
+    
+    /// HTTP/2 settings, disabled when `nil`
+    public let http2: HTTP2Settings?
+    
     private let header: String
     private let group = Coroutine.Group()
     private let respond: Respond
+    private let memoryAccount = MemoryAccount()
+    private var connectionAccounts: [ObjectIdentifier: MemoryAccount] = [:]
+    private let instruments: ServerMetrics?
 
     /// Creates a new HTTP server
     public init(
@@ -30,6 +73,18 @@ public final class Server {
         parseTimeout: Duration = 10.seconds,
         serializeTimeout: Duration = 5.minutes,
         closeConnectionTimeout: Duration = 1.minute,
+        acceptBatchSize: Int = 64,
+        compression: Compression? = nil,
+        decompressRequests: Bool = true,
+        maximumDecompressionRatio: Int = 100,
+        bodyLimits: BodyLimits? = nil,
+        cancelOnDisconnect: Bool = true,
+        pipelineDepth: Int = 1,
+        memoryAccounting: MemoryAccounting? = nil,
+        metrics: MetricsRegistry? = .default,
+        tracing: TraceRecorder? = nil,
+        stallDetector: StallDetector? = nil,
+        http2: HTTP2Settings? = nil,
         respond: @escaping Respond
     ) {
         self.header = header
@@ -38,6 +93,19 @@ public final class Server {
         self.parseTimeout = parseTimeout
         self.serializeTimeout = serializeTimeout
         self.closeConnectionTimeout = closeConnectionTimeout
+        self.acceptBatchSize = max(acceptBatchSize, 1)
+        self.compression = compression
+        self.decompressRequests = decompressRequests
+        self.maximumDecompressionRatio = maximumDecompressionRatio
+        self.bodyLimits = bodyLimits
+        self.cancelOnDisconnect = cancelOnDisconnect
+        self.pipelineDepth = max(pipelineDepth, 1)
+        self.memoryAccounting = memoryAccounting
+        self.metrics = metrics
+        self.instruments = metrics.map({ ServerMetrics(registry: $0) })
+        self.tracing = tracing
+        self.stallDetector = stallDetector
+        self.http2 = http2
         self.respond = respond
     }
     
@@ -51,16 +119,19 @@ public final class Server {
         port: Int = 8080,
         backlog: Int = 2048,
         reusePort: Bool = false,
+        socketOptions: SocketOptions = .default,
+        backend: SocketBackend = .poll,
         file: String = #file,
         function: String = #function,
         line: Int = #line,
         column: Int = #column
     ) throws {
-        let tcp = try TCPHost(
+        let tcp = try backend.host(
             host: host,
             port: port,
             backlog: backlog,
-            reusePort: reusePort
+            reusePort: reusePort,
+            options: socketOptions
         )
         
         log(
@@ -77,8 +148,41 @@ public final class Server {
         try start(host: tcp)
     }
     
+    /// Start server on a Unix domain socket
+    public func start(
+        path: String,
+        backlog: Int = 2048,
+        file: String = #file,
+        function: String = #function,
+        line: Int = #line,
+        column: Int = #column
+    ) throws {
+        let unix = try UnixHost(path: path, backlog: backlog)
+        
+        var header = self.header
+        header += "Started HTTP server, listening on \(path)."
+        
+        Logger.info(
+            header,
+            locationInfo: Logger.LocationInfo(
+                file: file,
+                line: line,
+                column: column,
+                function: function
+            )
+        )
+        
+        try start(host: unix)
+    }
+    
     /// Start server
     public func start(host: Host) throws {
+        try stallDetector?.start()
+        
+        defer {
+            stallDetector?.stop()
+        }
+        
         while true {
             do {
                 try accept(host)
@@ -95,6 +199,15 @@ public final class Server {
         }
     }
     
+    /// Memory charged to the open connections, all zero unless
+    /// `memoryAccounting` is set.
+    public var memoryStatistics: MemoryStatistics {
+        return MemoryStatistics(
+            total: memoryAccount.statistics,
+            connections: connectionAccounts.values.map({ $0.statistics })
+        )
+    }
+    
     /// Stop server
     public func stop() throws {
         Logger.info("Stopping HTTP server.")
@@ -122,11 +235,29 @@ public final class Server {
     
     @inline(__always)
     private func accept(_ host: Host) throws {
-        let stream = try host.accept(deadline: .never)
+        // Draining the whole backlog per wakeup keeps the listen queue from
+        // overflowing during reconnect storms.
+        let streams = try host.accept(upTo: acceptBatchSize, deadline: .never)
+        
+        for stream in streams {
+            try spawn(stream)
+        }
+    }
+    
+    @inline(__always)
+    private func spawn(_ stream: DuplexStream) throws {
+        instruments?.acceptedConnections.increment()
+        let accepted = tracing == nil ? 0 : MonotonicClock.now()
         
         try group.addCoroutine { [unowned self] in
+            self.instruments?.activeConnections.increment()
+            
+            defer {
+                self.instruments?.activeConnections.decrement()
+            }
+            
             do {
-                try self.process(stream)
+                try self.process(stream, accepted: accepted)
             } catch SystemError.brokenPipe {
                 Logger.error("Broken pipe while processing connection.")
                 return
@@ -145,27 +276,403 @@ public final class Server {
     }
 
     @inline(__always)
-    private func process(_ stream: DuplexStream) throws {
-        let parser = RequestParser(stream: stream, bufferSize: parserBufferSize)
-        let serializer = ResponseSerializer(stream: stream, bufferSize: serializerBufferSize)
+    private func process(_ stream: DuplexStream, accepted: Int) throws {
+        var input: Readable = stream
+        
+        if let settings = http2 {
+            // Over TLS the protocol is agreed on through ALPN. Cleartext
+            // clients with prior knowledge open with the connection preface.
+            if let tls = stream as? TLSStream {
+                if try tls.negotiatedProtocol(deadline: parseTimeout.fromNow()) == "h2" {
+                    return try serveHTTP2(on: stream, settings: settings)
+                }
+            } else {
+                let sniffed = try PrefixedStream.sniffPreface(on: stream, deadline: parseTimeout.fromNow())
+                
+                if sniffed.matches {
+                    return try serveHTTP2(on: sniffed.stream, settings: settings)
+                }
+                
+                input = sniffed.stream
+            }
+        }
+        
+        let account = try openMemoryAccount()
+        
+        defer {
+            if let account = account {
+                closeMemoryAccount(account)
+            }
+        }
+        
+        let parser = RequestParser(stream: input, bufferSize: parserBufferSize)
+        parser.account = account
+        
+        // Coalesces the status line, headers and small body writes into
+        // as few syscalls as possible. Flushed at the end of every response.
+        let output = BufferedStream(stream, readBufferSize: 0, writeBufferSize: serializerBufferSize)
+        let serializer = ResponseSerializer(stream: output, bufferSize: serializerBufferSize)
+        
+        // zlib streams are kept for the whole connection and reset per response.
+        let compressor = compression.map({
+            ResponseCompressor(compression: $0, timeout: serializeTimeout)
+        })
+        
+        let traffic = instruments.map({
+            TrafficMeter(metrics: $0, parser: parser, output: output)
+        })
+        
+        defer {
+            traffic?.report()
+        }
+        
+        var pipeline: ResponsePipeline?
+        var firstRequest = true
+        
+        if pipelineDepth > 1 {
+            pipeline = try ResponsePipeline(depth: pipelineDepth) { [unowned self] request, response in
+                defer {
+                    request.memoryAccount?.releaseAll()
+                }
+                
+                compressor?.compress(response, for: request)
+                
+                let keepAlive = try self.serialize(
+                    response,
+                    for: request,
+                    with: serializer,
+                    traffic: traffic
+                )
+                
+                return keepAlive && request.isKeepAlive && account?.exceeded != true
+            }
+        }
+        
+        defer {
+            pipeline?.close()
+        }
         
         while true {
-            let request = try parser.parse(deadline: parseTimeout.fromNow())
-            let response = respond(request)
-            let keepAlive = try serializer.serialize(response, deadline: serializeTimeout.fromNow())
+            let request: Request
+            
+            do {
+                request = try parser.parse(deadline: parseTimeout.fromNow())
+                instruments?.parseDuration.record(since: parser.messageStart)
+            } catch {
+                // Requests already dispatched are still answered.
+                try pipeline?.drain()
+                throw error
+            }
+            
+            if tracing != nil {
+                beginTrace(of: request, parsedBy: parser, accepted: firstRequest ? accepted : nil)
+            }
+            
+            firstRequest = false
+            
+            if let account = account {
+                guard charge(request, to: account) else {
+                    try pipeline?.drain()
+                    break
+                }
+            }
+            
+            var continuation: ContinueReadable?
+            
+            // Handlers of requests that arrived whole never read from the
+            // socket, which can then be watched for the client going away.
+            let received = (request.body.readable as? Parser.BodyStream)?.complete ?? false
+            
+            // Only requests that need nothing more from the connection are
+            // handled concurrently. Interim responses are not sent for them.
+            if let pipeline = pipeline, received, !request.expectsContinue, request.upgrade == nil {
+                (request.body.readable as? Parser.BodyStream)?.detach()
+                
+                try pipeline.dispatch(request) { [unowned self] in
+                    try self.handle(request)
+                }
+                
+                guard !pipeline.closed, request.isKeepAlive else {
+                    break
+                }
+                
+                continue
+            }
+            
+            defer {
+                request.memoryAccount?.releaseAll()
+            }
+            
+            try pipeline?.drain()
+            
+            if pipeline?.closed == true {
+                break
+            }
             
-            guard keepAlive else {
+            if let settings = http2, !(stream is TLSStream), let upgradeSettings = request.h2cUpgradeSettings {
+                let connection = try makeHTTP2Connection(on: stream, settings: settings)
+                try connection.applyUpgradeSettings(upgradeSettings)
+                
+                try serializer.serializeInterim(
+                    .switchingProtocols,
+                    headers: ["Connection": "Upgrade", "Upgrade": "h2c"],
+                    deadline: serializeTimeout.fromNow()
+                )
+                
+                return try serve(connection, upgradedRequest: request)
+            }
+            
+            // HTTP/1.0 clients do not expect interim responses.
+            if request.version.major == 1, request.version.minor >= 1 {
+                request.interimResponder = { status, headers, deadline in
+                    try serializer.serializeInterim(status, headers: headers, deadline: deadline)
+                }
+            }
+            
+            if request.expectsContinue, case let .readable(body) = request.body {
+                continuation = ContinueReadable(body) { deadline in
+                    try serializer.serializeInterim(.continue, deadline: deadline)
+                }
+                
+                request.body = .readable(continuation!)
+            }
+            
+            let watcher = try received ? watchDisconnect(of: stream, for: request) : nil
+            let response: Response
+            
+            do {
+                defer {
+                    watcher?.cancel()
+                }
+                
+                response = try handle(request)
+            }
+            
+            // Nobody is left to read the response.
+            if request.cancellation?.isCancelled == true {
                 break
             }
             
-            if let upgrade = response.upgradeConnection {
+            compressor?.compress(response, for: request)
+            
+            // The client may still send the body it was never asked for, or
+            // the rest of a body over its limit, so the rest of the
+            // connection cannot be parsed reliably.
+            let bodyWithheld = (continuation?.withdraw() ?? false) || request.bodyExceededLimit
+            request.interimResponder = nil
+            
+            if bodyWithheld {
+                response.connection = "close"
+            }
+            
+            let keepAlive = try serialize(
+                response,
+                for: request,
+                with: serializer,
+                traffic: traffic
+            )
+            
+            // `101 Switching Protocols` has no body to frame, so the
+            // connection is handed over whether or not it has a length.
+            if let upgrade = response.upgradeConnection, !bodyWithheld {
                 try upgrade(request, stream)
                 break
             }
             
+            guard keepAlive, !bodyWithheld, account?.exceeded != true else {
+                break
+            }
+            
             if !request.isKeepAlive {
                 break
             }
         }
+        
+        try pipeline?.drain()
+    }
+    
+    /// Runs `respond` with the body limits of `request` applied, answering
+    /// `413 Request Entity Too Large` for bodies over them.
+    private func handle(_ request: Request) throws -> Response {
+        if let rejection = try limitBody(of: request) {
+            instruments?.count(rejection)
+            return rejection
+        }
+        
+        if decompressRequests {
+            try request.inflateBody(maximumRatio: maximumDecompressionRatio)
+        }
+        
+        let start = instruments == nil && request.trace == nil ? 0 : MonotonicClock.now()
+        var response: Response
+        
+        if let detector = stallDetector {
+            response = detector.run(request.method.description + " " + (request.uri.path ?? "/")) {
+                respond(request)
+            }
+        } else {
+            response = respond(request)
+        }
+        
+        instruments?.respondDuration.record(since: start)
+        
+        if let trace = request.trace {
+            trace.record(.queue, from: trace.end, to: start)
+            trace.record(.respond, from: start, to: MonotonicClock.now())
+        }
+        
+        if request.bodyExceededLimit {
+            response = Response(status: .requestEntityTooLarge)
+        }
+        
+        instruments?.count(response)
+        return response
+    }
+    
+    /// Writes `response`, timing it. Returns whether the connection can
+    /// stay open.
+    private func serialize(
+        _ response: Response,
+        for request: Request,
+        with serializer: ResponseSerializer,
+        traffic: TrafficMeter?
+    ) throws -> Bool {
+        let start = instruments == nil && request.trace == nil ? 0 : MonotonicClock.now()
+        
+        defer {
+            instruments?.serializeDuration.record(since: start)
+            traffic?.report()
+            
+            if let trace = request.trace {
+                trace.record(.serialize, from: start, to: MonotonicClock.now())
+                trace.attributes.append(("http.status_code", String(response.status.statusCode)))
+                tracing?.finish(trace)
+            }
+        }
+        
+        return try serializer.serialize(
+            response,
+            includingBody: request.method != .head,
+            deadline: serializeTimeout.fromNow()
+        )
+    }
+    
+    /// Starts tracing `request`, continuing the trace of its `traceparent`,
+    /// with the phases up to the end of its headers.
+    private func beginTrace(of request: Request, parsedBy parser: Parser, accepted: Int?) {
+        let parent = request.headers["traceparent"].flatMap({ TraceContext(traceparent: $0) })
+        let path = request.uri.path ?? "/"
+        
+        guard let trace = tracing?.begin(name: request.method.description + " " + path, parent: parent) else {
+            request.traceContext = parent
+            return
+        }
+        
+        if let accepted = accepted {
+            trace.record(.accept, from: accepted, to: parser.messageStart)
+        }
+        
+        trace.record(.parse, from: parser.messageStart, to: MonotonicClock.now())
+        trace.attributes = [("http.method", request.method.description), ("http.target", path)]
+        request.trace = trace
+        request.traceContext = trace.context
+    }
+    
+    /// Opens the account of a new connection, charged for its buffers:
+    /// the parser's, the serializer's and the output buffer's.
+    private func openMemoryAccount() throws -> MemoryAccount? {
+        guard let accounting = memoryAccounting else {
+            return nil
+        }
+        
+        let account = MemoryAccount(budget: accounting.connectionBudget, parent: memoryAccount)
+        connectionAccounts[ObjectIdentifier(account)] = account
+        
+        do {
+            try account.charge(parserBufferSize + 2 * serializerBufferSize)
+        } catch {
+            closeMemoryAccount(account)
+            throw error
+        }
+        
+        return account
+    }
+    
+    private func closeMemoryAccount(_ account: MemoryAccount) {
+        connectionAccounts[ObjectIdentifier(account)] = nil
+        account.releaseAll()
+    }
+    
+    /// Gives `request` an account of its own, charged for its headers.
+    /// Returns `false` if that takes it or its connection over budget.
+    private func charge(_ request: Request, to connection: MemoryAccount) -> Bool {
+        let account = MemoryAccount(budget: memoryAccounting?.requestBudget, parent: connection)
+        request.memoryAccount = account
+        
+        do {
+            try account.charge(request.estimatedHeaderSize)
+            return true
+        } catch {
+            account.releaseAll()
+            return false
+        }
+    }
+    
+    /// Cancels `request` if the client disconnects before the watcher is
+    /// canceled.
+    private func watchDisconnect(of stream: DuplexStream, for request: Request) throws -> Coroutine? {
+        guard cancelOnDisconnect else {
+            return nil
+        }
+        
+        let cancellation = Cancellation()
+        request.cancellation = cancellation
+        
+        return try Coroutine {
+            if (try? peerDisconnected(from: stream, deadline: .never)) == true {
+                cancellation.cancel()
+            }
+        }
+    }
+    
+    /// Applies `bodyLimits` to `request`, returning `413 Request Entity Too
+    /// Large` if its body is over the limit.
+    private func limitBody(of request: Request) throws -> Response? {
+        guard let limits = bodyLimits else {
+            return nil
+        }
+        
+        do {
+            try limits.apply(to: request)
+            return nil
+        } catch MessageError.bodyTooLarge {
+            return Response(status: .requestEntityTooLarge)
+        }
+    }
+    
+    private func makeHTTP2Connection(on stream: DuplexStream, settings: HTTP2Settings) throws -> HTTP2Connection {
+        return try HTTP2Connection(
+            stream: stream,
+            role: .server,
+            settings: settings,
+            writeTimeout: serializeTimeout,
+            idleTimeout: closeConnectionTimeout
+        )
+    }
+    
+    private func serveHTTP2(on stream: DuplexStream, settings: HTTP2Settings) throws {
+        try serve(makeHTTP2Connection(on: stream, settings: settings), upgradedRequest: nil)
+    }
+    
+    private func serve(_ connection: HTTP2Connection, upgradedRequest: Request?) throws {
+        // Responses are not compressed over HTTP/2; request bodies still are
+        // inflated like on HTTP/1.
+        try connection.serve(upgradedRequest: upgradedRequest) { [unowned self] request in
+            do {
+                return try self.handle(request)
+            } catch {
+                return Response(status: .internalServerError)
+            }
+        }
     }
 }
@@ -0,0 +1,87 @@
+import Core
+import IO
+
+/// Metrics `Server` reports, registered once per server.
+internal struct ServerMetrics {
+    let acceptedConnections: Counter
+    let activeConnections: Gauge
+    /// Responses by status class, `1xx` to `5xx`
+    let responses: [Counter]
+    let parseDuration: Histogram
+    let respondDuration: Histogram
+    let serializeDuration: Histogram
+    let receivedBytes: Counter
+    let sentBytes: Counter
+
+    init(registry: MetricsRegistry) {
+        acceptedConnections = registry.counter(
+            "http_server_connections_accepted_total",
+            help: "Connections accepted."
+        )
+
+        activeConnections = registry.gauge(
+            "http_server_connections_active",
+            help: "Connections open."
+        )
+
+        responses = (1 ... 5).map({ statusClass in
+            registry.counter(
+                "http_server_requests_total",
+                help: "Requests answered, by status class.",
+                labels: ["class": String(statusClass) + "xx"]
+            )
+        })
+
+        parseDuration = registry.histogram(
+            "http_server_parse_duration_seconds",
+            help: "Time from the first byte of a request to the end of its headers."
+        )
+
+        respondDuration = registry.histogram(
+            "http_server_respond_duration_seconds",
+            help: "Time spent in the respond closure."
+        )
+
+        serializeDuration = registry.histogram(
+            "http_server_serialize_duration_seconds",
+            help: "Time spent writing responses."
+        )
+
+        receivedBytes = registry.counter(
+            "http_server_received_bytes_total",
+            help: "Bytes of HTTP/1 requests received."
+        )
+
+        sentBytes = registry.counter(
+            "http_server_sent_bytes_total",
+            help: "Bytes of HTTP/1 responses sent."
+        )
+    }
+
+    @inline(__always)
+    func count(_ response: Response) {
+        responses[min(max(response.status.statusCode / 100, 1), 5) - 1].increment()
+    }
+}
+
+/// Reports the bytes a connection moved since the last report.
+internal final class TrafficMeter {
+    private let metrics: ServerMetrics
+    private let parser: Parser
+    private let output: BufferedStream
+    private var received = 0
+    private var sent = 0
+
+    init(metrics: ServerMetrics, parser: Parser, output: BufferedStream) {
+        self.metrics = metrics
+        self.parser = parser
+        self.output = output
+    }
+
+    func report() {
+        metrics.receivedBytes.increment(by: parser.bytesRead - received)
+        metrics.sentBytes.increment(by: output.bytesWritten - sent)
+        received = parser.bytesRead
+        sent = output.bytesWritten
+    }
+}
@@ -0,0 +1,359 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+import CZlib
+import Foundation
+
+/// The `permessage-deflate` extension (RFC 7692).
+///
+/// A compressor that keeps its window between messages costs a few hundred
+/// kilobytes per socket, so the server always asks to forget it. Streams
+/// that are reset after every message are only needed while a message is
+/// being processed, which never suspends, so they are borrowed from a
+/// process-wide pool instead of being held by each socket.
+internal final class PerMessageDeflate {
+    static let name = "permessage-deflate"
+
+    /// Offer sent by clients.
+    static let clientOffer = "permessage-deflate; client_no_context_takeover"
+
+    /// The four bytes every sync flush ends with, left out on the wire.
+    private static let tail: [UInt8] = [0x00, 0x00, 0xff, 0xff]
+
+    private let level: Int
+    private let compressorResets: Bool
+    private let decompressorResets: Bool
+
+    /// Streams kept between messages, used when the peer allowed it.
+    private var compressor: OpaquePointer?
+    private var decompressor: OpaquePointer?
+
+    private init(level: Int, compressorResets: Bool, decompressorResets: Bool) {
+        self.level = level
+        self.compressorResets = compressorResets
+        self.decompressorResets = decompressorResets
+    }
+
+    deinit {
+        if let compressor = compressor {
+            czlib_deflate_destroy(compressor)
+        }
+
+        if let decompressor = decompressor {
+            czlib_inflate_destroy(decompressor)
+        }
+    }
+
+    /// Picks the first offer of `header` the server can honour. Returns
+    /// the `Sec-WebSocket-Extensions` answer along with the extension.
+    static func negotiate(offers header: String, level: Int) -> (response: String, PerMessageDeflate)? {
+        offers: for offer in header.split(separator: ",") {
+            let parameters = self.parameters(of: offer)
+
+            guard parameters.first?.name == name else {
+                continue
+            }
+
+            var clientNoContextTakeover = false
+
+            for (name, value) in parameters.dropFirst() {
+                switch name {
+                case "server_no_context_takeover":
+                    break
+                case "client_no_context_takeover":
+                    clientNoContextTakeover = true
+                case "client_max_window_bits":
+                    // Inflating with the largest window handles any other.
+                    break
+                case "server_max_window_bits":
+                    // Raw deflate streams always use the largest window.
+                    guard value == nil || value == "15" else {
+                        continue offers
+                    }
+                default:
+                    continue offers
+                }
+            }
+
+            var response = name + "; server_no_context_takeover"
+
+            if clientNoContextTakeover {
+                response += "; client_no_context_takeover"
+            }
+
+            let deflate = PerMessageDeflate(
+                level: level,
+                compressorResets: true,
+                decompressorResets: clientNoContextTakeover
+            )
+
+            return (response, deflate)
+        }
+
+        return nil
+    }
+
+    /// Reads the server's answer to `clientOffer`.
+    static func accept(response header: String, level: Int) throws -> PerMessageDeflate {
+        let parameters = self.parameters(of: Substring(header))
+
+        guard parameters.first?.name == name else {
+            throw WebSocketError.handshakeFailed("Unsupported extension \(header)")
+        }
+
+        var serverNoContextTakeover = false
+
+        for (name, value) in parameters.dropFirst() {
+            switch name {
+            case "server_no_context_takeover":
+                serverNoContextTakeover = true
+            case "client_no_context_takeover", "server_max_window_bits":
+                break
+            case "client_max_window_bits" where value == nil || value == "15":
+                break
+            default:
+                throw WebSocketError.handshakeFailed("Unsupported extension parameter \(name)")
+            }
+        }
+
+        return PerMessageDeflate(
+            level: level,
+            compressorResets: true,
+            decompressorResets: serverNoContextTakeover
+        )
+    }
+
+    private static func parameters(of offer: Substring) -> [(name: String, value: String?)] {
+        return offer.split(separator: ";").map { parameter in
+            let parts = parameter.split(separator: "=", maxSplits: 1)
+            let name = parts[0].trimmingCharacters(in: .whitespaces).lowercased()
+
+            let value = parts.count > 1 ?
+                parts[1].trimmingCharacters(in: .whitespaces).trimmingCharacters(in: CharacterSet(charactersIn: "\"")) :
+                nil
+
+            return (name, value)
+        }
+    }
+
+    // MARK: Compression
+
+    /// Compresses a whole message payload.
+    func compress(_ payload: UnsafeRawBufferPointer) throws -> [UInt8] {
+        let stream = try borrowCompressor()
+
+        defer {
+            returnCompressor(stream)
+        }
+
+        var output: [UInt8] = []
+        var offset = 0
+        var chunk = [UInt8](repeating: 0, count: max(payload.count / 2, 256))
+
+        while true {
+            var consumed = 0
+            var produced = 0
+
+            let result = chunk.withUnsafeMutableBytes { chunk in
+                czlib_deflate(
+                    stream,
+                    payload.baseAddress.map({ $0 + offset }),
+                    payload.count - offset,
+                    &consumed,
+                    chunk.baseAddress,
+                    chunk.count,
+                    &produced,
+                    CZLIB_SYNC_FLUSH
+                )
+            }
+
+            guard result != CZLIB_ERROR else {
+                throw CompressionError.streamError
+            }
+
+            offset += consumed
+            output.append(contentsOf: chunk[..<produced])
+
+            if offset == payload.count && produced < chunk.count {
+                break
+            }
+        }
+
+        if output.count >= 4 && output.suffix(4).elementsEqual(PerMessageDeflate.tail) {
+            output.removeLast(4)
+        }
+
+        return output
+    }
+
+    /// Inflates a whole message payload, failing once it grows past
+    /// `maximumSize`.
+    func decompress(_ payload: [UInt8], maximumSize: Int) throws -> [UInt8] {
+        let stream = try borrowDecompressor()
+
+        defer {
+            returnDecompressor(stream)
+        }
+
+        var output: [UInt8] = []
+        var chunk = [UInt8](repeating: 0, count: 16 * 1024)
+
+        for input in [payload, PerMessageDeflate.tail] {
+            var offset = 0
+
+            while true {
+                var consumed = 0
+                var produced = 0
+
+                let result = input.withUnsafeBytes { input in
+                    chunk.withUnsafeMutableBytes { chunk in
+                        czlib_inflate(
+                            stream,
+                            input.baseAddress.map({ $0 + offset }),
+                            input.count - offset,
+                            &consumed,
+                            chunk.baseAddress,
+                            chunk.count,
+                            &produced
+                        )
+                    }
+                }
+
+                guard result != CZLIB_ERROR else {
+                    throw CompressionError.corruptStream
+                }
+
+                offset += consumed
+                output.append(contentsOf: chunk[..<produced])
+
+                guard output.count <= maximumSize else {
+                    throw WebSocketError.messageTooBig
+                }
+
+                if result == CZLIB_STREAM_END || (offset == input.count && produced < chunk.count) {
+                    break
+                }
+            }
+        }
+
+        return output
+    }
+
+    private func borrowCompressor() throws -> OpaquePointer {
+        if !compressorResets, let compressor = compressor {
+            return compressor
+        }
+
+        let stream = compressorResets ? PerMessageDeflate.pool.takeCompressor(level: level) : nil
+
+        guard let compressor = stream ?? czlib_deflate_create(CZLIB_RAW, Int32(level)) else {
+            throw CompressionError.initializationFailed
+        }
+
+        return compressor
+    }
+
+    private func returnCompressor(_ stream: OpaquePointer) {
+        if compressorResets {
+            PerMessageDeflate.pool.putCompressor(stream, level: level)
+        } else {
+            compressor = stream
+        }
+    }
+
+    private func borrowDecompressor() throws -> OpaquePointer {
+        if !decompressorResets, let decompressor = decompressor {
+            return decompressor
+        }
+
+        let stream = decompressorResets ? PerMessageDeflate.pool.takeDecompressor() : nil
+
+        guard let decompressor = stream ?? czlib_inflate_create(CZLIB_RAW) else {
+            throw CompressionError.initializationFailed
+        }
+
+        return decompressor
+    }
+
+    private func returnDecompressor(_ stream: OpaquePointer) {
+        if decompressorResets {
+            PerMessageDeflate.pool.putDecompressor(stream)
+        } else {
+            decompressor = stream
+        }
+    }
+
+    private static let pool = StreamPool()
+}
+
+/// zlib streams shared by every socket, reset before reuse. Guarded by a
+/// mutex since servers may run on several threads.
+private final class StreamPool {
+    private let mutex: UnsafeMutablePointer<pthread_mutex_t>
+    private var compressors: [Int: [OpaquePointer]] = [:]
+    private var decompressors: [OpaquePointer] = []
+
+    /// Streams kept per kind; the rest are freed.
+    private let capacity = 16
+
+    init() {
+        mutex = UnsafeMutablePointer.allocate(capacity: 1)
+        pthread_mutex_init(mutex, nil)
+    }
+
+    func takeCompressor(level: Int) -> OpaquePointer? {
+        return locked {
+            compressors[level]?.popLast()
+        }
+    }
+
+    func putCompressor(_ stream: OpaquePointer, level: Int) {
+        let kept: Bool = locked {
+            guard czlib_deflate_reset(stream) == CZLIB_OK, compressors[level, default: []].count < capacity else {
+                return false
+            }
+
+            compressors[level, default: []].append(stream)
+            return true
+        }
+
+        if !kept {
+            czlib_deflate_destroy(stream)
+        }
+    }
+
+    func takeDecompressor() -> OpaquePointer? {
+        return locked {
+            decompressors.popLast()
+        }
+    }
+
+    func putDecompressor(_ stream: OpaquePointer) {
+        let kept: Bool = locked {
+            guard czlib_inflate_reset(stream) == CZLIB_OK, decompressors.count < capacity else {
+                return false
+            }
+
+            decompressors.append(stream)
+            return true
+        }
+
+        if !kept {
+            czlib_inflate_destroy(stream)
+        }
+    }
+
+    private func locked<R>(_ body: () -> R) -> R {
+        pthread_mutex_lock(mutex)
+
+        defer {
+            pthread_mutex_unlock(mutex)
+        }
+
+        return body()
+    }
+}
@@ -0,0 +1,76 @@
+/// SHA-1, needed only to derive `Sec-WebSocket-Accept` (RFC 6455,
+/// section 4.2.2). It is not used for anything security sensitive.
+internal enum SHA1 {
+    static func hash<C : Collection>(_ message: C) -> [UInt8] where C.Element == UInt8 {
+        var state: [UInt32] = [0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0]
+        var bytes = Array(message)
+        let bitCount = UInt64(bytes.count) * 8
+
+        bytes.append(0x80)
+
+        while bytes.count % 64 != 56 {
+            bytes.append(0)
+        }
+
+        for shift in stride(from: 56, through: 0, by: -8) {
+            bytes.append(UInt8(truncatingIfNeeded: bitCount >> UInt64(shift)))
+        }
+
+        var words = [UInt32](repeating: 0, count: 80)
+
+        for chunk in stride(from: 0, to: bytes.count, by: 64) {
+            for index in 0 ..< 16 {
+                let offset = chunk + index * 4
+                words[index] = UInt32(bytes[offset]) << 24 | UInt32(bytes[offset + 1]) << 16 |
+                    UInt32(bytes[offset + 2]) << 8 | UInt32(bytes[offset + 3])
+            }
+
+            for index in 16 ..< 80 {
+                words[index] = rotate(words[index - 3] ^ words[index - 8] ^ words[index - 14] ^ words[index - 16], by: 1)
+            }
+
+            var a = state[0], b = state[1], c = state[2], d = state[3], e = state[4]
+
+            for index in 0 ..< 80 {
+                let f: UInt32
+                let k: UInt32
+
+                switch index {
+                case 0 ..< 20:
+                    f = (b & c) | (~b & d)
+                    k = 0x5A827999
+                case 20 ..< 40:
+                    f = b ^ c ^ d
+                    k = 0x6ED9EBA1
+                case 40 ..< 60:
+                    f = (b & c) | (b & d) | (c & d)
+                    k = 0x8F1BBCDC
+                default:
+                    f = b ^ c ^ d
+                    k = 0xCA62C1D6
+                }
+
+                let temporary = rotate(a, by: 5) &+ f &+ e &+ k &+ words[index]
+                e = d
+                d = c
+                c = rotate(b, by: 30)
+                b = a
+                a = temporary
+            }
+
+            state[0] = state[0] &+ a
+            state[1] = state[1] &+ b
+            state[2] = state[2] &+ c
+            state[3] = state[3] &+ d
+            state[4] = state[4] &+ e
+        }
+
+        return state.flatMap { word in
+            [24, 16, 8, 0].map({ UInt8(truncatingIfNeeded: word >> UInt32($0)) })
+        }
+    }
+
+    private static func rotate(_ value: UInt32, by count: UInt32) -> UInt32 {
+        return value << count | value >> (32 - count)
+    }
+}
@@ -0,0 +1,530 @@
+import Core
+import IO
+import Venice
+
+public enum WebSocketError : Error {
+    case handshakeFailed(String)
+    case protocolError(String)
+    case invalidUTF8
+    case messageTooBig
+    case connectionClosed
+}
+
+extension WebSocketError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case let .handshakeFailed(reason):
+            return "The WebSocket handshake failed: \(reason)."
+        case let .protocolError(reason):
+            return "The peer violated the WebSocket protocol: \(reason)."
+        case .invalidUTF8:
+            return "A text message is not valid UTF-8."
+        case .messageTooBig:
+            return "A message is larger than the maximum message size."
+        case .connectionClosed:
+            return "The WebSocket connection is closed."
+        }
+    }
+}
+
+/// A WebSocket connection (RFC 6455), from either side.
+///
+/// `receive` is meant to be called from one coroutine, which also answers
+/// pings and close frames. Sending is safe from any number of coroutines.
+public final class WebSocket {
+    public enum Message {
+        case text(String)
+        case binary([UInt8])
+    }
+
+    public struct CloseCode : RawRepresentable, Equatable {
+        public let rawValue: UInt16
+
+        public init(rawValue: UInt16) {
+            self.rawValue = rawValue
+        }
+
+        public static let normal = CloseCode(rawValue: 1000)
+        public static let goingAway = CloseCode(rawValue: 1001)
+        public static let protocolError = CloseCode(rawValue: 1002)
+        public static let unsupportedData = CloseCode(rawValue: 1003)
+        public static let noStatus = CloseCode(rawValue: 1005)
+        public static let abnormal = CloseCode(rawValue: 1006)
+        public static let invalidPayload = CloseCode(rawValue: 1007)
+        public static let policyViolation = CloseCode(rawValue: 1008)
+        public static let messageTooBig = CloseCode(rawValue: 1009)
+        public static let internalError = CloseCode(rawValue: 1011)
+
+        /// Whether the code may be sent in a close frame (RFC 6455, section
+        /// 7.4). 1005, 1006 and 1015 only ever describe a closure locally.
+        internal var isValid: Bool {
+            switch rawValue {
+            case 1005, 1006, 1015:
+                return false
+            case 1000 ... 1014, 3000 ... 4999:
+                return true
+            default:
+                return false
+            }
+        }
+    }
+
+    public struct Configuration {
+        /// Largest message accepted, after decompression
+        public var maximumMessageSize: Int = 16 * 1024 * 1024
+
+        /// Messages larger than this are sent in several frames. `nil`
+        /// sends every message in one frame.
+        public var maximumFrameSize: Int? = nil
+
+        /// Size of the buffer frames are read through
+        public var readBufferSize: Int = 4096
+
+        /// Interval between pings. The connection is dropped when nothing
+        /// arrives for two intervals. `nil` disables pings.
+        public var pingInterval: Duration? = 30.seconds
+
+        /// Write timeout
+        public var writeTimeout: Duration = 30.seconds
+
+        /// Negotiate permessage-deflate
+        public var compression: Bool = true
+
+        /// Messages smaller than this are never compressed
+        public var compressionThreshold: Int = 256
+
+        /// zlib compression level, from 1 to 9, or -1 for the default
+        public var compressionLevel: Int = -1
+
+        public init() {}
+
+        public static var `default`: Configuration {
+            return Configuration()
+        }
+    }
+
+    internal enum Role {
+        case server
+        case client
+    }
+
+    /// Subprotocol agreed on during the handshake
+    public let subprotocol: String?
+
+    /// Close code sent by the peer, once the connection is closed
+    public private(set) var closeCode: CloseCode?
+
+    public let configuration: Configuration
+
+    private let stream: DuplexStream
+    internal let role: Role
+    private let reader: WebSocketFrameReader
+    private let writeLock: CoroutineLock
+    internal let deflate: PerMessageDeflate?
+
+    private var closeSent = false
+    private var closed = false
+    fileprivate var unansweredPings = 0
+    private var keepAlive: Coroutine?
+
+    internal init(
+        stream: DuplexStream,
+        role: Role,
+        subprotocol: String?,
+        deflate: PerMessageDeflate?,
+        configuration: Configuration
+    ) throws {
+        self.stream = stream
+        self.role = role
+        self.subprotocol = subprotocol
+        self.deflate = deflate
+        self.configuration = configuration
+        let source = KeepAliveReadable(stream: stream, interval: configuration.pingInterval)
+        self.reader = WebSocketFrameReader(stream: source, bufferSize: configuration.readBufferSize)
+        self.writeLock = try CoroutineLock()
+        source.socket = self
+    }
+
+    deinit {
+        keepAlive?.cancel()
+    }
+
+    /// Whether the connection can still send messages
+    public var isOpen: Bool {
+        return !closeSent && !closed
+    }
+
+    // MARK: Sending
+
+    public func send(_ text: String, deadline: Deadline? = nil) throws {
+        var text = text
+
+        try text.withUTF8 { buffer in
+            try send(UnsafeRawBufferPointer(buffer), opcode: .text, deadline: deadline)
+        }
+    }
+
+    public func send(_ bytes: [UInt8], deadline: Deadline? = nil) throws {
+        try bytes.withUnsafeBytes { buffer in
+            try send(buffer, opcode: .binary, deadline: deadline)
+        }
+    }
+
+    public func send(_ buffer: UnsafeRawBufferPointer, deadline: Deadline? = nil) throws {
+        try send(buffer, opcode: .binary, deadline: deadline)
+    }
+
+    public func ping(_ payload: [UInt8] = [], deadline: Deadline? = nil) throws {
+        guard payload.count <= 125 else {
+            throw WebSocketError.messageTooBig
+        }
+
+        try payload.withUnsafeBytes { buffer in
+            try writeFrames(buffer, opcode: .ping, compressed: false, deadline: deadline)
+        }
+    }
+
+    /// Starts the closing handshake. `receive` returns `nil` once the peer
+    /// confirmed it.
+    public func close(_ code: CloseCode = .normal, reason: String = "", deadline: Deadline? = nil) throws {
+        guard !closeSent, !closed else {
+            return
+        }
+
+        var payload = [UInt8(code.rawValue >> 8), UInt8(code.rawValue & 0xff)]
+        payload.append(contentsOf: reason.utf8.prefix(123))
+        closeSent = true
+
+        try payload.withUnsafeBytes { buffer in
+            try writeFrames(buffer, opcode: .close, compressed: false, deadline: deadline)
+        }
+    }
+
+    internal func send(_ payload: UnsafeRawBufferPointer, opcode: WebSocketFrame.Opcode, deadline: Deadline?) throws {
+        guard !closeSent, !closed else {
+            throw WebSocketError.connectionClosed
+        }
+
+        if let deflate = deflate, payload.count >= configuration.compressionThreshold {
+            let compressed = try deflate.compress(payload)
+
+            try compressed.withUnsafeBytes { buffer in
+                try writeFrames(buffer, opcode: opcode, compressed: true, deadline: deadline)
+            }
+        } else {
+            try writeFrames(payload, opcode: opcode, compressed: false, deadline: deadline)
+        }
+    }
+
+    /// Writes a message, split into frames of at most `maximumFrameSize`.
+    private func writeFrames(
+        _ payload: UnsafeRawBufferPointer,
+        opcode: WebSocketFrame.Opcode,
+        compressed: Bool,
+        deadline: Deadline?
+    ) throws {
+        let deadline = deadline ?? configuration.writeTimeout.fromNow()
+        let frameSize = opcode.isControl ? payload.count : max(configuration.maximumFrameSize ?? payload.count, 1)
+
+        try writeLock.withLock { () -> Void in
+            var offset = 0
+
+            repeat {
+                let count = min(frameSize, payload.count - offset)
+                let final = offset + count == payload.count
+                let mask = role == .client ? WebSocketMask.random() : nil
+
+                var frame: [UInt8] = []
+                frame.reserveCapacity(WebSocketFrame.maximumHeaderSize + count)
+
+                WebSocketFrame.appendHeader(
+                    final: final,
+                    compressed: compressed && offset == 0,
+                    opcode: offset == 0 ? opcode : .continuation,
+                    length: count,
+                    mask: mask,
+                    to: &frame
+                )
+
+                let headerSize = frame.count
+                frame.append(contentsOf: payload[offset ..< offset + count])
+
+                if let mask = mask {
+                    frame.withUnsafeMutableBytes { bytes in
+                        _ = mask.apply(to: UnsafeMutableRawBufferPointer(rebasing: bytes[headerSize...]))
+                    }
+                }
+
+                try frame.withUnsafeBytes { bytes in
+                    try stream.write(bytes, deadline: deadline)
+                }
+
+                offset += count
+            } while offset < payload.count
+        }
+    }
+
+    /// Writes a frame that was serialized ahead of time.
+    internal func write(serialized frame: [UInt8], deadline: Deadline) throws {
+        guard !closeSent, !closed else {
+            throw WebSocketError.connectionClosed
+        }
+
+        try writeLock.withLock {
+            try frame.withUnsafeBytes { bytes in
+                try stream.write(bytes, deadline: deadline)
+            }
+        }
+    }
+
+    // MARK: Receiving
+
+    /// Waits for the next message. Control frames are handled on the way.
+    /// Returns `nil` once the connection has been closed cleanly.
+    public func receive(deadline: Deadline = .never) throws -> Message? {
+        startKeepAlive()
+
+        do {
+            return try receiveMessage(deadline: deadline)
+        } catch let error as WebSocketError {
+            switch error {
+            case .protocolError:
+                try? close(.protocolError)
+            case .invalidUTF8:
+                try? close(.invalidPayload)
+            case .messageTooBig:
+                try? close(.messageTooBig)
+            case .handshakeFailed, .connectionClosed:
+                break
+            }
+
+            shutDown()
+            throw error
+        } catch let error as CompressionError {
+            try? close(.invalidPayload)
+            shutDown()
+            throw error
+        }
+    }
+
+    private func receiveMessage(deadline: Deadline) throws -> Message? {
+        guard !closed else {
+            return nil
+        }
+
+        var message: [UInt8] = []
+        var messageOpcode: WebSocketFrame.Opcode?
+        var compressed = false
+
+        while true {
+            let header = try reader.readHeader(deadline: deadline)
+            try validate(header)
+
+            if header.opcode.isControl {
+                var payload: [UInt8] = []
+                try reader.readPayload(of: header, into: &payload, deadline: deadline)
+
+                if try handleControl(header.opcode, payload: payload) {
+                    return nil
+                }
+
+                continue
+            }
+
+            if header.opcode == .continuation {
+                guard messageOpcode != nil else {
+                    throw WebSocketError.protocolError("Continuation without a message")
+                }
+            } else {
+                guard messageOpcode == nil else {
+                    throw WebSocketError.protocolError("New message inside a fragmented one")
+                }
+
+                messageOpcode = header.opcode
+                compressed = header.compressed
+            }
+
+            // Frames may claim up to `Int.max` bytes; adding to that traps.
+            guard header.length <= configuration.maximumMessageSize - message.count else {
+                throw WebSocketError.messageTooBig
+            }
+
+            try reader.readPayload(of: header, into: &message, deadline: deadline)
+
+            if header.final {
+                break
+            }
+        }
+
+        if compressed, let deflate = deflate {
+            message = try deflate.decompress(message, maximumSize: configuration.maximumMessageSize)
+        }
+
+        guard messageOpcode == .text else {
+            return .binary(message)
+        }
+
+        guard let text = WebSocket.validatedString(message) else {
+            throw WebSocketError.invalidUTF8
+        }
+
+        return .text(text)
+    }
+
+    private func validate(_ header: WebSocketFrame.Header) throws {
+        // Clients mask every frame, servers none.
+        guard (header.mask != nil) == (role == .server) else {
+            throw WebSocketError.protocolError("Wrong masking")
+        }
+
+        if header.compressed {
+            guard deflate != nil, !header.opcode.isControl, header.opcode != .continuation else {
+                throw WebSocketError.protocolError("Unexpected compressed frame")
+            }
+        }
+
+        if header.opcode.isControl {
+            guard header.final, header.length <= 125 else {
+                throw WebSocketError.protocolError("Invalid control frame")
+            }
+        }
+    }
+
+    /// Answers a control frame. Returns `true` once the connection is closed.
+    private func handleControl(_ opcode: WebSocketFrame.Opcode, payload: [UInt8]) throws -> Bool {
+        switch opcode {
+        case .ping:
+            if !closeSent {
+                try payload.withUnsafeBytes { buffer in
+                    try writeFrames(buffer, opcode: .pong, compressed: false, deadline: nil)
+                }
+            }
+
+            return false
+        case .close:
+            var code = CloseCode.noStatus
+
+            if payload.count >= 2 {
+                code = CloseCode(rawValue: UInt16(payload[0]) << 8 | UInt16(payload[1]))
+
+                guard code.isValid else {
+                    throw WebSocketError.protocolError("Invalid close code")
+                }
+
+                guard WebSocket.validatedString(payload[2...]) != nil else {
+                    throw WebSocketError.invalidUTF8
+                }
+            } else if payload.count == 1 {
+                throw WebSocketError.protocolError("Truncated close frame")
+            }
+
+            closeCode = code
+
+            if !closeSent {
+                try? close(code == .noStatus ? .normal : code)
+            }
+
+            shutDown()
+            return true
+        default:
+            return false
+        }
+    }
+
+    /// Stops using the connection. The stream itself belongs to whoever
+    /// upgraded it and is closed by them.
+    internal func shutDown() {
+        guard !closed else {
+            return
+        }
+
+        closed = true
+        keepAlive?.cancel()
+        keepAlive = nil
+    }
+
+    /// Pings the peer every `pingInterval`. Once two pings in a row went
+    /// unanswered for an interval each, reads give up on the peer.
+    private func startKeepAlive() {
+        guard keepAlive == nil, !closed, let interval = configuration.pingInterval else {
+            return
+        }
+
+        keepAlive = try? Coroutine { [weak self] in
+            while true {
+                try Coroutine.wakeUp(interval.fromNow())
+
+                guard let socket = self, socket.isOpen else {
+                    return
+                }
+
+                socket.unansweredPings += 1
+
+                guard socket.unansweredPings <= 2 else {
+                    socket.keepAlive = nil
+                    return
+                }
+
+                try socket.ping()
+            }
+        }
+    }
+
+    private static func validatedString<C : Collection>(_ bytes: C) -> String? where C.Element == UInt8 {
+        var iterator = bytes.makeIterator()
+        var decoder = UTF8()
+
+        while true {
+            switch decoder.decode(&iterator) {
+            case .scalarValue:
+                continue
+            case .emptyInput:
+                return String(decoding: bytes, as: UTF8.self)
+            case .error:
+                return nil
+            }
+        }
+    }
+}
+
+/// Reads the connection at most one ping interval at a time, so the
+/// coroutine in `receive` notices a dead peer by itself. The stream can't
+/// be closed under it, as libdill forbids cleaning up a descriptor that a
+/// coroutine is waiting on.
+private final class KeepAliveReadable : Readable {
+    weak var socket: WebSocket?
+    private let stream: Readable
+    private let interval: Duration?
+
+    init(stream: Readable, interval: Duration?) {
+        self.stream = stream
+        self.interval = interval
+    }
+
+    func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        guard let interval = interval else {
+            return try stream.read(buffer, deadline: deadline)
+        }
+
+        while true {
+            let wakeUp = interval.fromNow()
+            let ownDeadline = deadline.value < 0 || deadline.value > wakeUp.value
+
+            do {
+                let read = try stream.read(buffer, deadline: ownDeadline ? wakeUp : deadline)
+                socket?.unansweredPings = 0
+                return read
+            } catch VeniceError.deadlineReached where ownDeadline {
+                try checkPeer()
+            } catch SystemError.operationTimedOut where ownDeadline {
+                try checkPeer()
+            }
+        }
+    }
+
+    private func checkPeer() throws {
+        guard let socket = socket, socket.unansweredPings <= 2 else {
+            throw WebSocketError.connectionClosed
+        }
+    }
+}
@@ -0,0 +1,109 @@
+import Core
+import Venice
+
+extension WebSocket {
+    /// Sends `text` to every socket in `sockets`.
+    public static func broadcast(_ text: String, to sockets: [WebSocket], deadline: Deadline? = nil) throws {
+        var text = text
+
+        try text.withUTF8 { buffer in
+            try broadcast(UnsafeRawBufferPointer(buffer), opcode: .text, to: sockets, deadline: deadline)
+        }
+    }
+
+    /// Sends `bytes` to every socket in `sockets`.
+    public static func broadcast(_ bytes: [UInt8], to sockets: [WebSocket], deadline: Deadline? = nil) throws {
+        try bytes.withUnsafeBytes { buffer in
+            try broadcast(buffer, opcode: .binary, to: sockets, deadline: deadline)
+        }
+    }
+
+    /// Frames are serialized once, and compressed once per compression
+    /// level, then written to all sockets concurrently so a slow reader
+    /// only delays itself. Sockets whose write fails are closed. Messages
+    /// go out in a single frame whatever `maximumFrameSize` says.
+    private static func broadcast(
+        _ payload: UnsafeRawBufferPointer,
+        opcode: WebSocketFrame.Opcode,
+        to sockets: [WebSocket],
+        deadline: Deadline?
+    ) throws {
+        var plain: [UInt8]?
+        var compressed: [Int: [UInt8]] = [:]
+        var recipients: [(WebSocket, [UInt8])] = []
+
+        for socket in sockets where socket.isOpen {
+            // Client frames carry a mask of their own.
+            guard socket.role == .server else {
+                try? socket.send(payload, opcode: opcode, deadline: deadline)
+                continue
+            }
+
+            if let deflate = socket.deflate, payload.count >= socket.configuration.compressionThreshold {
+                let level = socket.configuration.compressionLevel
+
+                if compressed[level] == nil {
+                    // Servers always reset their compressor between
+                    // messages, so the output suits every socket.
+                    let body = try deflate.compress(payload)
+                    compressed[level] = frame(body, opcode: opcode, compressed: true)
+                }
+
+                recipients.append((socket, compressed[level]!))
+            } else {
+                if plain == nil {
+                    plain = frame(Array(payload), opcode: opcode, compressed: false)
+                }
+
+                recipients.append((socket, plain!))
+            }
+        }
+
+        guard !recipients.isEmpty else {
+            return
+        }
+
+        let done = try Channel<Void>()
+        let group = Coroutine.Group()
+
+        defer {
+            group.cancel()
+        }
+
+        for (socket, frame) in recipients {
+            try group.addCoroutine {
+                do {
+                    try socket.write(
+                        serialized: frame,
+                        deadline: deadline ?? socket.configuration.writeTimeout.fromNow()
+                    )
+                } catch {
+                    socket.shutDown()
+                }
+
+                try done.send((), deadline: .never)
+            }
+        }
+
+        for _ in recipients {
+            try done.receive(deadline: .never)
+        }
+    }
+
+    private static func frame(_ payload: [UInt8], opcode: WebSocketFrame.Opcode, compressed: Bool) -> [UInt8] {
+        var frame: [UInt8] = []
+        frame.reserveCapacity(WebSocketFrame.maximumHeaderSize + payload.count)
+
+        WebSocketFrame.appendHeader(
+            final: true,
+            compressed: compressed,
+            opcode: opcode,
+            length: payload.count,
+            mask: nil,
+            to: &frame
+        )
+
+        frame.append(contentsOf: payload)
+        return frame
+    }
+}
@@ -0,0 +1,313 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+import Venice
+
+/// Frame layer of RFC 6455, section 5.
+internal enum WebSocketFrame {
+    enum Opcode : UInt8 {
+        case continuation = 0x0
+        case text = 0x1
+        case binary = 0x2
+        case close = 0x8
+        case ping = 0x9
+        case pong = 0xa
+
+        var isControl: Bool {
+            return rawValue & 0x8 != 0
+        }
+    }
+
+    struct Header {
+        var final: Bool
+        /// RSV1, set on the first frame of a compressed message
+        var compressed: Bool
+        var opcode: Opcode
+        var mask: WebSocketMask?
+        var length: Int
+    }
+
+    static let maximumHeaderSize = 14
+
+    /// Appends a frame header. Server frames are never masked; client frames
+    /// carry `mask` and their payload must be masked with it.
+    static func appendHeader(
+        final: Bool,
+        compressed: Bool,
+        opcode: Opcode,
+        length: Int,
+        mask: WebSocketMask?,
+        to output: inout [UInt8]
+    ) {
+        output.append((final ? 0x80 : 0) | (compressed ? 0x40 : 0) | opcode.rawValue)
+
+        let maskBit: UInt8 = mask == nil ? 0 : 0x80
+
+        switch length {
+        case 0 ..< 126:
+            output.append(maskBit | UInt8(length))
+        case 126 ... 0xffff:
+            output.append(maskBit | 126)
+            output.append(UInt8(length >> 8))
+            output.append(UInt8(length & 0xff))
+        default:
+            output.append(maskBit | 127)
+
+            for shift in stride(from: 56, through: 0, by: -8) {
+                output.append(UInt8(truncatingIfNeeded: UInt64(length) >> UInt64(shift)))
+            }
+        }
+
+        if let mask = mask {
+            output.append(mask.bytes.0)
+            output.append(mask.bytes.1)
+            output.append(mask.bytes.2)
+            output.append(mask.bytes.3)
+        }
+    }
+}
+
+/// Masking key of a client frame.
+internal struct WebSocketMask {
+    let bytes: (UInt8, UInt8, UInt8, UInt8)
+
+    init(_ bytes: (UInt8, UInt8, UInt8, UInt8)) {
+        self.bytes = bytes
+    }
+
+    static func random() -> WebSocketMask {
+        let value = UInt32.random(in: .min ... .max)
+
+        return WebSocketMask((
+            UInt8(truncatingIfNeeded: value),
+            UInt8(truncatingIfNeeded: value >> 8),
+            UInt8(truncatingIfNeeded: value >> 16),
+            UInt8(truncatingIfNeeded: value >> 24)
+        ))
+    }
+
+    private func byte(_ index: Int) -> UInt8 {
+        switch index & 3 {
+        case 0:
+            return bytes.0
+        case 1:
+            return bytes.1
+        case 2:
+            return bytes.2
+        default:
+            return bytes.3
+        }
+    }
+
+    /// XORs `buffer` with the key, starting `phase` bytes into it, and
+    /// returns the phase the next byte would use. Masking and unmasking are
+    /// the same operation.
+    ///
+    /// Bytes are handled a machine word at a time once the pointer is
+    /// aligned, which the optimizer turns into vector instructions.
+    @discardableResult
+    func apply(to buffer: UnsafeMutableRawBufferPointer, phase: Int = 0) -> Int {
+        guard var pointer = buffer.baseAddress else {
+            return phase
+        }
+
+        var remaining = buffer.count
+        var phase = phase & 3
+
+        while remaining > 0 && Int(bitPattern: pointer) & 7 != 0 {
+            pointer.storeBytes(of: pointer.load(as: UInt8.self) ^ byte(phase), as: UInt8.self)
+            pointer += 1
+            remaining -= 1
+            phase = (phase + 1) & 3
+        }
+
+        if remaining >= 8 {
+            // Eight key bytes as they lie in memory, starting at `phase`.
+            var word: UInt64 = 0
+
+            withUnsafeMutableBytes(of: &word) { bytes in
+                for index in 0 ..< 8 {
+                    bytes[index] = byte(phase + index)
+                }
+            }
+
+            for _ in 0 ..< remaining / 8 {
+                pointer.storeBytes(of: pointer.load(as: UInt64.self) ^ word, as: UInt64.self)
+                pointer += 8
+            }
+
+            remaining &= 7
+        }
+
+        while remaining > 0 {
+            pointer.storeBytes(of: pointer.load(as: UInt8.self) ^ byte(phase), as: UInt8.self)
+            pointer += 1
+            remaining -= 1
+            phase = (phase + 1) & 3
+        }
+
+        return phase
+    }
+}
+
+/// Reads frames from a connection through one buffer, so headers and small
+/// payloads take a single read between them.
+internal final class WebSocketFrameReader {
+    private let stream: Readable
+    private let buffer: UnsafeMutableRawBufferPointer
+    private var start = 0
+    private var end = 0
+
+    init(stream: Readable, bufferSize: Int) {
+        self.stream = stream
+
+        self.buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: max(bufferSize, WebSocketFrame.maximumHeaderSize),
+            alignment: MemoryLayout<UInt64>.alignment
+        )
+    }
+
+    deinit {
+        buffer.deallocate()
+    }
+
+    /// Reads the next frame header. Its payload must be read with
+    /// `readPayload` before the next header.
+    func readHeader(deadline: Deadline) throws -> WebSocketFrame.Header {
+        try fill(2, deadline: deadline)
+
+        let first = buffer[start]
+        let second = buffer[start + 1]
+
+        guard first & 0x30 == 0 else {
+            throw WebSocketError.protocolError("Reserved bits set")
+        }
+
+        guard let opcode = WebSocketFrame.Opcode(rawValue: first & 0x0f) else {
+            throw WebSocketError.protocolError("Unknown opcode")
+        }
+
+        let masked = second & 0x80 != 0
+        var length = Int(second & 0x7f)
+        var headerSize = 2
+
+        switch length {
+        case 126:
+            headerSize += 2
+        case 127:
+            headerSize += 8
+        default:
+            break
+        }
+
+        if masked {
+            headerSize += 4
+        }
+
+        try fill(headerSize, deadline: deadline)
+
+        var offset = start + 2
+
+        if length == 126 {
+            length = Int(buffer[offset]) << 8 | Int(buffer[offset + 1])
+            offset += 2
+        } else if length == 127 {
+            var value: UInt64 = 0
+
+            for index in 0 ..< 8 {
+                value = value << 8 | UInt64(buffer[offset + index])
+            }
+
+            guard value <= UInt64(Int.max) else {
+                throw WebSocketError.messageTooBig
+            }
+
+            length = Int(value)
+            offset += 8
+        }
+
+        var mask: WebSocketMask?
+
+        if masked {
+            mask = WebSocketMask((buffer[offset], buffer[offset + 1], buffer[offset + 2], buffer[offset + 3]))
+        }
+
+        start += headerSize
+
+        return WebSocketFrame.Header(
+            final: first & 0x80 != 0,
+            compressed: first & 0x40 != 0,
+            opcode: opcode,
+            mask: mask,
+            length: length
+        )
+    }
+
+    /// Appends the unmasked payload of `header` to `bytes`. Whatever is
+    /// already buffered is copied; the rest is read straight into `bytes`.
+    func readPayload(of header: WebSocketFrame.Header, into bytes: inout [UInt8], deadline: Deadline) throws {
+        let origin = bytes.count
+        let buffered = min(end - start, header.length)
+
+        bytes.append(contentsOf: UnsafeRawBufferPointer(rebasing: buffer[start ..< start + buffered]))
+        start += buffered
+
+        if buffered < header.length {
+            bytes.append(contentsOf: repeatElement(0, count: header.length - buffered))
+
+            try bytes.withUnsafeMutableBytes { destination in
+                var offset = origin + buffered
+
+                while offset < destination.count {
+                    let read = try stream.read(
+                        UnsafeMutableRawBufferPointer(rebasing: destination[offset...]),
+                        deadline: deadline
+                    )
+
+                    guard !read.isEmpty else {
+                        throw WebSocketError.connectionClosed
+                    }
+
+                    offset += read.count
+                }
+            }
+        }
+
+        if let mask = header.mask {
+            bytes.withUnsafeMutableBytes { destination in
+                _ = mask.apply(to: UnsafeMutableRawBufferPointer(rebasing: destination[origin...]))
+            }
+        }
+    }
+
+    /// Makes sure `count` bytes are buffered from `start`.
+    private func fill(_ count: Int, deadline: Deadline) throws {
+        guard end - start < count else {
+            return
+        }
+
+        if start > 0 {
+            let buffered = end - start
+            memmove(buffer.baseAddress!, buffer.baseAddress! + start, buffered)
+            start = 0
+            end = buffered
+        }
+
+        while end < count {
+            let read = try stream.read(
+                UnsafeMutableRawBufferPointer(rebasing: buffer[end...]),
+                deadline: deadline
+            )
+
+            guard !read.isEmpty else {
+                throw WebSocketError.connectionClosed
+            }
+
+            end += read.count
+        }
+    }
+}
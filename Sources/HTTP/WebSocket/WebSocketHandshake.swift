@@ -0,0 +1,181 @@
+import Core
+import IO
+import Venice
+import Foundation
+
+extension WebSocket {
+    private static let guid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+    /// `Sec-WebSocket-Accept` value answering `key`.
+    internal static func accept(forKey key: String) -> String {
+        return Data(SHA1.hash(Array((key + guid).utf8))).base64EncodedString()
+    }
+
+    /// Connects to a `ws` or `wss` URI and runs `body` with the socket. The
+    /// connection is closed once `body` returns.
+    public static func connect(
+        to uri: String,
+        subprotocols: [String] = [],
+        headers: Headers = [:],
+        configuration: Configuration = .default,
+        clientConfiguration: Client.Configuration = .default,
+        body: @escaping (WebSocket) throws -> Void
+    ) throws {
+        var uri = try URI(uri)
+
+        switch uri.scheme {
+        case "ws"?:
+            uri.scheme = "http"
+        case "wss"?:
+            uri.scheme = "https"
+        default:
+            break
+        }
+
+        let key = Data((0 ..< 16).map({ _ in UInt8.random(in: .min ... .max) })).base64EncodedString()
+        let request = Request(method: .get, uri: uri, headers: headers, body: .empty)
+
+        request.headers["Upgrade"] = "websocket"
+        request.headers["Connection"] = "Upgrade"
+        request.headers["Sec-WebSocket-Key"] = key
+        request.headers["Sec-WebSocket-Version"] = "13"
+
+        if !subprotocols.isEmpty {
+            request.headers["Sec-WebSocket-Protocol"] = subprotocols.joined(separator: ", ")
+        }
+
+        if configuration.compression {
+            request.headers["Sec-WebSocket-Extensions"] = PerMessageDeflate.clientOffer
+        }
+
+        request.upgradeConnection = { response, stream in
+            guard response.status == .switchingProtocols else {
+                throw WebSocketError.handshakeFailed("Server answered \(response.status)")
+            }
+
+            guard
+                response.upgrade?.lowercased() == "websocket",
+                response.headers["Sec-WebSocket-Accept"] == accept(forKey: key)
+            else {
+                throw WebSocketError.handshakeFailed("Invalid upgrade response")
+            }
+
+            let subprotocol = response.headers["Sec-WebSocket-Protocol"]
+
+            if let subprotocol = subprotocol, !subprotocols.contains(subprotocol) {
+                throw WebSocketError.handshakeFailed("Unrequested subprotocol \(subprotocol)")
+            }
+
+            var deflate: PerMessageDeflate?
+
+            if let extensions = response.headers["Sec-WebSocket-Extensions"] {
+                guard configuration.compression else {
+                    throw WebSocketError.handshakeFailed("Unrequested extension \(extensions)")
+                }
+
+                deflate = try PerMessageDeflate.accept(response: extensions, level: configuration.compressionLevel)
+            }
+
+            let socket = try WebSocket(
+                stream: stream,
+                role: .client,
+                subprotocol: subprotocol,
+                deflate: deflate,
+                configuration: configuration
+            )
+
+            try socket.run(body)
+        }
+
+        _ = try Client.send(request, configuration: clientConfiguration)
+    }
+
+    /// Runs `body`, then closes the connection unless it already is.
+    internal func run(_ body: (WebSocket) throws -> Void) throws {
+        defer {
+            try? close(.goingAway)
+            shutDown()
+        }
+
+        try body(self)
+    }
+}
+
+extension Request {
+    /// Whether the request asks to open a WebSocket connection.
+    public var isWebSocketUpgrade: Bool {
+        let connection = self.connection?.lowercased() ?? ""
+
+        return method == .get &&
+            upgrade?.lowercased() == "websocket" &&
+            connection.split(separator: ",").contains(where: { $0.trimmingCharacters(in: .whitespaces) == "upgrade" })
+    }
+}
+
+extension Response {
+    /// Accepts the WebSocket handshake of `request` and runs `body` with the
+    /// socket once the response has been sent. Invalid handshakes are
+    /// answered with `400 Bad Request`. The first of `subprotocols` the
+    /// client offered is selected.
+    public convenience init(
+        webSocketUpgradeFor request: Request,
+        subprotocols: [String] = [],
+        configuration: WebSocket.Configuration = .default,
+        body: @escaping (WebSocket) throws -> Void
+    ) {
+        guard
+            request.isWebSocketUpgrade,
+            request.headers["Sec-WebSocket-Version"] == "13",
+            let key = request.headers["Sec-WebSocket-Key"],
+            Data(base64Encoded: key)?.count == 16
+        else {
+            self.init(status: .badRequest, headers: ["Sec-WebSocket-Version": "13"])
+            return
+        }
+
+        var headers: Headers = [
+            "Upgrade": "websocket",
+            "Connection": "Upgrade",
+            "Sec-WebSocket-Accept": WebSocket.accept(forKey: key),
+        ]
+
+        let offered = request.headers["Sec-WebSocket-Protocol"]?
+            .split(separator: ",")
+            .map({ $0.trimmingCharacters(in: .whitespaces) }) ?? []
+
+        let subprotocol = subprotocols.first(where: offered.contains)
+
+        if let subprotocol = subprotocol {
+            headers["Sec-WebSocket-Protocol"] = subprotocol
+        }
+
+        var deflate: PerMessageDeflate?
+
+        if configuration.compression, let offers = request.headers["Sec-WebSocket-Extensions"] {
+            if let (response, extensionState) = PerMessageDeflate.negotiate(
+                offers: offers,
+                level: configuration.compressionLevel
+            ) {
+                headers["Sec-WebSocket-Extensions"] = response
+                deflate = extensionState
+            }
+        }
+
+        self.init(status: .switchingProtocols, headers: headers)
+
+        // Responses to an upgrade carry no body, nor a length for one.
+        contentLength = nil
+
+        upgradeConnection = { _, stream in
+            let socket = try WebSocket(
+                stream: stream,
+                role: .server,
+                subprotocol: subprotocol,
+                deflate: deflate,
+                configuration: configuration
+            )
+
+            try socket.run(body)
+        }
+    }
+}
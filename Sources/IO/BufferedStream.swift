@@ -0,0 +1,321 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+
+public enum BufferedStreamError : Error {
+    case unexpectedEndOfStream
+    case exceedsReadBufferSize
+    case exceedsMaximumCount
+}
+
+extension BufferedStreamError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .unexpectedEndOfStream:
+            return "The stream ended before the requested bytes could be read."
+        case .exceedsReadBufferSize:
+            return "The requested bytes do not fit in the read buffer."
+        case .exceedsMaximumCount:
+            return "The delimiter was not found within the maximum number of bytes."
+        }
+    }
+}
+
+/// Wraps a `DuplexStream` with a read-ahead and a write-behind buffer.
+///
+/// Reads are served from the read-ahead buffer and refill it with as much as
+/// the underlying stream returns. Reads at least as large as the buffer
+/// bypass it. Writes accumulate until `writeBufferSize` bytes are pending, at
+/// which point they are flushed in a single write. Call `flush(deadline:)`
+/// once a message is complete; `close(deadline:)` flushes automatically.
+public final class BufferedStream : DuplexStream, Flushable, TransparentWritable {
+    public let stream: DuplexStream
+    public let readBufferSize: Int
+    public let writeBufferSize: Int
+
+    private let readBuffer: UnsafeMutableRawBufferPointer
+    private var readStart = 0
+    private var readEnd = 0
+
+    private let writeBuffer: UnsafeMutableRawBufferPointer
+    private var writeEnd = 0
+
+    /// Bytes written so far, buffered or not
+    public private(set) var bytesWritten = 0
+
+    public init(
+        _ stream: DuplexStream,
+        readBufferSize: Int = 4096,
+        writeBufferSize: Int = 4096
+    ) {
+        self.stream = stream
+        self.readBufferSize = max(readBufferSize, 0)
+        self.writeBufferSize = max(writeBufferSize, 0)
+
+        self.readBuffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: self.readBufferSize,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+
+        self.writeBuffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: self.writeBufferSize,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+    }
+
+    deinit {
+        readBuffer.deallocate()
+        writeBuffer.deallocate()
+    }
+
+    /// Number of bytes read ahead and not yet consumed.
+    public var bufferedReadCount: Int {
+        return readEnd - readStart
+    }
+
+    /// Number of bytes written and not yet flushed.
+    public var bufferedWriteCount: Int {
+        return writeEnd
+    }
+
+    public func open(deadline: Deadline) throws {
+        try stream.open(deadline: deadline)
+    }
+
+    public func close(deadline: Deadline) throws {
+        defer {
+            readStart = 0
+            readEnd = 0
+            writeEnd = 0
+        }
+
+        try flush(deadline: deadline)
+        try stream.close(deadline: deadline)
+    }
+
+    // MARK: Reading
+
+    public func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        guard let destination = buffer.baseAddress, !buffer.isEmpty else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+
+        if bufferedReadCount == 0 {
+            if buffer.count >= readBufferSize {
+                return try stream.read(buffer, deadline: deadline)
+            }
+
+            guard try fill(deadline: deadline) else {
+                return UnsafeRawBufferPointer(start: nil, count: 0)
+            }
+        }
+
+        let count = min(buffer.count, bufferedReadCount)
+        memcpy(destination, readBuffer.baseAddress! + readStart, count)
+        readStart += count
+        return UnsafeRawBufferPointer(start: destination, count: count)
+    }
+
+    /// Returns up to `count` bytes without consuming them.
+    ///
+    /// Fewer bytes are returned only if the stream ends first. The returned
+    /// buffer is valid until the next call on the stream.
+    public func peek(_ count: Int, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        guard count <= readBufferSize else {
+            throw BufferedStreamError.exceedsReadBufferSize
+        }
+
+        while bufferedReadCount < count {
+            guard try fill(deadline: deadline) else {
+                break
+            }
+        }
+
+        return UnsafeRawBufferPointer(
+            start: readBuffer.baseAddress.map({ $0 + readStart }),
+            count: min(count, bufferedReadCount)
+        )
+    }
+
+    /// Reads exactly `count` bytes, throwing if the stream ends first.
+    public func readExactly(count: Int, deadline: Deadline) throws -> [UInt8] {
+        var bytes = [UInt8](repeating: 0, count: count)
+        var offset = 0
+
+        try bytes.withUnsafeMutableBytes { bytes in
+            while offset < count {
+                #if swift(>=3.2)
+                    let remaining = UnsafeMutableRawBufferPointer(rebasing: bytes[offset...])
+                #else
+                    let remaining = bytes.suffix(from: offset)
+                #endif
+
+                let read = try self.read(remaining, deadline: deadline)
+
+                guard !read.isEmpty else {
+                    throw BufferedStreamError.unexpectedEndOfStream
+                }
+
+                offset += read.count
+            }
+        }
+
+        return bytes
+    }
+
+    /// Reads up to and including `delimiter`, returning the bytes before it.
+    ///
+    /// Throws `exceedsMaximumCount` if the delimiter is not found within
+    /// `maximumCount` bytes and `unexpectedEndOfStream` if the stream ends first.
+    public func readUntil(
+        delimiter: [UInt8],
+        maximumCount: Int = .max,
+        deadline: Deadline
+    ) throws -> [UInt8] {
+        precondition(!delimiter.isEmpty, "Delimiter must not be empty")
+
+        guard delimiter.count <= readBufferSize else {
+            throw BufferedStreamError.exceedsReadBufferSize
+        }
+
+        var bytes: [UInt8] = []
+
+        while true {
+            let buffered = UnsafeRawBufferPointer(
+                start: readBuffer.baseAddress.map({ $0 + readStart }),
+                count: bufferedReadCount
+            )
+
+            if let index = search(delimiter, in: buffered) {
+                guard bytes.count + index <= maximumCount else {
+                    throw BufferedStreamError.exceedsMaximumCount
+                }
+
+                bytes.append(contentsOf: buffered[0 ..< index])
+                readStart += index + delimiter.count
+                return bytes
+            }
+
+            // Keep a possible partial match at the tail for the next round.
+            let consumable = max(buffered.count - (delimiter.count - 1), 0)
+            bytes.append(contentsOf: buffered[0 ..< consumable])
+            readStart += consumable
+
+            guard bytes.count <= maximumCount else {
+                throw BufferedStreamError.exceedsMaximumCount
+            }
+
+            guard try fill(deadline: deadline) else {
+                throw BufferedStreamError.unexpectedEndOfStream
+            }
+        }
+    }
+
+    /// Reads more bytes into the read-ahead buffer.
+    /// Returns `false` when the underlying stream has ended.
+    private func fill(deadline: Deadline) throws -> Bool {
+        guard let base = readBuffer.baseAddress, readBufferSize > 0 else {
+            throw BufferedStreamError.exceedsReadBufferSize
+        }
+
+        if readStart > 0 {
+            let count = bufferedReadCount
+
+            if count > 0 {
+                memmove(base, base + readStart, count)
+            }
+
+            readStart = 0
+            readEnd = count
+        }
+
+        guard readEnd < readBufferSize else {
+            throw BufferedStreamError.exceedsReadBufferSize
+        }
+
+        let free = UnsafeMutableRawBufferPointer(start: base + readEnd, count: readBufferSize - readEnd)
+        let read = try stream.read(free, deadline: deadline)
+
+        guard !read.isEmpty else {
+            return false
+        }
+
+        readEnd += read.count
+        return true
+    }
+
+    private func search(_ delimiter: [UInt8], in buffer: UnsafeRawBufferPointer) -> Int? {
+        guard let base = buffer.baseAddress, buffer.count >= delimiter.count else {
+            return nil
+        }
+
+        let first = Int32(delimiter[0])
+        let last = buffer.count - delimiter.count
+        var offset = 0
+
+        return delimiter.withUnsafeBytes { delimiter -> Int? in
+            while offset <= last {
+                guard let match = memchr(base + offset, first, last - offset + 1) else {
+                    return nil
+                }
+
+                let index = base.distance(to: UnsafeRawPointer(match))
+
+                if memcmp(base + index, delimiter.baseAddress!, delimiter.count) == 0 {
+                    return index
+                }
+
+                offset = index + 1
+            }
+
+            return nil
+        }
+    }
+
+    // MARK: Writing
+
+    public func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        guard let source = buffer.baseAddress, !buffer.isEmpty else {
+            return
+        }
+
+        bytesWritten += buffer.count
+
+        if writeEnd + buffer.count > writeBufferSize {
+            try flush(deadline: deadline)
+        }
+
+        guard buffer.count < writeBufferSize else {
+            try stream.write(buffer, deadline: deadline)
+            return
+        }
+
+        memcpy(writeBuffer.baseAddress! + writeEnd, source, buffer.count)
+        writeEnd += buffer.count
+    }
+
+    /// Writes every pending byte to the underlying stream.
+    public func flush(deadline: Deadline) throws {
+        guard writeEnd > 0 else {
+            return
+        }
+
+        let pending = UnsafeRawBufferPointer(start: writeBuffer.baseAddress, count: writeEnd)
+        writeEnd = 0
+        try stream.write(pending, deadline: deadline)
+    }
+
+    public func beginTransparentWrite(count: Int, deadline: Deadline) throws -> Writable? {
+        try flush(deadline: deadline)
+        bytesWritten += count
+        return stream
+    }
+}
@@ -0,0 +1,123 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+import CLibdill
+import CSystem
+
+/// Reports changes to the entries of a set of directories (inotify).
+///
+/// Linux only; `init` throws `SystemError.functionNotImplemented` elsewhere.
+public final class DirectoryWatcher {
+    public enum Change {
+        /// Entry `name` of `directory` was created, modified, moved or deleted.
+        /// `name` is empty when the directory itself went away.
+        case entry(directory: String, name: String)
+        /// Events were lost; everything should be considered stale.
+        case overflow
+    }
+
+    private let descriptor: Int32
+    private var directories: [Int32: String] = [:]
+    private var watches: [String: Int32] = [:]
+    private let buffer: UnsafeMutableRawBufferPointer
+
+    public init() throws {
+        let descriptor = csystem_watch_create()
+
+        guard descriptor != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        self.descriptor = descriptor
+
+        self.buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 16 * 1024,
+            alignment: MemoryLayout<Int32>.alignment
+        )
+    }
+
+    deinit {
+        fdclean(descriptor)
+        close(descriptor)
+        buffer.deallocate()
+    }
+
+    /// Starts watching `directory`. Watching a directory twice does nothing.
+    public func watch(directory: String) throws {
+        guard watches[directory] == nil else {
+            return
+        }
+
+        let watch = csystem_watch_add(descriptor, directory)
+
+        guard watch != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        watches[directory] = watch
+        directories[watch] = directory
+    }
+
+    /// Parks until at least one change is available and returns every
+    /// change read so far.
+    public func changes(deadline: Deadline) throws -> [Change] {
+        while true {
+            let result = read(descriptor, buffer.baseAddress, buffer.count)
+
+            guard result != -1 else {
+                switch errno {
+                case EAGAIN, EWOULDBLOCK:
+                    try Socket.wait(descriptor, for: .read, deadline: deadline)
+                    continue
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            return decode(count: result)
+        }
+    }
+
+    private func decode(count: Int) -> [Change] {
+        var changes: [Change] = []
+        var offset = 0
+        var watch: Int32 = 0
+        var name: UnsafePointer<CChar>?
+        var removed: Int32 = 0
+
+        while csystem_watch_event(buffer.baseAddress, count, &offset, &watch, &name, &removed) == 1 {
+            guard watch != -1 else {
+                changes.append(.overflow)
+                continue
+            }
+
+            guard let directory = directories[watch] else {
+                continue
+            }
+
+            let entry = name.map({ String(cString: $0) }) ?? ""
+
+            if removed != 0 {
+                directories[watch] = nil
+                watches[directory] = nil
+            }
+
+            changes.append(.entry(directory: directory, name: entry))
+        }
+
+        return changes
+    }
+}
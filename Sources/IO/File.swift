@@ -0,0 +1,198 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+import CSystem
+
+public enum FileError : Error {
+    case notRegularFile
+    case rangeOutOfBounds
+    case unexpectedEndOfFile
+}
+
+extension FileError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .notRegularFile:
+            return "The path does not name a regular file."
+        case .rangeOutOfBounds:
+            return "The byte range lies outside the file."
+        case .unexpectedEndOfFile:
+            return "The file was truncated while it was being sent."
+        }
+    }
+}
+
+/// Regular file opened for reading that can be written to a stream without
+/// copying it through userspace.
+///
+/// Plain sockets (`TCPStream`, `UnixStream`) receive the file with
+/// `sendfile(2)`. Every other stream, e.g. TLS, is fed from a buffer filled
+/// with `pread(2)`, which unlike a memory mapping fails cleanly if the file
+/// is truncated meanwhile.
+public final class File {
+    /// Bytes read at a time when `sendfile` is not available.
+    public static let readBufferSize = 256 * 1024
+
+    /// Buffers for `pread` copies, one per copy in progress.
+    private static let readBuffers = CheckoutPool<UnsafeMutableRawBufferPointer>(maximumIdle: 8)
+
+    public let descriptor: Int32
+    public let size: Int
+    /// Last modification time in seconds since the epoch.
+    public let modificationTime: Int
+    /// Inode number, which changes when the file is replaced.
+    public let inode: UInt64
+    private let closeOnDeinit: Bool
+
+    /// Opens the file at `path` and closes it when released.
+    public convenience init(path: String) throws {
+        let descriptor = open(path, O_RDONLY | O_CLOEXEC)
+
+        guard descriptor != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        do {
+            try self.init(descriptor: descriptor, closeOnDeinit: true)
+        } catch {
+            close(descriptor)
+            throw error
+        }
+    }
+
+    /// Wraps an already open descriptor.
+    public init(descriptor: Int32, closeOnDeinit: Bool = false) throws {
+        var info = stat()
+
+        guard fstat(descriptor, &info) != -1 else {
+            throw SystemError.lastOperationError
+        }
+
+        guard (info.st_mode & S_IFMT) == S_IFREG else {
+            throw FileError.notRegularFile
+        }
+
+        self.descriptor = descriptor
+        self.size = Int(info.st_size)
+        self.inode = UInt64(info.st_ino)
+        self.closeOnDeinit = closeOnDeinit
+
+        #if os(Linux)
+            self.modificationTime = Int(info.st_mtim.tv_sec)
+        #else
+            self.modificationTime = Int(info.st_mtimespec.tv_sec)
+        #endif
+    }
+
+    deinit {
+        if closeOnDeinit {
+            close(descriptor)
+        }
+    }
+
+    /// Writes `range` of the file, or all of it if `nil`, to `stream`.
+    public func write(_ range: Range<Int>? = nil, to stream: Writable, deadline: Deadline) throws {
+        let range = range ?? 0 ..< size
+
+        guard range.lowerBound >= 0, range.upperBound <= size else {
+            throw FileError.rangeOutOfBounds
+        }
+
+        guard !range.isEmpty else {
+            return
+        }
+
+        let stream = try stream.transparentDestination(count: range.count, deadline: deadline)
+
+        if let socket = stream as? SocketStream {
+            try socket.assertOpen()
+
+            if try send(range, to: socket.handle, deadline: deadline) {
+                return
+            }
+        }
+
+        try copy(range, to: stream, deadline: deadline)
+    }
+
+    /// Returns `false` if the platform cannot `sendfile` to `socket`.
+    private func send(_ range: Range<Int>, to socket: Int32, deadline: Deadline) throws -> Bool {
+        let start = off_t(range.lowerBound)
+        let end = off_t(range.upperBound)
+        var offset = start
+
+        while offset < end {
+            let result = csystem_sendfile(socket, descriptor, &offset, Int(end - offset))
+
+            guard result != -1 else {
+                switch errno {
+                case EAGAIN, EWOULDBLOCK:
+                    try Socket.wait(socket, for: .write, deadline: deadline)
+                    continue
+                case EINTR:
+                    continue
+                case ENOSYS, EINVAL, EOPNOTSUPP:
+                    guard offset == start else {
+                        throw SystemError.lastOperationError
+                    }
+
+                    return false
+                case EPIPE:
+                    throw SystemError.brokenPipe
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            guard result > 0 else {
+                throw FileError.unexpectedEndOfFile
+            }
+        }
+
+        return true
+    }
+
+    private func copy(_ range: Range<Int>, to stream: Writable, deadline: Deadline) throws {
+        let buffer = File.readBuffers.checkOut() ?? UnsafeMutableRawBufferPointer.allocate(
+            byteCount: File.readBufferSize,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+
+        defer {
+            if !File.readBuffers.checkIn(buffer) {
+                buffer.deallocate()
+            }
+        }
+
+        var offset = range.lowerBound
+
+        while offset < range.upperBound {
+            let count = min(buffer.count, range.upperBound - offset)
+            let result = pread(descriptor, buffer.baseAddress, count, off_t(offset))
+
+            guard result != -1 else {
+                switch errno {
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            guard result > 0 else {
+                throw FileError.unexpectedEndOfFile
+            }
+
+            try stream.write(UnsafeRawBufferPointer(rebasing: buffer[0 ..< result]), deadline: deadline)
+            offset += result
+        }
+    }
+}
@@ -3,4 +3,14 @@ import Core
 
 public protocol Host {
     func accept(deadline: Deadline) throws -> DuplexStream
+    
+    /// Accepts at least one connection, then drains up to `count` connections
+    /// that are already pending without blocking again.
+    func accept(upTo count: Int, deadline: Deadline) throws -> [DuplexStream]
+}
+
+extension Host {
+    public func accept(upTo count: Int, deadline: Deadline) throws -> [DuplexStream] {
+        return [try accept(deadline: deadline)]
+    }
 }
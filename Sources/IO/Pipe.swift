@@ -0,0 +1,242 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+import CSystem
+
+/// Copies bytes from `source` to `destination` until `source` ends or
+/// `count` bytes have been copied, returning the number of bytes copied.
+///
+/// When both ends are plain sockets (`TCPStream`, `UnixStream`) the bytes
+/// move through a kernel pipe with `splice(2)` and never enter userspace.
+/// Otherwise, e.g. for TLS, they are copied through a large pooled buffer.
+/// `BufferedStream`s on either end are drained or flushed first so no
+/// buffered byte is skipped. When `count` is given, transparent wrappers
+/// around `destination` are bypassed and account for all `count` bytes up
+/// front.
+@discardableResult
+public func pipe(
+    from source: Readable,
+    to destination: Writable,
+    count: Int? = nil,
+    deadline: Deadline
+) throws -> Int {
+    var source = source
+    var destination = destination
+    var copied = 0
+
+    if let count = count {
+        destination = try destination.transparentDestination(count: count, deadline: deadline)
+    } else if let buffered = destination as? BufferedStream {
+        try buffered.flush(deadline: deadline)
+        destination = buffered.stream
+    }
+
+    if let buffered = source as? BufferedStream {
+        let pending = min(buffered.bufferedReadCount, count ?? .max)
+
+        if pending > 0 {
+            let bytes = try buffered.readExactly(count: pending, deadline: deadline)
+
+            try bytes.withUnsafeBytes {
+                try destination.write($0, deadline: deadline)
+            }
+
+            copied += pending
+        }
+
+        guard buffered.bufferedReadCount == 0 else {
+            return copied
+        }
+
+        source = buffered.stream
+    }
+
+    let remaining = count.map({ $0 - copied })
+
+    #if os(Linux)
+        if let input = source as? SocketStream, let output = destination as? SocketStream {
+            try input.assertOpen()
+            try output.assertOpen()
+            return try copied + Splice.copy(from: input.handle, to: output.handle, count: remaining, deadline: deadline)
+        }
+    #endif
+
+    return try copied + PipeBuffer.copy(from: source, to: destination, count: remaining, deadline: deadline)
+}
+
+/// Resources held by one copy at a time, kept for reuse between copies.
+///
+/// A copy parks its coroutine with bytes in flight, so a resource shared by
+/// concurrent copies would mix up their bytes. Each copy checks one out
+/// instead, from a pool shared by every thread.
+internal final class CheckoutPool<Resource> {
+    private let mutex = UnsafeMutablePointer<pthread_mutex_t>.allocate(capacity: 1)
+    private var idle: [Resource] = []
+    private let maximumIdle: Int
+
+    init(maximumIdle: Int) {
+        self.maximumIdle = maximumIdle
+        pthread_mutex_init(mutex, nil)
+    }
+
+    /// An idle resource, or `nil` if there is none.
+    func checkOut() -> Resource? {
+        pthread_mutex_lock(mutex)
+
+        defer {
+            pthread_mutex_unlock(mutex)
+        }
+
+        return idle.popLast()
+    }
+
+    /// Returns `resource` to the pool. Returns `false` if the pool is full
+    /// and the caller should dispose of it.
+    func checkIn(_ resource: Resource) -> Bool {
+        pthread_mutex_lock(mutex)
+
+        defer {
+            pthread_mutex_unlock(mutex)
+        }
+
+        guard idle.count < maximumIdle else {
+            return false
+        }
+
+        idle.append(resource)
+        return true
+    }
+}
+
+/// Large buffers for userspace copies, one per copy in progress.
+private enum PipeBuffer {
+    static let size = 64 * 1024
+    static let pool = CheckoutPool<UnsafeMutableRawBufferPointer>(maximumIdle: 16)
+
+    static func copy(
+        from source: Readable,
+        to destination: Writable,
+        count: Int?,
+        deadline: Deadline
+    ) throws -> Int {
+        let buffer = pool.checkOut() ?? UnsafeMutableRawBufferPointer.allocate(
+            byteCount: size,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+
+        defer {
+            if !pool.checkIn(buffer) {
+                buffer.deallocate()
+            }
+        }
+
+        var copied = 0
+
+        while count.map({ copied < $0 }) ?? true {
+            let length = min(size, (count ?? .max) - copied)
+
+            #if swift(>=3.2)
+                let chunk = UnsafeMutableRawBufferPointer(rebasing: buffer[0 ..< length])
+            #else
+                let chunk = buffer.prefix(length)
+            #endif
+
+            let read = try source.read(chunk, deadline: deadline)
+
+            guard !read.isEmpty else {
+                break
+            }
+
+            try destination.write(read, deadline: deadline)
+            copied += read.count
+        }
+
+        return copied
+    }
+}
+
+#if os(Linux)
+/// Kernel pipes for splices, one per splice in progress.
+private enum Splice {
+    typealias Pipe = (read: Int32, write: Int32)
+
+    static let chunkSize = 64 * 1024
+    static let pool = CheckoutPool<Pipe>(maximumIdle: 16)
+
+    static func copy(from input: Int32, to output: Int32, count: Int?, deadline: Deadline) throws -> Int {
+        let pipe = try pool.checkOut() ?? makePipe()
+        var copied = 0
+        var buffered = 0
+
+        defer {
+            // Bytes stuck in the pipe would leak into the next splice.
+            if buffered > 0 || !pool.checkIn(pipe) {
+                close(pipe.read)
+                close(pipe.write)
+            }
+        }
+
+        while count.map({ copied < $0 }) ?? true {
+            let length = min(chunkSize, (count ?? .max) - copied)
+            let spliced = csystem_splice(input, pipe.write, length, 0)
+
+            if spliced == -1 {
+                switch errno {
+                case EAGAIN:
+                    try Socket.wait(input, for: .read, deadline: deadline)
+                    continue
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            guard spliced > 0 else {
+                break
+            }
+
+            buffered += spliced
+            let more = count.map({ copied + buffered < $0 }) ?? true
+
+            while buffered > 0 {
+                let drained = csystem_splice(pipe.read, output, buffered, more ? 1 : 0)
+
+                guard drained != -1 else {
+                    switch errno {
+                    case EAGAIN:
+                        try Socket.wait(output, for: .write, deadline: deadline)
+                        continue
+                    case EINTR:
+                        continue
+                    case EPIPE:
+                        throw SystemError.brokenPipe
+                    default:
+                        throw SystemError.lastOperationError
+                    }
+                }
+
+                buffered -= drained
+                copied += drained
+            }
+        }
+
+        return copied
+    }
+
+    private static func makePipe() throws -> Pipe {
+        var fds: [Int32] = [0, 0]
+
+        guard csystem_pipe(&fds) != -1 else {
+            throw SystemError.lastOperationError
+        }
+
+        return (read: fds[0], write: fds[1])
+    }
+}
+#endif
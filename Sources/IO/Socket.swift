@@ -0,0 +1,401 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+import CLibdill
+
+/// Stream backed by a plain socket descriptor, usable by zero-copy paths.
+internal protocol SocketStream : DuplexStream {
+    var handle: Socket.Handle { get }
+    func assertOpen() throws
+}
+
+extension TCPStream : SocketStream {}
+extension UnixStream : SocketStream {}
+
+/// Waits until the peer of `stream` sends more bytes or goes away, and
+/// returns `true` if it went away. Nothing is read, so whatever arrived is
+/// left for the next read. Streams that are not plain sockets cannot be
+/// watched and return `false` right away.
+public func peerDisconnected(from stream: DuplexStream, deadline: Deadline) throws -> Bool {
+    guard let socket = stream as? SocketStream else {
+        return false
+    }
+
+    var byte: UInt8 = 0
+
+    while true {
+        try Socket.wait(socket.handle, for: .read, deadline: deadline)
+
+        let result = recv(socket.handle, &byte, 1, Int32(MSG_PEEK) | Int32(MSG_DONTWAIT))
+
+        guard result != -1 else {
+            switch errno {
+            case EAGAIN, EWOULDBLOCK, EINTR:
+                continue
+            default:
+                // The connection was reset.
+                return true
+            }
+        }
+
+        return result == 0
+    }
+}
+
+/// Thin wrappers around non-blocking BSD socket calls.
+///
+/// Every blocking point parks the current coroutine on libdill's
+/// `fdin`/`fdout` so the raw descriptor stays under our control
+/// (socket options, `sendfile`, `splice`) while still cooperating
+/// with the scheduler.
+internal enum Socket {
+    internal typealias Handle = Int32
+
+    internal static func create(family: Int32) throws -> Handle {
+        return try create(family: family, protocol: 0)
+    }
+
+    internal static func create(family: Int32, protocol: Int32) throws -> Handle {
+        #if os(Linux)
+            let type = Int32(SOCK_STREAM.rawValue) | Int32(SOCK_NONBLOCK.rawValue) | Int32(SOCK_CLOEXEC.rawValue)
+            let result = Glibc.socket(family, type, `protocol`)
+        #else
+            let result = Darwin.socket(family, SOCK_STREAM, `protocol`)
+        #endif
+
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        #if !os(Linux)
+            do {
+                try configure(result)
+                try setOption(result, level: SOL_SOCKET, name: SO_NOSIGPIPE, value: 1)
+            } catch {
+                Darwin.close(result)
+                throw error
+            }
+        #endif
+
+        return result
+    }
+
+    internal static func setOption(_ socket: Handle, level: Int32, name: Int32, value: Int32) throws {
+        var value = value
+
+        let result = setsockopt(
+            socket,
+            level,
+            name,
+            &value,
+            socklen_t(MemoryLayout<Int32>.size)
+        )
+
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    internal static func bind(_ socket: Handle, address: inout ipaddr) throws {
+        try withSocketAddress(&address) { address, length in
+            try bind(socket, address: address, length: length)
+        }
+    }
+
+    internal static func bind(_ socket: Handle, address: UnsafePointer<sockaddr>, length: socklen_t) throws {
+        let result = bind(socket, address, length)
+
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    internal static func bind(_ socket: Handle, _ address: UnsafePointer<sockaddr>, _ length: socklen_t) -> Int32 {
+        #if os(Linux)
+            return Glibc.bind(socket, address, length)
+        #else
+            return Darwin.bind(socket, address, length)
+        #endif
+    }
+
+    internal static func listen(_ socket: Handle, backlog: Int) throws {
+        #if os(Linux)
+            let result = Glibc.listen(socket, Int32(backlog))
+        #else
+            let result = Darwin.listen(socket, Int32(backlog))
+        #endif
+
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    /// Accepts a connection, parking the coroutine until one is pending.
+    internal static func accept(
+        _ socket: Handle,
+        address: UnsafeMutableRawPointer?,
+        length: Int,
+        deadline: Deadline
+    ) throws -> Handle {
+        while true {
+            if let handle = try acceptPending(socket, address: address, length: length) {
+                return handle
+            }
+
+            try wait(socket, for: .read, deadline: deadline)
+        }
+    }
+
+    /// Accepts a connection only if one is already pending.
+    internal static func acceptPending(
+        _ socket: Handle,
+        address: UnsafeMutableRawPointer?,
+        length: Int
+    ) throws -> Handle? {
+        var addressLength = socklen_t(length)
+        let addressPointer = address?.assumingMemoryBound(to: sockaddr.self)
+
+        #if os(Linux)
+            let flags = Int32(SOCK_NONBLOCK.rawValue) | Int32(SOCK_CLOEXEC.rawValue)
+            let result = Glibc.accept4(socket, addressPointer, address == nil ? nil : &addressLength, flags)
+        #else
+            let result = Darwin.accept(socket, addressPointer, address == nil ? nil : &addressLength)
+        #endif
+
+        guard result != -1 else {
+            switch errno {
+            case EAGAIN, EWOULDBLOCK, EINTR, ECONNABORTED:
+                return nil
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        #if !os(Linux)
+            do {
+                try configure(result)
+                try setOption(result, level: SOL_SOCKET, name: SO_NOSIGPIPE, value: 1)
+            } catch {
+                Darwin.close(result)
+                throw error
+            }
+        #endif
+
+        return result
+    }
+
+    internal static func connect(_ socket: Handle, address: inout ipaddr, deadline: Deadline) throws {
+        try withSocketAddress(&address) { address, length in
+            try connect(socket, address: address, length: length, deadline: deadline)
+        }
+    }
+
+    internal static func connect(
+        _ socket: Handle,
+        address: UnsafePointer<sockaddr>,
+        length: socklen_t,
+        deadline: Deadline
+    ) throws {
+        let result = connect(socket, address, length)
+        try finishConnect(socket, result: result, deadline: deadline)
+    }
+
+    internal static func connect(_ socket: Handle, _ address: UnsafePointer<sockaddr>, _ length: socklen_t) -> Int32 {
+        #if os(Linux)
+            return Glibc.connect(socket, address, length)
+        #else
+            return Darwin.connect(socket, address, length)
+        #endif
+    }
+
+    internal static func finishConnect(_ socket: Handle, result: Int32, deadline: Deadline) throws {
+        guard result == -1 else {
+            return
+        }
+
+        guard errno == EINPROGRESS else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        try wait(socket, for: .write, deadline: deadline)
+
+        var error: Int32 = 0
+        var length = socklen_t(MemoryLayout<Int32>.size)
+
+        guard getsockopt(socket, SOL_SOCKET, SO_ERROR, &error, &length) != -1 else {
+            throw SystemError.lastOperationError
+        }
+
+        guard error == 0 else {
+            throw SystemError(errorNumber: error)
+        }
+    }
+
+    internal static func receive(
+        _ socket: Handle,
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> Int {
+        while true {
+            let result = recv(socket, buffer.baseAddress, buffer.count, 0)
+
+            guard result == -1 else {
+                return result
+            }
+
+            switch errno {
+            case EAGAIN, EWOULDBLOCK:
+                try wait(socket, for: .read, deadline: deadline)
+            case EINTR:
+                continue
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    internal static func send(
+        _ socket: Handle,
+        _ buffer: UnsafeRawBufferPointer,
+        flags: Int32 = 0,
+        deadline: Deadline
+    ) throws {
+        guard var pointer = buffer.baseAddress else {
+            return
+        }
+
+        var remaining = buffer.count
+
+        #if os(Linux)
+            let flags = flags | Int32(MSG_NOSIGNAL)
+        #endif
+
+        while remaining > 0 {
+            let result = Socket.send(socket, pointer, remaining, flags)
+
+            guard result != -1 else {
+                switch errno {
+                case EAGAIN, EWOULDBLOCK:
+                    try wait(socket, for: .write, deadline: deadline)
+                    continue
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            pointer += result
+            remaining -= result
+        }
+    }
+
+    private static func send(_ socket: Handle, _ pointer: UnsafeRawPointer, _ count: Int, _ flags: Int32) -> Int {
+        #if os(Linux)
+            return Glibc.send(socket, pointer, count, flags)
+        #else
+            return Darwin.send(socket, pointer, count, flags)
+        #endif
+    }
+
+    internal enum Event {
+        case read
+        case write
+    }
+
+    /// Parks the current coroutine until `socket` is ready for `event`.
+    internal static func wait(_ socket: Handle, for event: Event, deadline: Deadline) throws {
+        let result: Int32
+
+        switch event {
+        case .read:
+            result = fdin(socket, deadline.value)
+        case .write:
+            result = fdout(socket, deadline.value)
+        }
+
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    internal static func close(_ socket: Handle) throws {
+        fdclean(socket)
+
+        #if os(Linux)
+            let result = Glibc.close(socket)
+        #else
+            let result = Darwin.close(socket)
+        #endif
+
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    /// Switches `socket` between blocking and non-blocking mode.
+    ///
+    /// Completion-based I/O wants blocking descriptors so the kernel parks
+    /// the request instead of failing it with `EAGAIN`.
+    internal static func setBlocking(_ socket: Handle, _ blocking: Bool) throws {
+        let flags = fcntl(socket, F_GETFL, 0)
+
+        guard flags != -1 else {
+            throw SystemError.lastOperationError
+        }
+
+        let newFlags = blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK
+
+        guard fcntl(socket, F_SETFL, newFlags) != -1 else {
+            throw SystemError.lastOperationError
+        }
+    }
+
+    #if !os(Linux)
+    private static func configure(_ socket: Handle) throws {
+        let flags = fcntl(socket, F_GETFL, 0)
+
+        guard flags != -1, fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1 else {
+            throw SystemError.lastOperationError
+        }
+
+        guard fcntl(socket, F_SETFD, FD_CLOEXEC) != -1 else {
+            throw SystemError.lastOperationError
+        }
+    }
+    #endif
+
+    private static func withSocketAddress<R>(
+        _ address: inout ipaddr,
+        _ body: (UnsafePointer<sockaddr>, socklen_t) throws -> R
+    ) rethrows -> R {
+        let length = socklen_t(ipaddr_len(&address))
+        return try body(ipaddr_sockaddr(&address), length)
+    }
+}
@@ -0,0 +1,65 @@
+import Venice
+import Core
+
+/// Mechanism driving plain TCP socket I/O.
+public enum SocketBackend {
+    /// Readiness notifications through libdill and one syscall per operation.
+    case poll
+    
+    /// Completion-based I/O batched through an io_uring submission queue.
+    /// Linux only; other platforms throw `SystemError.operationNotSupported`.
+    case ioUring
+}
+
+extension SocketBackend {
+    /// Creates a listening TCP host driven by this backend.
+    public func host(
+        host: String = "",
+        port: Int = 8080,
+        backlog: Int = 128,
+        reusePort: Bool = false,
+        options: SocketOptions = .default
+    ) throws -> Host {
+        switch self {
+        case .poll:
+            return try TCPHost(
+                host: host,
+                port: port,
+                backlog: backlog,
+                reusePort: reusePort,
+                options: options
+            )
+        case .ioUring:
+            #if os(Linux)
+                return try URingHost(
+                    host: host,
+                    port: port,
+                    backlog: backlog,
+                    reusePort: reusePort,
+                    options: options
+                )
+            #else
+                throw SystemError.operationNotSupported
+            #endif
+        }
+    }
+    
+    /// Creates an unopened TCP stream driven by this backend.
+    public func stream(
+        host: String,
+        port: Int,
+        options: SocketOptions = .default,
+        deadline: Deadline
+    ) throws -> DuplexStream {
+        switch self {
+        case .poll:
+            return try TCPStream(host: host, port: port, options: options, deadline: deadline)
+        case .ioUring:
+            #if os(Linux)
+                return try URingStream(host: host, port: port, options: options, deadline: deadline)
+            #else
+                throw SystemError.operationNotSupported
+            #endif
+        }
+    }
+}
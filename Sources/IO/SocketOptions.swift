@@ -0,0 +1,120 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+
+/// Tunables applied to the descriptor underneath a `TCPHost` or `TCPStream`.
+///
+/// Every option defaults to `nil`, which leaves the kernel default untouched.
+/// Options that only make sense on a listening socket are ignored on streams
+/// and vice versa.
+public struct SocketOptions {
+    /// Disables Nagle's algorithm (`TCP_NODELAY`).
+    public var noDelay: Bool?
+
+    /// Coalesces the status line, headers and body of a message into full
+    /// segments before they hit the wire (`TCP_CORK` on Linux, `TCP_NOPUSH` elsewhere).
+    public var cork: Bool?
+
+    /// Seconds a listening socket waits for the first bytes before waking the
+    /// acceptor (`TCP_DEFER_ACCEPT`). Linux only.
+    public var deferAccept: Int?
+
+    /// Length of the TCP Fast Open queue of a listening socket (`TCP_FASTOPEN`).
+    public var fastOpenQueueLength: Int?
+
+    /// Send buffer size in bytes (`SO_SNDBUF`).
+    public var sendBufferSize: Int?
+
+    /// Receive buffer size in bytes (`SO_RCVBUF`).
+    public var receiveBufferSize: Int?
+
+    /// Amount of unsent data in bytes above which the socket stops being
+    /// writable (`TCP_NOTSENT_LOWAT`).
+    public var notSentLowWatermark: Int?
+
+    public init(
+        noDelay: Bool? = nil,
+        cork: Bool? = nil,
+        deferAccept: Int? = nil,
+        fastOpenQueueLength: Int? = nil,
+        sendBufferSize: Int? = nil,
+        receiveBufferSize: Int? = nil,
+        notSentLowWatermark: Int? = nil
+    ) {
+        self.noDelay = noDelay
+        self.cork = cork
+        self.deferAccept = deferAccept
+        self.fastOpenQueueLength = fastOpenQueueLength
+        self.sendBufferSize = sendBufferSize
+        self.receiveBufferSize = receiveBufferSize
+        self.notSentLowWatermark = notSentLowWatermark
+    }
+
+    public static var `default`: SocketOptions {
+        return SocketOptions()
+    }
+}
+
+extension SocketOptions {
+    /// Applies the options that must be set before `listen`.
+    ///
+    /// Buffer sizes are set here as well so accepted sockets inherit them
+    /// and the TCP window scale is negotiated accordingly.
+    internal func applyToListener(_ socket: Socket.Handle) throws {
+        try applyBufferSizes(socket)
+
+        #if os(Linux)
+            if let deferAccept = deferAccept {
+                try Socket.setOption(socket, level: tcpLevel, name: TCP_DEFER_ACCEPT, value: Int32(deferAccept))
+            }
+        #endif
+
+        if let fastOpenQueueLength = fastOpenQueueLength {
+            try Socket.setOption(socket, level: tcpLevel, name: TCP_FASTOPEN, value: Int32(fastOpenQueueLength))
+        }
+    }
+
+    /// Applies the per-connection options.
+    internal func applyToStream(_ socket: Socket.Handle, includingBufferSizes: Bool) throws {
+        if includingBufferSizes {
+            try applyBufferSizes(socket)
+        }
+
+        if let noDelay = noDelay {
+            try Socket.setOption(socket, level: tcpLevel, name: TCP_NODELAY, value: noDelay ? 1 : 0)
+        }
+
+        if let notSentLowWatermark = notSentLowWatermark {
+            try Socket.setOption(
+                socket,
+                level: tcpLevel,
+                name: TCP_NOTSENT_LOWAT,
+                value: Int32(notSentLowWatermark)
+            )
+        }
+    }
+
+    internal static func setCork(_ socket: Socket.Handle, _ corked: Bool) throws {
+        #if os(Linux)
+            try Socket.setOption(socket, level: tcpLevel, name: TCP_CORK, value: corked ? 1 : 0)
+        #else
+            try Socket.setOption(socket, level: tcpLevel, name: TCP_NOPUSH, value: corked ? 1 : 0)
+        #endif
+    }
+
+    private func applyBufferSizes(_ socket: Socket.Handle) throws {
+        if let sendBufferSize = sendBufferSize {
+            try Socket.setOption(socket, level: SOL_SOCKET, name: SO_SNDBUF, value: Int32(sendBufferSize))
+        }
+
+        if let receiveBufferSize = receiveBufferSize {
+            try Socket.setOption(socket, level: SOL_SOCKET, name: SO_RCVBUF, value: Int32(receiveBufferSize))
+        }
+    }
+}
+
+private let tcpLevel = Int32(IPPROTO_TCP)
@@ -0,0 +1,193 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+import CSystem
+
+/// Measures how long the coroutines of a thread run without yielding.
+///
+/// A coroutine of the detector's own asks to be woken up every `interval`.
+/// It can only run once whatever is running yields, so how late it wakes up
+/// is the scheduler's lag: how long every other coroutine on the thread was
+/// kept waiting. Lags of at least `threshold` are stalls, attributed to the
+/// task run with `run(_:_:)` that was running or had last run.
+public final class StallDetector {
+    public struct Stall {
+        /// Nanoseconds the thread did not yield for, at least
+        public let duration: Int
+        /// `MonotonicClock` time the thread yielded
+        public let end: Int
+        /// Task running or last run when the thread stalled
+        public let task: String?
+        /// Symbolic stack of the thread during the stall, if sampled
+        public let stack: [String]
+    }
+
+    /// Nanoseconds between wake-ups, the resolution of lags measured
+    public let interval: Int
+
+    /// Lags of at least this many nanoseconds are stalls
+    public let threshold: Int
+
+    /// Number of the longest stalls kept
+    public let capacity: Int
+
+    /// Whether stalls are sampled for the stack of the stalled thread
+    public let sampleStacks: Bool
+
+    /// Longest stalls so far, longest first
+    public private(set) var longestStalls: [Stall] = []
+
+    private let lag: Histogram?
+    private let stalls: Counter?
+    private var coroutine: Coroutine?
+    private var watchdog: OpaquePointer?
+    private var task: String?
+    private var lastTask: String?
+
+    /// Creates a detector reporting to `metrics`. With `sampleStacks` set,
+    /// a thread of its own interrupts the stalled thread with `SIGPROF`
+    /// for a stack sample, which is then logged with the stall. Calls the
+    /// signal is not restarted for, such as sleeps, may then return early.
+    public init(
+        interval: Int = 10_000_000,
+        threshold: Int = 100_000_000,
+        capacity: Int = 16,
+        sampleStacks: Bool = false,
+        metrics: MetricsRegistry? = .default
+    ) {
+        self.interval = max(interval, 1_000_000)
+        self.threshold = threshold
+        self.capacity = capacity
+        self.sampleStacks = sampleStacks
+
+        lag = metrics?.histogram(
+            "scheduler_lag_seconds",
+            help: "Time coroutines waited for the running one to yield, sampled every interval."
+        )
+
+        stalls = metrics?.counter(
+            "scheduler_stalls_total",
+            help: "Times a coroutine ran without yielding for longer than the stall threshold."
+        )
+    }
+
+    deinit {
+        stop()
+    }
+
+    /// Starts measuring the lag of the current thread.
+    public func start() throws {
+        guard coroutine == nil else {
+            return
+        }
+
+        if sampleStacks {
+            guard let watchdog = csystem_watchdog_start(pthread_self(), Int64(interval + threshold)) else {
+                switch errno {
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            self.watchdog = watchdog
+        }
+
+        coroutine = try Coroutine { [unowned self] in
+            try? self.measure()
+        }
+    }
+
+    /// Stops measuring.
+    public func stop() {
+        coroutine?.cancel()
+        coroutine = nil
+
+        if let watchdog = watchdog {
+            csystem_watchdog_stop(watchdog)
+            self.watchdog = nil
+        }
+    }
+
+    /// Runs `body`, naming it `task` in the stalls it causes.
+    @inline(__always)
+    public func run<T>(_ task: String, _ body: () throws -> T) rethrows -> T {
+        self.task = task
+
+        defer {
+            self.task = nil
+            lastTask = task
+        }
+
+        return try body()
+    }
+
+    private func measure() throws {
+        let milliseconds = interval / 1_000_000
+
+        while true {
+            let expected = MonotonicClock.now() + milliseconds * 1_000_000
+            try Coroutine.wakeUp(milliseconds.milliseconds.fromNow())
+            let now = MonotonicClock.now()
+            let lag = max(now - expected, 0)
+
+            if let watchdog = watchdog {
+                csystem_watchdog_beat(watchdog, Int64(now))
+            }
+
+            self.lag?.record(lag)
+
+            if lag >= threshold {
+                record(Stall(duration: lag, end: now, task: task ?? lastTask, stack: sampledStack()))
+            }
+        }
+    }
+
+    private func record(_ stall: Stall) {
+        stalls?.increment()
+
+        var message = "Coroutine ran for \(stall.duration / 1_000_000) ms without yielding"
+        message += stall.task.map({ " in " + $0 }) ?? ""
+        message += stall.stack.isEmpty ? "." : ":\n" + stall.stack.joined(separator: "\n")
+        Logger.warning(message)
+
+        guard capacity > 0 else {
+            return
+        }
+
+        if longestStalls.count == capacity {
+            guard stall.duration > longestStalls[capacity - 1].duration else {
+                return
+            }
+
+            longestStalls.removeLast()
+        }
+
+        let index = longestStalls.firstIndex(where: { $0.duration < stall.duration }) ?? longestStalls.count
+        longestStalls.insert(stall, at: index)
+    }
+
+    private func sampledStack() -> [String] {
+        guard let watchdog = watchdog else {
+            return []
+        }
+
+        var frames = [UnsafeMutableRawPointer?](repeating: nil, count: 64)
+        let count = Int(csystem_watchdog_take_sample(watchdog, &frames, Int32(frames.count)))
+
+        guard count > 0, let symbols = csystem_stack_symbols(frames, Int32(count)) else {
+            return []
+        }
+
+        defer {
+            free(symbols)
+        }
+
+        // The first frames are the signal handler's.
+        return (0 ..< count).dropFirst(2).compactMap({ symbols[$0].map({ String(cString: $0) }) })
+    }
+}
@@ -16,37 +16,51 @@ public final class TCPHost : Host {
 
     private let handle: Handle
     public let ip: IP
+    public let options: SocketOptions
 
-    private init(handle: Handle, ip: IP) {
+    private init(handle: Handle, ip: IP, options: SocketOptions) {
         self.handle = handle
         self.ip = ip
+        self.options = options
     }
     
     deinit {
-        hclose(handle)
+        try? Socket.close(handle)
     }
 
-    public convenience init(ip: IP, backlog: Int, reusePort: Bool) throws {
+    public convenience init(
+        ip: IP,
+        backlog: Int,
+        reusePort: Bool,
+        options: SocketOptions = .default
+    ) throws {
         var address = ip.address
-        let result = tcp_listen(&address, Int32(backlog))
+        let socket = try Socket.create(family: Int32(ip.family))
         
-        // TODO: Set reusePort
-        
-        guard result != -1 else {
-            switch errno {
-            default:
-                throw SystemError.lastOperationError
+        do {
+            try Socket.setOption(socket, level: SOL_SOCKET, name: SO_REUSEADDR, value: 1)
+            
+            if reusePort {
+                try Socket.setOption(socket, level: SOL_SOCKET, name: SO_REUSEPORT, value: 1)
             }
+            
+            try options.applyToListener(socket)
+            try Socket.bind(socket, address: &address)
+            try Socket.listen(socket, backlog: backlog)
+        } catch {
+            try? Socket.close(socket)
+            throw error
         }
         
-        self.init(handle: result, ip: ip)
+        self.init(handle: socket, ip: ip, options: options)
     }
 
     public convenience init(
         host: String = "",
         port: Int = 8080,
         backlog: Int = 128,
-        reusePort: Bool = false
+        reusePort: Bool = false,
+        options: SocketOptions = .default
     ) throws {
         let ip: IP
         
@@ -56,20 +70,63 @@ public final class TCPHost : Host {
             ip = try IP(local: host, port: port)
         }
         
-        try self.init(ip: ip, backlog: backlog, reusePort: reusePort)
+        try self.init(ip: ip, backlog: backlog, reusePort: reusePort, options: options)
     }
 
     public func accept(deadline: Deadline) throws -> DuplexStream {
         var address = ipaddr()
-        let result = tcp_accept(handle, &address, deadline.value)
         
-        guard result != -1 else {
-            switch errno {
-            default:
-                throw SystemError.lastOperationError
+        let socket = try withUnsafeMutableBytes(of: &address) { address in
+            return try Socket.accept(
+                handle,
+                address: address.baseAddress,
+                length: address.count,
+                deadline: deadline
+            )
+        }
+        
+        return try stream(socket: socket, address: &address)
+    }
+    
+    public func accept(upTo count: Int, deadline: Deadline) throws -> [DuplexStream] {
+        var streams: [DuplexStream] = [try accept(deadline: deadline)]
+        streams.reserveCapacity(count)
+        
+        while streams.count < count {
+            var address = ipaddr()
+            
+            do {
+                let pending = try withUnsafeMutableBytes(of: &address) { address in
+                    return try Socket.acceptPending(
+                        handle,
+                        address: address.baseAddress,
+                        length: address.count
+                    )
+                }
+                
+                guard let socket = pending else {
+                    break
+                }
+                
+                streams.append(try stream(socket: socket, address: &address))
+            } catch {
+                // Hand out what we already have; the error resurfaces on the next call.
+                break
             }
         }
-
-        return TCPStream(handle: result, ip: IP(address: &address), open: true)
+        
+        return streams
+    }
+    
+    private func stream(socket: Handle, address: inout ipaddr) throws -> TCPStream {
+        do {
+            // Buffer sizes are inherited from the listener.
+            try options.applyToStream(socket, includingBufferSizes: false)
+        } catch {
+            try? Socket.close(socket)
+            throw error
+        }
+        
+        return TCPStream(handle: socket, ip: IP(address: &address), options: options, open: true)
     }
 }
@@ -11,29 +11,36 @@ import CLibdill
 public final class TCPStream : DuplexStream {
     internal typealias Handle = Int32
     
-    private var handle: Handle
+    internal private(set) var handle: Handle
     public var ip: IP
+    public let options: SocketOptions
     private var open: Bool
 
-    internal init(handle: Handle, ip: IP, open: Bool) {
+    internal init(handle: Handle, ip: IP, options: SocketOptions, open: Bool) {
         self.handle = handle
         self.ip = ip
+        self.options = options
         self.open = open
     }
     
-    public convenience init(ip: IP) {
-        self.init(handle: -1, ip: ip, open: false)
+    public convenience init(ip: IP, options: SocketOptions = .default) {
+        self.init(handle: -1, ip: ip, options: options, open: false)
     }
 
     deinit {
         if open {
-            hclose(handle)
+            try? Socket.close(handle)
         }
     }
 
-    public convenience init(host: String, port: Int, deadline: Deadline) throws {
+    public convenience init(
+        host: String,
+        port: Int,
+        options: SocketOptions = .default,
+        deadline: Deadline
+    ) throws {
         let ip = try IP(remote: host, port: port, deadline: deadline)
-        self.init(ip: ip)
+        self.init(ip: ip, options: options)
     }
 
     public func open(deadline: Deadline) throws {
@@ -42,16 +49,17 @@ public final class TCPStream : DuplexStream {
         }
  
         var address = ip.address
-        let result = tcp_connect(&address, deadline.value)
+        let socket = try Socket.create(family: Int32(ip.family))
         
-        guard result != -1 else {
-            switch errno {
-            default:
-                throw SystemError.lastOperationError
-            }
+        do {
+            try options.applyToStream(socket, includingBufferSizes: true)
+            try Socket.connect(socket, address: &address, deadline: deadline)
+        } catch {
+            try? Socket.close(socket)
+            throw error
         }
 
-        self.handle = result
+        self.handle = socket
         self.open = true
     }
 
@@ -60,14 +68,7 @@ public final class TCPStream : DuplexStream {
         deadline: Deadline
     ) throws -> UnsafeRawBufferPointer {
         try assertOpen()
-        let result = brecv(handle, buffer.baseAddress, buffer.count, deadline.value)
-        
-        guard result != -1 else {
-            switch errno {
-            default:
-                throw SystemError.lastOperationError
-            }
-        }
+        let result = try Socket.receive(handle, buffer, deadline: deadline)
         
         #if swift(>=3.2)
             return UnsafeRawBufferPointer(rebasing: buffer.prefix(upTo: result))
@@ -78,14 +79,29 @@ public final class TCPStream : DuplexStream {
     
     public func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
         try assertOpen()
-        let result = bsend(handle, buffer.baseAddress, buffer.count, deadline.value)
+        try Socket.send(handle, buffer, deadline: deadline)
+    }
+    
+    /// Holds back partial segments until `uncork` is called.
+    ///
+    /// Does nothing unless the stream was created with `SocketOptions.cork` enabled.
+    public func cork() throws {
+        guard options.cork == true else {
+            return
+        }
         
-        guard result != -1 else {
-            switch errno {
-            default:
-                throw SystemError.lastOperationError
-            }
+        try assertOpen()
+        try SocketOptions.setCork(handle, true)
+    }
+    
+    /// Flushes segments held back by `cork`.
+    public func uncork() throws {
+        guard options.cork == true else {
+            return
         }
+        
+        try assertOpen()
+        try SocketOptions.setCork(handle, false)
     }
     
     public func close(deadline: Deadline) throws {
@@ -95,17 +111,10 @@ public final class TCPStream : DuplexStream {
             open = false
         }
         
-        let result = hclose(handle)
-        
-        guard result != -1 else {
-            switch errno {
-            default:
-                throw SystemError.lastOperationError
-            }
-        }
+        try Socket.close(handle)
     }
     
-    private func assertOpen() throws {
+    internal func assertOpen() throws {
         guard open else {
             throw SystemError.socketIsNotConnected
         }
@@ -35,7 +35,8 @@ public final class TLSHost : Host {
         certificatePath: String,
         keyPath: String,
         backlog: Int,
-        reusePort: Bool
+        reusePort: Bool,
+        alpnProtocols: [String] = []
     ) throws {
         var address = ip.address
         var result = tcp_listen(&address, Int32(backlog))
@@ -77,7 +78,9 @@ public final class TLSHost : Host {
             }
         }
         
-        result = btls_attach_server(socket, UInt64(BTLS_DEFAULT), 0, &keyPair, 1, nil, nil)
+        // Protocols are offered in order of preference, e.g. `["h2", "http/1.1"]`.
+        let alpn = alpnProtocols.isEmpty ? nil : alpnProtocols.joined(separator: ",")
+        result = btls_attach_server(socket, UInt64(BTLS_DEFAULT), 0, &keyPair, 1, nil, alpn)
         
         guard result != -1 else {
             switch errno {
@@ -99,7 +102,8 @@ public final class TLSHost : Host {
         certificatePath: String,
         keyPath: String,
         backlog: Int = 128,
-        reusePort: Bool = false
+        reusePort: Bool = false,
+        alpnProtocols: [String] = []
     ) throws {
         let ip: IP
         
@@ -114,7 +118,8 @@ public final class TLSHost : Host {
             certificatePath: certificatePath,
             keyPath: keyPath,
             backlog: backlog,
-            reusePort: reusePort
+            reusePort: reusePort,
+            alpnProtocols: alpnProtocols
         )
     }
     
@@ -18,6 +18,9 @@ public final class TLSStream : DuplexStream {
     public var ip: IP
     private var open: Bool
     
+    /// Protocols offered through ALPN when opening the connection
+    public var alpnProtocols: [String] = []
+    
     internal init(handle: Handle, socket: Socket, ip: IP, open: Bool) {
         self.handle = handle
         self.socket = socket
@@ -56,6 +59,7 @@ public final class TLSStream : DuplexStream {
         }
         
         let socket = result
+        let alpn = alpnProtocols.isEmpty ? nil : alpnProtocols.joined(separator: ",")
         
         result = btls_attach_client(
             socket,
@@ -67,7 +71,7 @@ public final class TLSStream : DuplexStream {
             ),
             0,
             nil,
-            nil,
+            alpn,
             nil
         )
         
@@ -83,6 +87,25 @@ public final class TLSStream : DuplexStream {
         self.open = true
     }
     
+    /// Protocol selected through ALPN, completing the handshake if needed.
+    public func negotiatedProtocol(deadline: Deadline) throws -> String? {
+        try assertOpen()
+        let result = btls_handshake(handle, deadline.value)
+        
+        guard result != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+        
+        guard let selected = btls_conn_alpn_selected(handle) else {
+            return nil
+        }
+        
+        return String(cString: selected)
+    }
+    
     public func read(
         _ buffer: UnsafeMutableRawBufferPointer,
         deadline: Deadline
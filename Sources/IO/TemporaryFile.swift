@@ -0,0 +1,246 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+
+/// File created for data too large to keep in memory, deleted when
+/// released unless it was moved somewhere else first.
+///
+/// Reads and writes go straight to the file system, which blocks the
+/// thread on slow disks just like any other regular file access.
+public final class TemporaryFile : Readable, Writable {
+    /// Directory new temporary files are created in
+    public static var defaultDirectory: String = {
+        guard let directory = getenv("TMPDIR").map({ String(cString: $0) }), !directory.isEmpty else {
+            return "/tmp"
+        }
+
+        return directory
+    }()
+
+    public private(set) var path: String
+    public let descriptor: Int32
+    /// Bytes written so far
+    public private(set) var size = 0
+    private var readOffset = 0
+    private var moved = false
+
+    public init(directory: String? = nil) throws {
+        var template = Array(((directory ?? TemporaryFile.defaultDirectory) + "/zewo-XXXXXX").utf8CString)
+        let descriptor = template.withUnsafeMutableBufferPointer({ mkstemp($0.baseAddress!) })
+
+        guard descriptor != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        _ = fcntl(descriptor, F_SETFD, FD_CLOEXEC)
+
+        self.descriptor = descriptor
+        self.path = template.withUnsafeBufferPointer({ String(cString: $0.baseAddress!) })
+    }
+
+    deinit {
+        close(descriptor)
+
+        if !moved {
+            unlink(path)
+        }
+    }
+
+    /// Appends `buffer` to the file.
+    public func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        guard let baseAddress = buffer.baseAddress else {
+            return
+        }
+
+        var written = 0
+
+        while written < buffer.count {
+            let result = pwrite(descriptor, baseAddress + written, buffer.count - written, off_t(size))
+
+            guard result != -1 else {
+                switch errno {
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            written += result
+            size += result
+        }
+    }
+
+    /// Reads the file from the start, or from where the last read stopped.
+    public func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        guard let baseAddress = buffer.baseAddress, readOffset < size else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+
+        while true {
+            let result = pread(descriptor, baseAddress, min(buffer.count, size - readOffset), off_t(readOffset))
+
+            guard result != -1 else {
+                switch errno {
+                case EINTR:
+                    continue
+                default:
+                    throw SystemError.lastOperationError
+                }
+            }
+
+            readOffset += result
+            return UnsafeRawBufferPointer(start: baseAddress, count: result)
+        }
+    }
+
+    /// Makes the next read start from the beginning of the file.
+    public func rewind() {
+        readOffset = 0
+    }
+
+    /// Moves the file to `path`, on the same file system, where it stays
+    /// once released.
+    public func move(to path: String) throws {
+        guard rename(self.path, path) != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        self.path = path
+        moved = true
+    }
+
+    /// The file as written so far, to send as a `Body`.
+    public func file() throws -> File {
+        let duplicate = dup(descriptor)
+
+        guard duplicate != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        do {
+            return try File(descriptor: duplicate, closeOnDeinit: true)
+        } catch {
+            close(duplicate)
+            throw error
+        }
+    }
+}
+
+/// Keeps written data in memory until it outgrows `memoryLimit`, then moves
+/// it to a `TemporaryFile`, so only the disk bounds its size.
+public final class SpooledBuffer : Writable {
+    public enum Contents {
+        case bytes([UInt8])
+        case file(TemporaryFile)
+    }
+
+    public let memoryLimit: Int
+    public let directory: String?
+    /// Charged for the bytes kept in memory
+    public let account: MemoryAccount?
+    public private(set) var contents: Contents = .bytes([])
+    private var charged = 0
+
+    public init(memoryLimit: Int, directory: String? = nil, account: MemoryAccount? = nil) {
+        self.memoryLimit = memoryLimit
+        self.directory = directory
+        self.account = account
+    }
+
+    deinit {
+        account?.release(charged)
+    }
+
+    /// Bytes written so far
+    public var size: Int {
+        switch contents {
+        case let .bytes(bytes):
+            return bytes.count
+        case let .file(file):
+            return file.size
+        }
+    }
+
+    public func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        switch contents {
+        case let .file(file):
+            try file.write(buffer, deadline: deadline)
+        case var .bytes(bytes) where bytes.count + buffer.count <= memoryLimit:
+            charged += buffer.count
+            try account?.charge(buffer.count)
+            contents = .bytes([])
+            bytes.append(contentsOf: buffer)
+            contents = .bytes(bytes)
+        case let .bytes(bytes):
+            let file = try TemporaryFile(directory: directory)
+            try bytes.withUnsafeBytes({ try file.write($0, deadline: deadline) })
+            try file.write(buffer, deadline: deadline)
+            contents = .file(file)
+            account?.release(charged)
+            charged = 0
+        }
+    }
+
+    /// Reads back everything written so far. Bytes kept in memory stay
+    /// charged to `account` for as long as the result is around.
+    public func makeReadable() -> Readable {
+        switch contents {
+        case let .bytes(bytes):
+            defer { charged = 0 }
+            return SpooledBytes(bytes, account: account, charged: charged)
+        case let .file(file):
+            file.rewind()
+            return file
+        }
+    }
+}
+
+private final class SpooledBytes : Readable {
+    private let bytes: [UInt8]
+    private var offset = 0
+    private let account: MemoryAccount?
+    private let charged: Int
+
+    init(_ bytes: [UInt8], account: MemoryAccount?, charged: Int) {
+        self.bytes = bytes
+        self.account = account
+        self.charged = charged
+    }
+
+    deinit {
+        account?.release(charged)
+    }
+
+    func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        let count = min(buffer.count, bytes.count - offset)
+
+        guard let baseAddress = buffer.baseAddress, count > 0 else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+
+        _ = bytes.withUnsafeBytes({ memcpy(baseAddress, $0.baseAddress! + offset, count) })
+        offset += count
+        return UnsafeRawBufferPointer(start: baseAddress, count: count)
+    }
+}
@@ -0,0 +1,285 @@
+#if os(Linux)
+
+import Glibc
+import Venice
+import Core
+import CURing
+
+/// io_uring instance shared by every `URingHost` and `URingStream`.
+///
+/// Submissions queued by coroutines during the same scheduler tick are
+/// handed to the kernel with a single `io_uring_enter`. A reaper coroutine
+/// parks on the ring descriptor and wakes the coroutines whose requests
+/// completed. Like the rest of Zewo the ring is meant to be driven from a
+/// single thread; scale out with one process per core.
+internal final class URing {
+    internal typealias Completion = (_ result: Int32, _ more: Bool) -> Void
+    internal typealias Prepare = (OpaquePointer, UInt64) -> Int32
+
+    private static var instance: URing?
+
+    internal static func shared() throws -> URing {
+        if let instance = instance {
+            return instance
+        }
+
+        let ring = try URing(entries: 4096)
+        instance = ring
+        return ring
+    }
+
+    private let ring: OpaquePointer
+    private var nextToken: UInt64 = 1
+    private var completions: [UInt64: Completion] = [:]
+    private var owners: [UInt64: ObjectIdentifier] = [:]
+    private var early: [UInt64: Int32] = [:]
+    private var abandoned: Set<UInt64> = []
+    private var stale: [ObjectIdentifier: (token: UInt64, owner: ObjectIdentifier?)] = [:]
+    private var submitScheduled = false
+    private var reaper: Coroutine?
+
+    private init(entries: UInt32) throws {
+        guard let ring = curing_ring_create(entries) else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+
+        self.ring = ring
+    }
+
+    deinit {
+        reaper?.cancel()
+        curing_ring_destroy(ring)
+    }
+
+    /// Queues a request and registers `completion` to run when it finishes.
+    ///
+    /// The completion stays registered until the kernel reports no more
+    /// results for the request, so it may fire several times for multishot
+    /// requests. Requests of an `owner` can be canceled together with
+    /// `cancelRequests(of:)`.
+    @discardableResult
+    internal func enqueue(
+        _ prepare: Prepare,
+        owner: ObjectIdentifier? = nil,
+        completion: @escaping Completion
+    ) throws -> UInt64 {
+        try startReaper()
+
+        let token = nextToken
+        nextToken += 1
+
+        if prepare(ring, token) == -1 {
+            // Submission queue is full, make room and retry once.
+            try submit()
+
+            guard prepare(ring, token) != -1 else {
+                throw SystemError.lastOperationError
+            }
+        }
+
+        completions[token] = completion
+        owners[token] = owner
+        return token
+    }
+
+    /// Submits everything queued during this scheduler tick.
+    ///
+    /// The first caller yields once so other runnable coroutines get a chance
+    /// to queue their requests, then submits the whole batch.
+    internal func flush() throws {
+        guard !submitScheduled else {
+            return
+        }
+
+        submitScheduled = true
+
+        defer {
+            submitScheduled = false
+        }
+
+        try Coroutine.yield()
+        try submit()
+    }
+
+    /// Runs a single request to completion, parking on `channel`.
+    ///
+    /// If waiting fails, because of the deadline or because the coroutine
+    /// was canceled, the request is canceled without waiting for it. The
+    /// next request on `channel` first waits for the canceled one, so two
+    /// requests on a channel, and the buffer it stands for, never overlap.
+    internal func perform(
+        _ prepare: Prepare,
+        channel: Channel<Int32>,
+        owner: ObjectIdentifier? = nil,
+        deadline: Deadline
+    ) throws -> Int32 {
+        try settle(channel, deadline: deadline)
+
+        var token: UInt64 = 0
+
+        token = try enqueue(prepare, owner: owner) { [unowned self] result, _ in
+            do {
+                try channel.send(result, deadline: .immediately)
+            } catch {
+                // Completed while the requester was not receiving.
+                if self.abandoned.remove(token) == nil {
+                    self.early[token] = result
+                }
+            }
+        }
+
+        let result: Int32
+
+        do {
+            try flush()
+
+            if let early = early.removeValue(forKey: token) {
+                result = early
+            } else {
+                result = try channel.receive(deadline: deadline)
+            }
+        } catch {
+            cancel(token)
+            stale[ObjectIdentifier(channel)] = (token, owner)
+
+            switch error {
+            case VeniceError.deadlineReached:
+                throw SystemError.operationTimedOut
+            default:
+                throw error
+            }
+        }
+
+        guard result >= 0 else {
+            throw SystemError(errorNumber: -result)
+        }
+
+        return result
+    }
+
+    /// Asks the kernel to drop a request and returns right away. The
+    /// reaper discards the result once the request completes.
+    internal func cancel(_ token: UInt64) {
+        early[token] = nil
+
+        guard completions[token] != nil else {
+            return
+        }
+
+        abandoned.insert(token)
+
+        _ = try? enqueue({ ring, cancelToken in
+            curing_prep_cancel(ring, token, cancelToken)
+        }, completion: { _, _ in })
+
+        try? submit()
+    }
+
+    /// Cancels every request of `owner` still in flight.
+    ///
+    /// With `waiting`, blocks the thread until the kernel is done with them,
+    /// for owners about to release the buffers the requests point into.
+    /// Venice parks no canceled coroutine, and this only takes as long as
+    /// the kernel needs to drop the requests. Returns whether the kernel is
+    /// done with all of them.
+    @discardableResult
+    internal func cancelRequests(of owner: ObjectIdentifier, waiting: Bool = false) -> Bool {
+        for (token, candidate) in owners where candidate == owner {
+            cancel(token)
+        }
+
+        stale = stale.filter({ $0.value.owner != owner })
+
+        while waiting, owners.values.contains(owner) {
+            guard curing_wait(ring) != -1 else {
+                break
+            }
+
+            reap()
+        }
+
+        return !owners.values.contains(owner)
+    }
+
+    /// Waits for the request last canceled on `channel`, if it is still in
+    /// flight.
+    private func settle(_ channel: Channel<Int32>, deadline: Deadline) throws {
+        guard let token = stale[ObjectIdentifier(channel)]?.token else {
+            return
+        }
+
+        if completions[token] != nil {
+            // The completion finds us receiving, so its result comes here.
+            do {
+                _ = try channel.receive(deadline: deadline)
+            } catch {
+                switch error {
+                case VeniceError.deadlineReached:
+                    throw SystemError.operationTimedOut
+                default:
+                    throw error
+                }
+            }
+        }
+
+        stale[ObjectIdentifier(channel)] = nil
+    }
+
+    private func submit() throws {
+        guard curing_pending(ring) > 0 else {
+            return
+        }
+
+        guard curing_submit(ring) != -1 else {
+            switch errno {
+            default:
+                throw SystemError.lastOperationError
+            }
+        }
+    }
+
+    private func startReaper() throws {
+        guard reaper == nil else {
+            return
+        }
+
+        let fd = curing_ring_fd(ring)
+
+        reaper = try Coroutine { [unowned self] in
+            while true {
+                try self.submit()
+                try Socket.wait(fd, for: .read, deadline: .never)
+                self.reap()
+            }
+        }
+    }
+
+    private func reap() {
+        var token: UInt64 = 0
+        var result: Int32 = 0
+        var flags: UInt32 = 0
+
+        while curing_peek(ring, &token, &result, &flags) == 1 {
+            let more = curing_has_more(flags) != 0
+
+            guard let completion = more ? completions[token] : completions.removeValue(forKey: token) else {
+                continue
+            }
+
+            if !more {
+                owners[token] = nil
+            }
+
+            completion(result, more)
+
+            if !more {
+                abandoned.remove(token)
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,216 @@
+#if os(Linux)
+
+import Glibc
+import Venice
+import Core
+import CLibdill
+import CURing
+
+/// TCP host accepting connections through io_uring.
+///
+/// A single multishot accept request stays armed for the lifetime of the
+/// host and queues connections as the kernel completes them. Kernels
+/// without multishot accept fall back to one request per connection.
+public final class URingHost : Host {
+    private typealias Handle = Int32
+    
+    private let handle: Handle
+    public let ip: IP
+    public let options: SocketOptions
+    public let bufferSize: Int
+    
+    private let ring: URing
+    private let channel: Channel<Void>
+    private var pending: [Handle] = []
+    private var pendingError: Error?
+    private var armed = false
+    private var waiting = false
+    private var multishot = true
+    
+    private init(handle: Handle, ip: IP, options: SocketOptions, bufferSize: Int) throws {
+        self.handle = handle
+        self.ip = ip
+        self.options = options
+        self.bufferSize = bufferSize
+        self.ring = try URing.shared()
+        self.channel = try Channel()
+    }
+    
+    deinit {
+        // The multishot accept would otherwise stay armed on a closed
+        // listener and complete into a host that is gone.
+        ring.cancelRequests(of: ObjectIdentifier(self))
+        
+        for socket in pending {
+            Glibc.close(socket)
+        }
+        
+        Glibc.close(handle)
+    }
+    
+    public convenience init(
+        ip: IP,
+        backlog: Int,
+        reusePort: Bool,
+        options: SocketOptions = .default,
+        bufferSize: Int = 16384
+    ) throws {
+        var address = ip.address
+        let socket = try Socket.create(family: Int32(ip.family))
+        
+        do {
+            try Socket.setOption(socket, level: SOL_SOCKET, name: SO_REUSEADDR, value: 1)
+            
+            if reusePort {
+                try Socket.setOption(socket, level: SOL_SOCKET, name: SO_REUSEPORT, value: 1)
+            }
+            
+            try options.applyToListener(socket)
+            try Socket.bind(socket, address: &address)
+            try Socket.listen(socket, backlog: backlog)
+            try Socket.setBlocking(socket, true)
+        } catch {
+            Glibc.close(socket)
+            throw error
+        }
+        
+        try self.init(handle: socket, ip: ip, options: options, bufferSize: bufferSize)
+    }
+    
+    public convenience init(
+        host: String = "",
+        port: Int = 8080,
+        backlog: Int = 128,
+        reusePort: Bool = false,
+        options: SocketOptions = .default,
+        bufferSize: Int = 16384
+    ) throws {
+        let ip: IP
+        
+        if host == "" {
+            ip = try IP(port: port)
+        } else {
+            ip = try IP(local: host, port: port)
+        }
+        
+        try self.init(
+            ip: ip,
+            backlog: backlog,
+            reusePort: reusePort,
+            options: options,
+            bufferSize: bufferSize
+        )
+    }
+    
+    public func accept(deadline: Deadline) throws -> DuplexStream {
+        while pending.isEmpty {
+            if let error = pendingError {
+                pendingError = nil
+                throw error
+            }
+            
+            try arm()
+            
+            // The completion may have landed while `arm` yielded.
+            guard pending.isEmpty && pendingError == nil else {
+                continue
+            }
+            
+            waiting = true
+            
+            defer {
+                waiting = false
+            }
+            
+            try channel.receive(deadline: deadline)
+        }
+        
+        return try stream(socket: pending.removeFirst())
+    }
+    
+    public func accept(upTo count: Int, deadline: Deadline) throws -> [DuplexStream] {
+        var streams: [DuplexStream] = [try accept(deadline: deadline)]
+        
+        while streams.count < count, !pending.isEmpty {
+            streams.append(try stream(socket: pending.removeFirst()))
+        }
+        
+        return streams
+    }
+    
+    private func arm() throws {
+        guard !armed else {
+            return
+        }
+        
+        let handle = self.handle
+        let multishot: Int32 = self.multishot ? 1 : 0
+        
+        // Weak, as the completion of the cancellation in `deinit` arrives
+        // while the host is being destroyed.
+        try ring.enqueue({ ring, token in
+            curing_prep_accept(ring, handle, multishot, token)
+        }, owner: ObjectIdentifier(self), completion: { [weak self] result, more in
+            guard let host = self else {
+                if result >= 0 {
+                    Glibc.close(result)
+                }
+                
+                return
+            }
+            
+            host.complete(result: result, more: more)
+        })
+        
+        armed = true
+        try ring.flush()
+    }
+    
+    private func complete(result: Int32, more: Bool) {
+        armed = more
+        
+        if result >= 0 {
+            pending.append(result)
+        } else if -result == EINVAL && multishot {
+            // Multishot accept is not supported by this kernel.
+            multishot = false
+        } else {
+            pendingError = SystemError(errorNumber: -result)
+        }
+        
+        if waiting {
+            waiting = false
+            try? channel.send((), deadline: .immediately)
+        }
+    }
+    
+    private func stream(socket: Handle) throws -> URingStream {
+        var address = ipaddr()
+        var length = socklen_t(MemoryLayout<ipaddr>.size)
+        
+        do {
+            try options.applyToStream(socket, includingBufferSizes: false)
+            
+            let result = withUnsafeMutableBytes(of: &address) { address in
+                getpeername(socket, address.baseAddress?.assumingMemoryBound(to: sockaddr.self), &length)
+            }
+            
+            guard result != -1 else {
+                throw SystemError.lastOperationError
+            }
+            
+            return try URingStream(
+                handle: socket,
+                ip: IP(address: &address),
+                options: options,
+                open: true,
+                bufferSize: bufferSize
+            )
+        } catch {
+            Glibc.close(socket)
+            throw error
+        }
+    }
+}
+
+#endif
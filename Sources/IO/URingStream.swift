@@ -0,0 +1,192 @@
+#if os(Linux)
+
+import Glibc
+import Venice
+import Core
+import CLibdill
+import CURing
+
+/// TCP stream driven by io_uring completions instead of readiness polling.
+///
+/// Requests go through buffers owned by the stream, so a request cancelled
+/// mid-flight (timeout, coroutine cancelation) never writes into memory the
+/// caller has already released.
+public final class URingStream : DuplexStream {
+    internal typealias Handle = Int32
+    
+    private var handle: Handle
+    public var ip: IP
+    public let options: SocketOptions
+    private var open: Bool
+    
+    private let ring: URing
+    private let readChannel: Channel<Int32>
+    private let writeChannel: Channel<Int32>
+    private let receiveBuffer: UnsafeMutableRawBufferPointer
+    private let sendBuffer: UnsafeMutableRawBufferPointer
+    
+    internal init(handle: Handle, ip: IP, options: SocketOptions, open: Bool, bufferSize: Int) throws {
+        self.handle = handle
+        self.ip = ip
+        self.options = options
+        self.open = open
+        self.ring = try URing.shared()
+        self.readChannel = try Channel()
+        self.writeChannel = try Channel()
+        
+        self.receiveBuffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: bufferSize,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        self.sendBuffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: bufferSize,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+    }
+    
+    public convenience init(ip: IP, options: SocketOptions = .default, bufferSize: Int = 16384) throws {
+        try self.init(handle: -1, ip: ip, options: options, open: false, bufferSize: bufferSize)
+    }
+    
+    public convenience init(
+        host: String,
+        port: Int,
+        options: SocketOptions = .default,
+        bufferSize: Int = 16384,
+        deadline: Deadline
+    ) throws {
+        let ip = try IP(remote: host, port: port, deadline: deadline)
+        try self.init(ip: ip, options: options, bufferSize: bufferSize)
+    }
+    
+    deinit {
+        // Requests whose cancellation failed may still be writing into
+        // the buffers, which are then leaked rather than released.
+        let released = ring.cancelRequests(of: ObjectIdentifier(self), waiting: true)
+        
+        if open {
+            Glibc.close(handle)
+        }
+        
+        if released {
+            receiveBuffer.deallocate()
+            sendBuffer.deallocate()
+        }
+    }
+    
+    public func open(deadline: Deadline) throws {
+        guard !open else {
+            throw SystemError.socketIsAlreadyConnected
+        }
+        
+        let socket = try Socket.create(family: Int32(ip.family))
+        
+        // The address must outlive the request, even if it gets cancelled.
+        let address = UnsafeMutablePointer<ipaddr>.allocate(capacity: 1)
+        address.initialize(to: ip.address)
+        
+        do {
+            try Socket.setBlocking(socket, true)
+            try options.applyToStream(socket, includingBufferSizes: true)
+            
+            _ = try ring.perform({ ring, token in
+                curing_prep_connect(
+                    ring,
+                    socket,
+                    ipaddr_sockaddr(address),
+                    socklen_t(ipaddr_len(address)),
+                    token
+                )
+            }, channel: writeChannel, owner: ObjectIdentifier(self), deadline: deadline)
+        } catch {
+            // A connect that could not be canceled may still read it.
+            if ring.cancelRequests(of: ObjectIdentifier(self), waiting: true) {
+                address.deallocate()
+            }
+            
+            Glibc.close(socket)
+            throw error
+        }
+        
+        address.deallocate()
+        self.handle = socket
+        self.open = true
+    }
+    
+    public func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        try assertOpen()
+        
+        guard let destination = buffer.baseAddress, !buffer.isEmpty else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+        
+        let handle = self.handle
+        let source = receiveBuffer.baseAddress
+        let count = min(buffer.count, receiveBuffer.count)
+        
+        let result = try ring.perform({ ring, token in
+            curing_prep_recv(ring, handle, source, count, token)
+        }, channel: readChannel, owner: ObjectIdentifier(self), deadline: deadline)
+        
+        memcpy(destination, source, Int(result))
+        return UnsafeRawBufferPointer(start: destination, count: Int(result))
+    }
+    
+    public func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        try assertOpen()
+        
+        guard var pointer = buffer.baseAddress else {
+            return
+        }
+        
+        let handle = self.handle
+        var remaining = buffer.count
+        
+        while remaining > 0 {
+            let count = min(remaining, sendBuffer.count)
+            memcpy(sendBuffer.baseAddress, pointer, count)
+            
+            var sent = 0
+            
+            while sent < count {
+                let source = sendBuffer.baseAddress! + sent
+                let length = count - sent
+                
+                let result = try ring.perform({ ring, token in
+                    curing_prep_send(ring, handle, source, length, Int32(MSG_NOSIGNAL), token)
+                }, channel: writeChannel, owner: ObjectIdentifier(self), deadline: deadline)
+                
+                sent += Int(result)
+            }
+            
+            pointer += count
+            remaining -= count
+        }
+    }
+    
+    public func close(deadline: Deadline) throws {
+        try assertOpen()
+        
+        defer {
+            open = false
+        }
+        
+        let handle = self.handle
+        
+        _ = try ring.perform({ ring, token in
+            curing_prep_close(ring, handle, token)
+        }, channel: writeChannel, owner: ObjectIdentifier(self), deadline: deadline)
+    }
+    
+    private func assertOpen() throws {
+        guard open else {
+            throw SystemError.socketIsNotConnected
+        }
+    }
+}
+
+#endif
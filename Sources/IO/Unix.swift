@@ -0,0 +1,86 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Core
+
+public enum UnixError : Error {
+    case pathTooLong
+}
+
+extension UnixError : CustomStringConvertible {
+    public var description: String {
+        switch self {
+        case .pathTooLong:
+            return "Unix domain socket path is longer than the platform limit."
+        }
+    }
+}
+
+/// Unix domain socket address.
+///
+/// On Linux a path starting with `@` names a socket in the abstract
+/// namespace, which never touches the file system.
+internal struct UnixAddress {
+    internal let path: String
+    private var storage = sockaddr_un()
+    private var length: socklen_t = 0
+    
+    internal init(path: String) throws {
+        self.path = path
+        
+        var bytes = Array(path.utf8)
+        
+        #if os(Linux)
+            if bytes.first == UInt8(ascii: "@") {
+                bytes[0] = 0
+            }
+        #endif
+        
+        let capacity = MemoryLayout.size(ofValue: storage.sun_path)
+        
+        guard bytes.count < capacity else {
+            throw UnixError.pathTooLong
+        }
+        
+        storage.sun_family = sa_family_t(AF_UNIX)
+        
+        withUnsafeMutableBytes(of: &storage.sun_path) { pathBuffer in
+            pathBuffer.copyBytes(from: bytes)
+        }
+        
+        let pathOffset = MemoryLayout<sockaddr_un>.offset(of: \sockaddr_un.sun_path) ?? 2
+        
+        if isAbstract {
+            length = socklen_t(pathOffset + bytes.count)
+        } else {
+            length = socklen_t(pathOffset + bytes.count + 1)
+        }
+        
+        #if !os(Linux)
+            storage.sun_len = UInt8(length)
+        #endif
+    }
+    
+    internal var isAbstract: Bool {
+        #if os(Linux)
+            return path.hasPrefix("@")
+        #else
+            return false
+        #endif
+    }
+    
+    internal func withSocketAddress<R>(
+        _ body: (UnsafePointer<sockaddr>, socklen_t) throws -> R
+    ) rethrows -> R {
+        var storage = self.storage
+        
+        return try withUnsafePointer(to: &storage) { pointer in
+            try pointer.withMemoryRebound(to: sockaddr.self, capacity: 1) { address in
+                try body(address, length)
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+
+public final class UnixHost : Host {
+    private typealias Handle = Int32
+    
+    /// Device and inode of a file, and whether it is a socket.
+    private struct FileIdentity : Equatable {
+        let device: dev_t
+        let inode: ino_t
+        let isSocket: Bool
+    }
+    
+    private let handle: Handle
+    private let bound: FileIdentity?
+    public let path: String
+    
+    private init(handle: Handle, path: String, bound: FileIdentity?) {
+        self.handle = handle
+        self.path = path
+        self.bound = bound
+    }
+    
+    deinit {
+        try? Socket.close(handle)
+        
+        // A successor may already have bound a socket of its own there.
+        if let bound = bound, UnixHost.identity(of: path) == bound {
+            unlink(path)
+        }
+    }
+    
+    /// Creates a host listening on the Unix domain socket at `path`.
+    ///
+    /// A stale socket file left at `path` by a previous process is removed
+    /// unless `removeExisting` is `false`. Anything else at `path` is left
+    /// alone and `SystemError.addressAlreadyInUse` thrown. Paths starting
+    /// with `@` are bound in the Linux abstract namespace.
+    public convenience init(
+        path: String,
+        backlog: Int = 128,
+        removeExisting: Bool = true
+    ) throws {
+        let address = try UnixAddress(path: path)
+        
+        if removeExisting && !address.isAbstract, let existing = UnixHost.identity(of: path) {
+            guard existing.isSocket else {
+                throw SystemError.addressAlreadyInUse
+            }
+            
+            unlink(path)
+        }
+        
+        let socket = try Socket.create(family: AF_UNIX)
+        
+        do {
+            try address.withSocketAddress { address, length in
+                try Socket.bind(socket, address: address, length: length)
+            }
+            
+            try Socket.listen(socket, backlog: backlog)
+        } catch {
+            try? Socket.close(socket)
+            throw error
+        }
+        
+        let bound = address.isAbstract ? nil : UnixHost.identity(of: path)
+        self.init(handle: socket, path: path, bound: bound)
+    }
+    
+    private static func identity(of path: String) -> FileIdentity? {
+        var info = stat()
+        
+        guard lstat(path, &info) != -1 else {
+            return nil
+        }
+        
+        return FileIdentity(
+            device: info.st_dev,
+            inode: info.st_ino,
+            isSocket: (info.st_mode & S_IFMT) == S_IFSOCK
+        )
+    }
+    
+    public func accept(deadline: Deadline) throws -> DuplexStream {
+        let socket = try Socket.accept(handle, address: nil, length: 0, deadline: deadline)
+        return UnixStream(handle: socket, path: path, open: true)
+    }
+    
+    public func accept(upTo count: Int, deadline: Deadline) throws -> [DuplexStream] {
+        var streams: [DuplexStream] = [try accept(deadline: deadline)]
+        streams.reserveCapacity(count)
+        
+        while streams.count < count {
+            // Errors resurface on the next call, hand out what we already have.
+            guard let socket = try? Socket.acceptPending(handle, address: nil, length: 0) else {
+                break
+            }
+            
+            streams.append(UnixStream(handle: socket, path: path, open: true))
+        }
+        
+        return streams
+    }
+}
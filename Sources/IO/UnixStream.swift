@@ -0,0 +1,91 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import Venice
+import Core
+
+public final class UnixStream : DuplexStream {
+    internal typealias Handle = Int32
+    
+    internal private(set) var handle: Handle
+    public let path: String
+    private var open: Bool
+    
+    internal init(handle: Handle, path: String, open: Bool) {
+        self.handle = handle
+        self.path = path
+        self.open = open
+    }
+    
+    /// Creates a stream to the Unix domain socket at `path`.
+    ///
+    /// Paths starting with `@` refer to the Linux abstract namespace.
+    public convenience init(path: String) {
+        self.init(handle: -1, path: path, open: false)
+    }
+    
+    deinit {
+        if open {
+            try? Socket.close(handle)
+        }
+    }
+    
+    public func open(deadline: Deadline) throws {
+        guard !open else {
+            throw SystemError.socketIsAlreadyConnected
+        }
+        
+        let address = try UnixAddress(path: path)
+        let socket = try Socket.create(family: AF_UNIX)
+        
+        do {
+            try address.withSocketAddress { address, length in
+                try Socket.connect(socket, address: address, length: length, deadline: deadline)
+            }
+        } catch {
+            try? Socket.close(socket)
+            throw error
+        }
+        
+        self.handle = socket
+        self.open = true
+    }
+    
+    public func read(
+        _ buffer: UnsafeMutableRawBufferPointer,
+        deadline: Deadline
+    ) throws -> UnsafeRawBufferPointer {
+        try assertOpen()
+        let result = try Socket.receive(handle, buffer, deadline: deadline)
+        
+        #if swift(>=3.2)
+            return UnsafeRawBufferPointer(rebasing: buffer.prefix(upTo: result))
+        #else
+            return UnsafeRawBufferPointer(buffer.prefix(upTo: result))
+        #endif
+    }
+    
+    public func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        try assertOpen()
+        try Socket.send(handle, buffer, deadline: deadline)
+    }
+    
+    public func close(deadline: Deadline) throws {
+        try assertOpen()
+        
+        defer {
+            open = false
+        }
+        
+        try Socket.close(handle)
+    }
+    
+    internal func assertOpen() throws {
+        guard open else {
+            throw SystemError.socketIsNotConnected
+        }
+    }
+}
@@ -3,7 +3,7 @@ import Venice
 
 extension JSON : DecodingMedia {
     public init(from readable: Readable, deadline: Deadline) throws {
-        let parser = JSONParser()
+        let parser = JSONParser(account: (readable as? AccountedReadable)?.account)
         
         let buffer = UnsafeMutableRawBufferPointer.allocate(
             byteCount: 4096,
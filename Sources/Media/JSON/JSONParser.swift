@@ -4,6 +4,7 @@
     import Darwin.C
 #endif
 
+import Core
 import CYAJL
 
 public struct JSONParserError : Error, CustomStringConvertible {
@@ -32,6 +33,10 @@ final class JSONParser {
     
     let options: Options
     
+    /// Charged for the values built, estimated from their size.
+    let account: MemoryAccount?
+    fileprivate var accountError: Error?
+    
     fileprivate var state: JSONParserState = JSONParserState(dictionary: true)
     fileprivate var stack: [JSONParserState] = []
     
@@ -46,8 +51,9 @@ final class JSONParser {
         self.init(options: [])
     }
     
-    init(options: Options = []) {
+    init(options: Options = [], account: MemoryAccount? = nil) {
         self.options = options
+        self.account = account
         self.state.dictionaryKey = "root"
         self.stack.reserveCapacity(12)
         
@@ -93,6 +99,10 @@ final class JSONParser {
         }
         
         guard status == yajl_status_ok else {
+            if let error = accountError {
+                throw error
+            }
+            
             let reasonBytes = yajl_get_error(
                 handle,
                 1,
@@ -137,27 +147,47 @@ final class JSONParser {
         return result
     }
     
+    /// Returns `0`, which stops the parse, if the account is over budget.
+    fileprivate func charge(_ bytes: Int) -> Int32 {
+        guard let account = account else {
+            return 1
+        }
+        
+        do {
+            try account.charge(bytes)
+            return 1
+        } catch {
+            accountError = error
+            return 0
+        }
+    }
+    
     fileprivate func appendNull() -> Int32 {
-        return state.appendNull()
+        return charge(MemoryLayout<JSON>.stride) & state.appendNull()
     }
     
     fileprivate func appendBoolean(_ value: Bool) -> Int32 {
-        return state.append(value)
+        return charge(MemoryLayout<JSON>.stride) & state.append(value)
     }
     
     fileprivate func appendInteger(_ value: Int64) -> Int32 {
-        return state.append(value)
+        return charge(MemoryLayout<JSON>.stride) & state.append(value)
     }
     
     fileprivate func appendDouble(_ value: Double) -> Int32 {
-        return state.append(value)
+        return charge(MemoryLayout<JSON>.stride) & state.append(value)
     }
     
     fileprivate func appendString(_ value: String) -> Int32 {
-        return state.append(value)
+        return charge(MemoryLayout<JSON>.stride + value.utf8.count) & state.append(value)
     }
     
     fileprivate func startMap() -> Int32 {
+        // Containers reserve room for 32 values up front.
+        guard charge(32 * MemoryLayout<JSON>.stride) != 0 else {
+            return 0
+        }
+        
         stack.append(state)
         state = JSONParserState(dictionary: true)
         return 1
@@ -165,7 +195,7 @@ final class JSONParser {
     
     fileprivate func mapKey(_ key: String) -> Int32 {
         state.dictionaryKey = key
-        return 1
+        return charge(key.utf8.count)
     }
     
     fileprivate func endMap() -> Int32 {
@@ -180,6 +210,10 @@ final class JSONParser {
     }
     
     fileprivate func startArray() -> Int32 {
+        guard charge(32 * MemoryLayout<JSON>.stride) != 0 else {
+            return 0
+        }
+        
         stack.append(state)
         state = JSONParserState(dictionary: false)
         return 1
@@ -0,0 +1,42 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import XCTest
+@testable import Core
+
+public class AsyncLogAppenderTests : XCTestCase {
+    func testAppend() {
+        var descriptors: [Int32] = [0, 0]
+        XCTAssertEqual(pipe(&descriptors), 0)
+
+        defer {
+            close(descriptors[0])
+            close(descriptors[1])
+        }
+
+        let appender = AsyncLogAppender(descriptor: descriptors[1], metrics: nil)
+        let location = Logger.LocationInfo(file: "main.swift", line: 1, column: 2, function: "main()")
+
+        appender.append(event: Logger.Event(locationInfo: location, timestamp: 10, usec: 0, level: .info, message: "Started.", error: nil))
+        appender.append(event: Logger.Event(locationInfo: location, timestamp: 11, usec: 0, level: .error, message: 42, error: nil))
+        appender.close()
+
+        var bytes = [UInt8](repeating: 0, count: 1024)
+        let count = read(descriptors[0], &bytes, bytes.count)
+
+        XCTAssertEqual(
+            String(decoding: bytes.prefix(max(count, 0)), as: UTF8.self),
+            "[INFO][10][main.swift:main():1:2]:Started.\n[ERROR][11][main.swift:main():1:2]:42\n"
+        )
+
+        appender.append(event: Logger.Event(locationInfo: location, timestamp: 12, usec: 0, level: .info, message: nil, error: nil))
+        XCTAssertEqual(appender.droppedEvents, 1)
+    }
+
+    public static var allTests = [
+        ("testAppend", testAppend),
+    ]
+}
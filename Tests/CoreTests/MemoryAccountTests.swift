@@ -0,0 +1,41 @@
+import XCTest
+@testable import Core
+
+public class MemoryAccountTests : XCTestCase {
+    func testCharge() throws {
+        let connection = MemoryAccount(budget: 100)
+        let request = MemoryAccount(budget: 50, parent: connection)
+
+        try request.charge(40)
+        XCTAssertEqual(connection.current, 40)
+
+        XCTAssertThrowsError(try request.charge(20))
+        XCTAssertTrue(request.exceeded)
+        XCTAssertFalse(connection.exceeded)
+        XCTAssertEqual(connection.current, 60)
+
+        request.release(20)
+        XCTAssertEqual(request.current, 40)
+        XCTAssertEqual(request.peak, 60)
+        XCTAssertEqual(connection.current, 40)
+    }
+
+    func testReleaseAll() throws {
+        let connection = MemoryAccount()
+        let request = MemoryAccount(parent: connection)
+
+        try request.charge(30)
+        connection.releaseAll()
+        XCTAssertEqual(connection.current, 0)
+
+        // Stops at the closed connection, which already gave it back.
+        request.release(30)
+        XCTAssertEqual(request.current, 0)
+        XCTAssertEqual(connection.current, 0)
+    }
+
+    public static var allTests = [
+        ("testCharge", testCharge),
+        ("testReleaseAll", testReleaseAll),
+    ]
+}
@@ -0,0 +1,53 @@
+import XCTest
+@testable import Core
+
+public class MetricsTests : XCTestCase {
+    func testHistogramBuckets() {
+        var previous = -1
+
+        for index in 0 ..< Histogram.bucketCount {
+            let range = Histogram.range(of: index)
+            XCTAssertEqual(range.lowerBound, previous + 1)
+            XCTAssertEqual(Histogram.index(of: range.lowerBound), index)
+            XCTAssertEqual(Histogram.index(of: range.upperBound), index)
+            previous = range.upperBound
+        }
+
+        XCTAssertEqual(previous, Histogram.maximumValue)
+    }
+
+    func testExposition() {
+        let registry = MetricsRegistry()
+        let counter = registry.counter("requests_total", help: "Requests.", labels: ["class": "2xx"])
+        let gauge = registry.gauge("connections")
+        let histogram = registry.histogram("latency_seconds", buckets: [0.000002, 0.001])
+
+        counter.increment()
+        registry.counter("requests_total", labels: ["class": "2xx"]).increment(by: 2)
+        gauge.increment(by: 3)
+        gauge.decrement()
+
+        for value in 1 ... 100 {
+            histogram.record(value * 10)
+        }
+
+        XCTAssertEqual(counter.value, 3)
+        XCTAssertEqual(gauge.value, 2)
+        XCTAssertEqual(histogram.snapshot.count, 100)
+        XCTAssertEqual(histogram.snapshot.sum, 50500)
+        XCTAssertEqual(histogram.snapshot.value(atPercentile: 50), 503)
+
+        let exposition = registry.prometheusExposition()
+        XCTAssert(exposition.contains("# HELP requests_total Requests.\n# TYPE requests_total counter\n"))
+        XCTAssert(exposition.contains("requests_total{class=\"2xx\"} 3\n"))
+        XCTAssert(exposition.contains("connections 2\n"))
+        XCTAssert(exposition.contains("latency_seconds_bucket{le=\"2e-06\"} 100\n"))
+        XCTAssert(exposition.contains("latency_seconds_bucket{le=\"+Inf\"} 100\n"))
+        XCTAssert(exposition.contains("latency_seconds_count 100\n"))
+    }
+
+    public static var allTests = [
+        ("testHistogramBuckets", testHistogramBuckets),
+        ("testExposition", testExposition),
+    ]
+}
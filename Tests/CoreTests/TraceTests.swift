@@ -0,0 +1,42 @@
+import XCTest
+@testable import Core
+
+public class TraceTests : XCTestCase {
+    func testTraceparent() {
+        let header = "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"
+        let context = TraceContext(traceparent: header)
+        XCTAssertEqual(context?.traceIDString, "4bf92f3577b34da6a3ce929d0e0e4736")
+        XCTAssertEqual(context?.spanID, 0x00f067aa0ba902b7)
+        XCTAssertEqual(context?.sampled, true)
+        XCTAssertEqual(context?.traceparent, header)
+
+        XCTAssertNil(TraceContext(traceparent: "00-00000000000000000000000000000000-00f067aa0ba902b7-01"))
+        XCTAssertNil(TraceContext(traceparent: "ff-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01"))
+        XCTAssertNil(TraceContext(traceparent: "00-4bf92f3577b34da6a3ce929d0e0e4736-01"))
+    }
+
+    func testRecorder() {
+        let recorder = TraceRecorder(sampleRate: 0, slowThreshold: 100, capacity: 2)
+        let parent = TraceContext(traceID: (1, 2), spanID: 3, sampled: false)
+
+        for duration in [50, 100, 200, 300] {
+            guard let trace = recorder.begin(name: "GET /", parent: parent) else {
+                return XCTFail()
+            }
+
+            XCTAssertEqual(trace.context.traceID.low, 2)
+            XCTAssertEqual(trace.parentSpanID, 3)
+            trace.record(.respond, from: 1000, to: 1000 + duration)
+            recorder.finish(trace)
+        }
+
+        XCTAssertEqual(recorder.traces.map({ $0.end - $0.start }), [200, 300])
+        XCTAssert(recorder.export(.chromeTrace).contains("\"name\":\"respond\""))
+        XCTAssert(recorder.export(.openTelemetry(serviceName: "test")).contains("\"parentSpanId\":\"0000000000000003\""))
+    }
+
+    public static var allTests = [
+        ("testTraceparent", testTraceparent),
+        ("testRecorder", testRecorder),
+    ]
+}
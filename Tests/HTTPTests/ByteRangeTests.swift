@@ -0,0 +1,101 @@
+import XCTest
+import Core
+import HTTP
+
+public class ByteRangeTests: XCTestCase {
+    func testParsing() throws {
+        let ranges = ByteRange.ranges(from: "bytes=0-99, 200-, -50")
+        XCTAssertEqual(ranges?.count, 3)
+        XCTAssertEqual(ranges?[0].resolved(length: 1000), 0 ..< 100)
+        XCTAssertEqual(ranges?[1].resolved(length: 1000), 200 ..< 1000)
+        XCTAssertEqual(ranges?[2].resolved(length: 1000), 950 ..< 1000)
+        XCTAssertEqual(ranges?[0].resolved(length: 10), 0 ..< 10)
+        XCTAssertNil(ranges?[1].resolved(length: 100))
+        XCTAssertEqual(ByteRange.bounded(first: 5, last: Int.max).resolved(length: 10), 5 ..< 10)
+        
+        XCTAssertNil(ByteRange.ranges(from: "items=0-1"))
+        XCTAssertNil(ByteRange.ranges(from: "bytes=5-1"))
+        XCTAssertNil(ByteRange.ranges(from: "bytes=a-b"))
+        XCTAssertNil(ByteRange.ranges(from: "bytes="))
+    }
+    
+    func testResponses() throws {
+        let bytes = Array("0123456789".utf8)
+        
+        try bytes.withUnsafeBytes { buffer in
+            let headers: Headers = ["Content-Type": "text/plain", "ETag": "\"v1\""]
+            
+            func respond(_ requestHeaders: Headers) throws -> Response {
+                let request = try Request(method: .get, uri: "/", headers: requestHeaders)
+                return Response(request: request, source: ReadableBuffer(buffer), headers: headers)
+            }
+            
+            let full = try respond([:])
+            XCTAssertEqual(full.status.statusCode, 200)
+            XCTAssertEqual(full.contentLength, 10)
+            XCTAssertEqual(full.headers["Accept-Ranges"], "bytes")
+            XCTAssertEqual(try read(full), "0123456789")
+            
+            let single = try respond(["Range": "bytes=2-4"])
+            XCTAssertEqual(single.status.statusCode, 206)
+            XCTAssertEqual(single.headers["Content-Range"], "bytes 2-4/10")
+            XCTAssertEqual(single.contentLength, 3)
+            XCTAssertEqual(try read(single), "234")
+            
+            let multiple = try respond(["Range": "bytes=0-1,-2"])
+            XCTAssertEqual(multiple.status.statusCode, 206)
+            
+            guard let contentType = multiple.headers["Content-Type"], contentType.hasPrefix("multipart/byteranges; boundary=") else {
+                return XCTFail("Missing multipart content type")
+            }
+            
+            let boundary = String(contentType.dropFirst("multipart/byteranges; boundary=".count))
+            let body = try read(multiple)
+            XCTAssertEqual(multiple.contentLength, body.utf8.count)
+            
+            XCTAssertEqual(
+                body,
+                "\r\n--\(boundary)\r\nContent-Type: text/plain\r\nContent-Range: bytes 0-1/10\r\n\r\n01" +
+                "\r\n--\(boundary)\r\nContent-Type: text/plain\r\nContent-Range: bytes 8-9/10\r\n\r\n89" +
+                "\r\n--\(boundary)--\r\n"
+            )
+            
+            let coalesced = try respond(["Range": "bytes=0-3,2-5"])
+            XCTAssertEqual(coalesced.headers["Content-Range"], "bytes 0-5/10")
+            
+            let unsatisfiable = try respond(["Range": "bytes=20-"])
+            XCTAssertEqual(unsatisfiable.status.statusCode, 416)
+            XCTAssertEqual(unsatisfiable.headers["Content-Range"], "bytes */10")
+            
+            let matching = try respond(["Range": "bytes=2-4", "If-Range": "\"v1\""])
+            XCTAssertEqual(matching.status.statusCode, 206)
+            
+            let stale = try respond(["Range": "bytes=2-4", "If-Range": "\"v0\""])
+            XCTAssertEqual(stale.status.statusCode, 200)
+        }
+    }
+    
+    private func read(_ response: Response) throws -> String {
+        let readable = try response.body.convertedToReadable()
+        
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 1024,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        return String(try readable.read(buffer, deadline: .never))
+    }
+}
+
+extension ByteRangeTests {
+    public static var allTests: [(String, (ByteRangeTests) -> () throws -> Void)] {
+        return [
+            ("testParsing", testParsing),
+            ("testResponses", testResponses),
+        ]
+    }
+}
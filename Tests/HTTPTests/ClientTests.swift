@@ -1,6 +1,9 @@
 import XCTest
 import Media
 import HTTP
+import Core
+import IO
+import Venice
 
 struct Todo : MediaCodable {
     let id: Int
@@ -21,12 +24,138 @@ public class ClientTests : XCTestCase {
         XCTAssertEqual(todo.title, "delectus aut autem")
         XCTAssertEqual(todo.completed, false)
     }
+    
+    func testCancellation() throws {
+        let cancellation = Cancellation()
+        
+        let canceler = try Coroutine {
+            try Coroutine.wakeUp(100.milliseconds.fromNow())
+            cancellation.cancel()
+        }
+        
+        XCTAssertThrowsError(try cancellation.run { try Coroutine.wakeUp(10.seconds.fromNow()) }) { error in
+            XCTAssertEqual("\(error)", "The operation was cancelled.")
+        }
+        
+        XCTAssertThrowsError(try cancellation.check())
+        canceler.cancel()
+    }
+    
+    func testContinueTimeout() throws {
+        let deadline = 5.seconds.fromNow()
+        let host = try TCPHost(port: 8089)
+        var body = ""
+        
+        // A server that predates `Expect` never answers it.
+        let server = try Coroutine {
+            do {
+                let stream = try host.accept(deadline: deadline)
+                XCTAssert(try ClientTests.readHead(from: stream, deadline: deadline).contains("Expect: 100-continue\r\n"))
+                body = try ClientTests.readText(from: stream, count: 5, deadline: deadline)
+                try stream.write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        defer {
+            server.cancel()
+        }
+        
+        var configuration = Client.Configuration()
+        configuration.expectContinueThreshold = 1
+        configuration.expectContinueTimeout = 100.milliseconds
+        
+        let client = try Client(uri: "http://127.0.0.1:8089", configuration: configuration)
+        let response = try client.send(try Request(method: .post, uri: "/", body: "Hello"))
+        
+        XCTAssertEqual(response.status, .ok)
+        XCTAssertEqual(body, "Hello")
+    }
+    
+    func testRejectedUpload() throws {
+        let deadline = 5.seconds.fromNow()
+        let host = try TCPHost(port: 8096)
+        var connections = 0
+        
+        let server = try Coroutine {
+            do {
+                // The upload is refused before its body is sent, so the
+                // connection is left in an unknown state.
+                let first = try host.accept(deadline: deadline)
+                connections += 1
+                _ = try ClientTests.readHead(from: first, deadline: deadline)
+                try first.write("HTTP/1.1 413 Request Entity Too Large\r\nContent-Length: 0\r\n\r\n", deadline: deadline)
+                
+                let second = try host.accept(deadline: deadline)
+                connections += 1
+                XCTAssert(try ClientTests.readHead(from: second, deadline: deadline).hasPrefix("GET /next "))
+                try second.write("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        defer {
+            server.cancel()
+        }
+        
+        var configuration = Client.Configuration()
+        configuration.expectContinueThreshold = 1
+        configuration.parseTimeout = 1.second
+        
+        let client = try Client(uri: "http://127.0.0.1:8096", configuration: configuration)
+        let rejected = try client.send(try Request(method: .post, uri: "/upload", body: "Hello"))
+        XCTAssertEqual(rejected.status, .requestEntityTooLarge)
+        
+        let next = try client.send(try Request(method: .get, uri: "/next"))
+        XCTAssertEqual(next.status, .ok)
+        XCTAssertEqual(connections, 2)
+    }
+    
+    private static func readHead(from stream: TCPStream, deadline: Deadline) throws -> String {
+        var head = ""
+        
+        while !head.hasSuffix("\r\n\r\n") {
+            head += try readText(from: stream, count: 1, deadline: deadline)
+        }
+        
+        return head
+    }
+    
+    private static func readText(from stream: TCPStream, count: Int, deadline: Deadline) throws -> String {
+        let buffer = UnsafeMutableRawBufferPointer.allocate(byteCount: count, alignment: 1)
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        var bytes: [UInt8] = []
+        
+        while bytes.count < count {
+            let read = try stream.read(
+                UnsafeMutableRawBufferPointer(rebasing: buffer[bytes.count...]),
+                deadline: deadline
+            )
+            
+            guard !read.isEmpty else {
+                throw SystemError.connectionResetByPeer
+            }
+            
+            bytes.append(contentsOf: read)
+        }
+        
+        return String(decoding: bytes, as: UTF8.self)
+    }
 }
 
 extension ClientTests {
     public static var allTests: [(String, (ClientTests) -> () throws -> Void)] {
         return [
             ("testClient", testClient),
+            ("testCancellation", testCancellation),
+            ("testContinueTimeout", testContinueTimeout),
+            ("testRejectedUpload", testRejectedUpload),
         ]
     }
 }
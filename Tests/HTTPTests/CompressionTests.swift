@@ -0,0 +1,186 @@
+import XCTest
+import Core
+import IO
+@testable import HTTP
+
+public class CompressionTests: XCTestCase {
+    func testRoundTrip() throws {
+        let text = String(repeating: "{\"id\": 1, \"name\": \"Zewo\"}, ", count: 1000)
+        
+        for gzip in [true, false] {
+            let deflater = try Deflater(gzip: gzip, level: 6)
+            
+            // The second pass reuses the reset stream.
+            for _ in 0 ..< 2 {
+                let compressed = WritableBuffer()
+                let writer = try deflater.writer(to: compressed)
+                try writer.write(text, deadline: .never)
+                try writer.finish(deadline: .never)
+                XCTAssertLessThan(compressed.buffer.count, text.utf8.count / 10)
+                
+                if gzip {
+                    XCTAssertEqual(Array(compressed.buffer.prefix(2)), [0x1f, 0x8b])
+                }
+                
+                XCTAssertEqual(try inflate(compressed.buffer, maximumRatio: 100), text)
+            }
+        }
+    }
+    
+    func testRatioLimit() throws {
+        let zeros = [UInt8](repeating: 0, count: 1024 * 1024)
+        let compressed = WritableBuffer()
+        let writer = try Deflater(gzip: true, level: 9).writer(to: compressed)
+        
+        try zeros.withUnsafeBytes {
+            try writer.write($0, deadline: .never)
+        }
+        
+        try writer.finish(deadline: .never)
+        
+        XCTAssertThrowsError(try inflate(compressed.buffer, maximumRatio: 10)) { error in
+            guard case CompressionError.ratioExceeded = error else {
+                return XCTFail("\(error)")
+            }
+        }
+    }
+    
+    func testTruncatedStream() throws {
+        let compressed = WritableBuffer()
+        let writer = try Deflater(gzip: true, level: 6).writer(to: compressed)
+        try writer.write("Hello, truncated world!", deadline: .never)
+        try writer.finish(deadline: .never)
+        
+        XCTAssertThrowsError(try inflate(Array(compressed.buffer.dropLast(4)), maximumRatio: 100))
+    }
+    
+    func testBodilessResponses() throws {
+        XCTAssertEqual(try inflate([], maximumRatio: 100), "")
+        
+        let empty = ReadableBuffer(UnsafeRawBufferPointer(start: nil, count: 0))
+        let response = Response(status: .ok, headers: ["Content-Encoding": "gzip"], body: empty)
+        response.contentLength = 120
+        
+        try response.inflateBody(answering: try Request(method: .head, uri: "/"), maximumRatio: 100)
+        XCTAssertEqual(response.headers["Content-Encoding"], "gzip")
+        XCTAssertEqual(response.contentLength, 120)
+        
+        try response.inflateBody(answering: try Request(method: .get, uri: "/"), maximumRatio: 100)
+        XCTAssertNil(response.headers["Content-Encoding"])
+        XCTAssertNil(response.contentLength)
+    }
+    
+    func testNegotiation() throws {
+        let body = String(repeating: "a", count: 2048)
+        let compressor = ResponseCompressor(compression: Compression(), timeout: 1.minute)
+        
+        let request = try Request(method: .get, uri: "/", headers: ["Accept-Encoding": "deflate;q=0.5, gzip"])
+        let response = Response(status: .ok, headers: ["Content-Type": "application/json", "ETag": "\"v1\""], body: body)
+        compressor.compress(response, for: request)
+        XCTAssertEqual(response.headers["Content-Encoding"], "gzip")
+        XCTAssertEqual(response.headers["Vary"], "Accept-Encoding")
+        XCTAssertEqual(response.headers["ETag"], "W/\"v1\"")
+        XCTAssertNil(response.contentLength)
+        XCTAssertTrue(response.isChunkEncoded)
+        
+        let compressed = WritableBuffer()
+        try response.body.writable?(compressed)
+        XCTAssertEqual(Array(compressed.buffer.prefix(2)), [0x1f, 0x8b])
+        XCTAssertEqual(try inflate(compressed.buffer, maximumRatio: 100), body)
+        
+        let deflateFirst = try Request(method: .get, uri: "/", headers: ["Accept-Encoding": "gzip;q=0.5, deflate"])
+        let deflated = Response(status: .ok, headers: ["Content-Type": "text/plain"], body: body)
+        compressor.compress(deflated, for: deflateFirst)
+        XCTAssertEqual(deflated.headers["Content-Encoding"], "deflate")
+        
+        let small = Response(status: .ok, headers: ["Content-Type": "application/json"], body: "{}")
+        compressor.compress(small, for: request)
+        XCTAssertNil(small.headers["Content-Encoding"])
+        
+        let image = Response(status: .ok, headers: ["Content-Type": "image/png"], body: body)
+        compressor.compress(image, for: request)
+        XCTAssertNil(image.headers["Content-Encoding"])
+        
+        let identity = try Request(method: .get, uri: "/", headers: ["Accept-Encoding": "identity"])
+        let plain = Response(status: .ok, headers: ["Content-Type": "text/plain"], body: body)
+        compressor.compress(plain, for: identity)
+        XCTAssertNil(plain.headers["Content-Encoding"])
+    }
+    
+    func testSkipRules() throws {
+        let compressor = ResponseCompressor(compression: Compression(minimumSize: 1), timeout: 1.minute)
+        let request = try Request(method: .get, uri: "/", headers: ["Accept-Encoding": "gzip"])
+        
+        func isCompressed(_ response: Response, for request: Request, by compressor: ResponseCompressor) -> Bool {
+            compressor.compress(response, for: request)
+            return response.headers["Content-Encoding"] != nil
+        }
+        
+        func json(_ headers: Headers = [:], size: Int = 2048) -> Response {
+            var headers = headers
+            headers["Content-Type"] = "application/json"
+            return Response(status: .ok, headers: headers, body: String(repeating: "a", count: size))
+        }
+        
+        XCTAssertTrue(isCompressed(json(), for: request, by: compressor))
+        
+        let head = try Request(method: .head, uri: "/", headers: ["Accept-Encoding": "gzip"])
+        XCTAssertFalse(isCompressed(json(), for: head, by: compressor))
+        
+        // HTTP/1.0 clients cannot receive chunked bodies.
+        let legacy = try Request(method: .get, uri: "/", headers: ["Accept-Encoding": "gzip"])
+        legacy.version = .oneDotZero
+        XCTAssertFalse(isCompressed(json(), for: legacy, by: compressor))
+        
+        XCTAssertFalse(isCompressed(json(["Content-Range": "bytes 0-2047/4096"]), for: request, by: compressor))
+        XCTAssertFalse(isCompressed(json(["Cache-Control": "public, no-transform"]), for: request, by: compressor))
+        
+        let file = Response(status: .ok, headers: ["Content-Type": "text/plain"], file: try File(path: #file))
+        XCTAssertFalse(isCompressed(file, for: request, by: compressor))
+        
+        let large = ResponseCompressor(compression: Compression(minimumSize: 4096), timeout: 1.minute)
+        XCTAssertFalse(isCompressed(json(size: 4095), for: request, by: large))
+        XCTAssertTrue(isCompressed(json(size: 4096), for: request, by: large))
+    }
+    
+    private func inflate(_ bytes: [UInt8], maximumRatio: Int) throws -> String {
+        return try bytes.withUnsafeBytes { bytes in
+            let readable = try InflatingReadable(ReadableBuffer(bytes), maximumRatio: maximumRatio)
+            var inflated: [UInt8] = []
+            
+            let buffer = UnsafeMutableRawBufferPointer.allocate(
+                byteCount: 4096,
+                alignment: MemoryLayout<UInt8>.alignment
+            )
+            
+            defer {
+                buffer.deallocate()
+            }
+            
+            while true {
+                let read = try readable.read(buffer, deadline: .never)
+                
+                guard !read.isEmpty else {
+                    break
+                }
+                
+                inflated.append(contentsOf: read)
+            }
+            
+            return String(decoding: inflated, as: UTF8.self)
+        }
+    }
+}
+
+extension CompressionTests {
+    public static var allTests: [(String, (CompressionTests) -> () throws -> Void)] {
+        return [
+            ("testRoundTrip", testRoundTrip),
+            ("testRatioLimit", testRatioLimit),
+            ("testTruncatedStream", testTruncatedStream),
+            ("testBodilessResponses", testBodilessResponses),
+            ("testNegotiation", testNegotiation),
+            ("testSkipRules", testSkipRules),
+        ]
+    }
+}
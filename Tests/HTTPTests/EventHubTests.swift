@@ -0,0 +1,108 @@
+import XCTest
+import Core
+import Venice
+@testable import HTTP
+
+public class EventHubTests: XCTestCase {
+    func testSerializedEvent() {
+        let event = ServerSentEvent(data: "a\nb\r\nc", event: "update", retry: 500)
+        let serialized = SerializedEvent(event, id: "7", topic: "news")
+        let payload = "event: update\nid: 7\nretry: 500\ndata: a\ndata: b\ndata: c\n\n"
+
+        XCTAssertEqual(Array(serialized.framed[serialized.payload]), Array(payload.utf8))
+        XCTAssertEqual(serialized.framed, Array(("38\r\n" + payload + "\r\n").utf8))
+    }
+
+    func testComment() {
+        let heartbeat = SerializedEvent(comment: "still\nhere")
+        XCTAssertEqual(heartbeat.framed, Array("d\r\n: stillhere\n\n\r\n".utf8))
+    }
+
+    func testPublish() throws {
+        let hub = EventHub()
+        let (output, coroutine) = try subscribe(to: hub, topics: ["news"])
+
+        XCTAssertEqual(hub.subscriberCount, 1)
+        hub.publish(ServerSentEvent(data: "one"), to: "news")
+        hub.publish(ServerSentEvent(data: "elsewhere"), to: "sports")
+        try Coroutine.wakeUp(10.milliseconds.fromNow())
+
+        XCTAssertEqual(String(decoding: output.buffer, as: UTF8.self), "id: 1\ndata: one\n\n")
+
+        coroutine.cancel()
+        XCTAssertEqual(hub.subscriberCount, 0)
+    }
+
+    func testEviction() throws {
+        var configuration = EventHub.Configuration()
+        configuration.queueCapacity = 2
+        let hub = EventHub(configuration: configuration)
+        let (output, coroutine) = try subscribe(to: hub, topics: ["news"])
+
+        defer {
+            coroutine.cancel()
+        }
+
+        // Published without yielding, so the subscriber never drains.
+        for data in ["one", "two", "three"] {
+            hub.publish(ServerSentEvent(data: data), to: "news")
+        }
+
+        XCTAssertEqual(hub.evictionCount, 1)
+        XCTAssertEqual(hub.subscriberCount, 0)
+
+        try Coroutine.wakeUp(10.milliseconds.fromNow())
+        XCTAssertTrue(output.buffer.isEmpty)
+    }
+
+    func testReplay() throws {
+        let hub = EventHub()
+        hub.publish(ServerSentEvent(data: "one"), to: "news")
+        hub.publish(ServerSentEvent(data: "elsewhere"), to: "sports")
+        hub.publish(ServerSentEvent(data: "three"), to: "news")
+
+        let (output, coroutine) = try subscribe(to: hub, topics: ["news"], lastEventID: "1")
+
+        defer {
+            coroutine.cancel()
+        }
+
+        hub.publish(ServerSentEvent(data: "four"), to: "news")
+        try Coroutine.wakeUp(10.milliseconds.fromNow())
+
+        let expected = "id: 3\ndata: three\n\nid: 4\ndata: four\n\n"
+        XCTAssertEqual(String(decoding: output.buffer, as: UTF8.self), expected)
+    }
+
+    /// Streams a subscription's body into a buffer from a coroutine of its
+    /// own, without a connection.
+    private func subscribe(
+        to hub: EventHub,
+        topics: [String],
+        lastEventID: String? = nil
+    ) throws -> (WritableBuffer, Coroutine) {
+        var headers: Headers = [:]
+        headers["Last-Event-ID"] = lastEventID
+        let response = hub.subscribe(try Request(method: .get, uri: "/events", headers: headers), to: topics)
+        let output = WritableBuffer()
+
+        let coroutine = try Coroutine {
+            try? response.body.writable?(output)
+        }
+
+        try Coroutine.wakeUp(10.milliseconds.fromNow())
+        return (output, coroutine)
+    }
+}
+
+extension EventHubTests {
+    public static var allTests: [(String, (EventHubTests) -> () throws -> Void)] {
+        return [
+            ("testSerializedEvent", testSerializedEvent),
+            ("testComment", testComment),
+            ("testPublish", testPublish),
+            ("testEviction", testEviction),
+            ("testReplay", testReplay),
+        ]
+    }
+}
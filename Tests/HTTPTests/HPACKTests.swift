@@ -0,0 +1,116 @@
+import XCTest
+import Core
+@testable import HTTP
+
+public class HPACKTests: XCTestCase {
+    func testRequestExamples() throws {
+        // RFC 7541, appendix C.3
+        try assertDecoding([
+            "828684410f7777772e6578616d706c652e636f6d",
+            "828684be58086e6f2d6361636865",
+            "828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565",
+        ])
+    }
+
+    func testHuffmanRequestExamples() throws {
+        // RFC 7541, appendix C.4
+        try assertDecoding([
+            "828684418cf1e3c2e5f23a6ba0ab90f4ff",
+            "828684be5886a8eb10649cbf",
+            "828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+        ])
+    }
+
+    func testHuffman() throws {
+        var encoded: [UInt8] = []
+        Huffman.encode(Array("www.example.com".utf8), into: &encoded)
+        XCTAssertEqual(hex(encoded), "f1e3c2e5f23a6ba0ab90f4ff")
+        XCTAssertEqual(Huffman.encodedCount(of: Array("www.example.com".utf8)), 12)
+
+        let bytes = (0 ..< 1024).map({ UInt8(truncatingIfNeeded: $0 &* 31) })
+        encoded = []
+        Huffman.encode(bytes, into: &encoded)
+        XCTAssertEqual(try Huffman.decode(encoded[...]), bytes)
+
+        // Padding longer than seven bits, or not all ones, is invalid.
+        XCTAssertThrowsError(try Huffman.decode([0xf1, 0xff][...]))
+        XCTAssertThrowsError(try Huffman.decode([0x00][...]))
+    }
+
+    func testRoundTrip() throws {
+        let encoder = HPACKEncoder()
+        let decoder = HPACKDecoder()
+
+        let fields: [HeaderField] = [
+            (":method", "POST"),
+            (":scheme", "https"),
+            (":path", "/upload?id=42"),
+            (":authority", "example.com"),
+            ("content-type", "application/json"),
+            ("authorization", "Bearer secret"),
+            ("x-custom", String(repeating: "a", count: 300)),
+        ]
+
+        for _ in 0 ..< 3 {
+            var block: [UInt8] = []
+            encoder.encode(fields, into: &block)
+            let decoded = try decoder.decode(block)
+
+            XCTAssertEqual(decoded.map({ $0.name }), fields.map({ $0.name }))
+            XCTAssertEqual(decoded.map({ $0.value }), fields.map({ $0.value }))
+        }
+
+        XCTAssertThrowsError(try HPACKDecoder().decode([0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f]))
+        XCTAssertThrowsError(try HPACKDecoder().decode([0xbf]))
+    }
+
+    private func assertDecoding(_ blocks: [String]) throws {
+        let decoder = HPACKDecoder()
+        var decoded: [[HeaderField]] = []
+
+        for block in blocks {
+            decoded.append(try decoder.decode(bytes(block)))
+        }
+
+        XCTAssertEqual(decoded[0].map({ "\($0.name): \($0.value)" }), [
+            ":method: GET",
+            ":scheme: http",
+            ":path: /",
+            ":authority: www.example.com",
+        ])
+
+        XCTAssertEqual(decoded[1].last?.name, "cache-control")
+        XCTAssertEqual(decoded[1].last?.value, "no-cache")
+
+        XCTAssertEqual(decoded[2].map({ "\($0.name): \($0.value)" }), [
+            ":method: GET",
+            ":scheme: https",
+            ":path: /index.html",
+            ":authority: www.example.com",
+            "custom-key: custom-value",
+        ])
+    }
+
+    private func bytes(_ hex: String) -> [UInt8] {
+        let digits = Array(hex.utf8)
+
+        return stride(from: 0, to: digits.count, by: 2).map {
+            UInt8(String(decoding: digits[$0 ..< $0 + 2], as: UTF8.self), radix: 16)!
+        }
+    }
+
+    private func hex(_ bytes: [UInt8]) -> String {
+        return bytes.map({ ($0 < 16 ? "0" : "") + String($0, radix: 16) }).joined()
+    }
+}
+
+extension HPACKTests {
+    public static var allTests: [(String, (HPACKTests) -> () throws -> Void)] {
+        return [
+            ("testRequestExamples", testRequestExamples),
+            ("testHuffmanRequestExamples", testHuffmanRequestExamples),
+            ("testHuffman", testHuffman),
+            ("testRoundTrip", testRoundTrip),
+        ]
+    }
+}
@@ -0,0 +1,282 @@
+import XCTest
+import Core
+import IO
+import Venice
+@testable import HTTP
+
+public class HTTP2Tests: XCTestCase {
+    func testRequest() throws {
+        let server = Server(http2: .default) { request -> Response in
+            XCTAssertEqual(request.version, .two)
+            return Response(status: .ok, body: "Hello over " + request.uri.path!)
+        }
+
+        let coroutine = try Coroutine {
+            try? server.start(port: 8090)
+        }
+
+        defer {
+            coroutine.cancel()
+        }
+
+        try Coroutine.wakeUp(100.milliseconds.fromNow())
+
+        var configuration = Client.Configuration()
+        configuration.http2 = .default
+        let client = try Client(uri: "http://127.0.0.1:8090", configuration: configuration)
+
+        for path in ["/one", "/two"] {
+            let response = try client.send(try Request(method: .get, uri: path))
+            XCTAssertEqual(response.status, .ok)
+
+            let buffer = UnsafeMutableRawBufferPointer.allocate(byteCount: 64, alignment: 1)
+
+            defer {
+                buffer.deallocate()
+            }
+
+            let read = try response.body.convertedToReadable().read(buffer, deadline: 1.second.fromNow())
+            XCTAssertEqual(String(read), "Hello over " + path)
+        }
+    }
+
+    func testContinuation() throws {
+        let coroutine = try serve(port: 8091)
+
+        defer {
+            coroutine.cancel()
+        }
+
+        let connection = try RawConnection(port: 8091)
+        try connection.start()
+
+        var block: [UInt8] = []
+        connection.encoder.encode(RawConnection.requestFields(path: "/split"), into: &block)
+        try connection.write(Frame(.headers, flags: .endStream, stream: 1, payload: Array(block[..<4])))
+        try connection.write(Frame(.continuation, flags: .endHeaders, stream: 1, payload: Array(block[4...])))
+
+        _ = try connection.next(where: { $0.kind == .headers && $0.stream == 1 })
+        XCTAssertEqual(connection.status, "200")
+    }
+
+    func testUpgrade() throws {
+        let coroutine = try serve(port: 8092)
+
+        defer {
+            coroutine.cancel()
+        }
+
+        let connection = try RawConnection(port: 8092)
+        var request = "GET /upgraded HTTP/1.1\r\nHost: 127.0.0.1\r\n"
+        request += "Connection: Upgrade, HTTP2-Settings\r\nUpgrade: h2c\r\nHTTP2-Settings: AAMAAABkAAQAAP__\r\n\r\n"
+        try connection.write(Array(request.utf8))
+
+        XCTAssert(try connection.readHead().hasPrefix("HTTP/1.1 101"))
+        try connection.start()
+
+        _ = try connection.next(where: { $0.kind == .headers && $0.stream == 1 })
+        XCTAssertEqual(connection.status, "200")
+    }
+
+    func testResetStreamsKeepCountingUntilTheirHandlersReturn() throws {
+        var settings = HTTP2Settings()
+        settings.maximumConcurrentStreams = 2
+        var cancelled: [Bool] = []
+
+        // The handlers ignore cancellation, as a busy handler would.
+        let coroutine = try serve(port: 8093, settings: settings) { request in
+            try? Coroutine.wakeUp(500.milliseconds.fromNow())
+            cancelled.append(request.cancellation?.isCancelled ?? false)
+        }
+
+        defer {
+            coroutine.cancel()
+        }
+
+        let connection = try RawConnection(port: 8093)
+        try connection.start()
+
+        for id: UInt32 in [1, 3] {
+            try connection.headers(on: id, endStream: true)
+            try connection.write(Frame(.resetStream, stream: id, payload: [0, 0, 0, 8]))
+        }
+
+        try connection.headers(on: 5, endStream: true)
+
+        let refusal = try connection.next(where: { $0.kind == .resetStream && $0.stream == 5 })
+        XCTAssertEqual(Frame.integer(in: refusal.payload, at: 0), HTTP2ErrorCode.refusedStream.rawValue)
+
+        try Coroutine.wakeUp(1.second.fromNow())
+        XCTAssertEqual(cancelled, [true, true])
+    }
+
+    func testRapidReset() throws {
+        var settings = HTTP2Settings()
+        settings.maximumResetRate = 10
+
+        let coroutine = try serve(port: 8094, settings: settings)
+
+        defer {
+            coroutine.cancel()
+        }
+
+        let connection = try RawConnection(port: 8094)
+        try connection.start()
+
+        for id in stride(from: UInt32(1), to: 41, by: 2) {
+            try connection.headers(on: id, endStream: true)
+            try connection.write(Frame(.resetStream, stream: id, payload: [0, 0, 0, 8]))
+        }
+
+        let goAway = try connection.next(where: { $0.kind == .goAway })
+        XCTAssertEqual(Frame.integer(in: goAway.payload, at: 4), HTTP2ErrorCode.enhanceYourCalm.rawValue)
+    }
+
+    func testUnreadBodiesAreCredited() throws {
+        var settings = HTTP2Settings()
+        settings.connectionWindowSize = HTTP2Settings.defaultWindowSize
+
+        // The handler answers without reading the body, which the
+        // connection must still credit once the stream is gone.
+        let coroutine = try serve(port: 8095, settings: settings)
+
+        defer {
+            coroutine.cancel()
+        }
+
+        let connection = try RawConnection(port: 8095)
+        try connection.start()
+
+        let chunk = [UInt8](repeating: 42, count: 16 * 1024)
+
+        for id in stride(from: UInt32(1), to: 17, by: 2) {
+            try connection.headers(on: id, method: "POST", endStream: false)
+            try connection.write(Frame(.data, flags: .endStream, stream: id, payload: chunk))
+
+            let response = try connection.next(where: {
+                $0.kind == .goAway || ($0.kind == .headers && $0.stream == id)
+            })
+
+            XCTAssertEqual(response.kind, .headers)
+        }
+    }
+
+    private func serve(
+        port: Int,
+        settings: HTTP2Settings = .default,
+        handler: @escaping (Request) -> Void = { _ in }
+    ) throws -> Coroutine {
+        let server = Server(http2: settings) { request -> Response in
+            handler(request)
+            return Response(status: .ok)
+        }
+
+        let coroutine = try Coroutine {
+            try? server.start(port: port)
+        }
+
+        try Coroutine.wakeUp(100.milliseconds.fromNow())
+        return coroutine
+    }
+
+    public static var allTests: [(String, (HTTP2Tests) -> () throws -> Void)] {
+        return [
+            ("testRequest", testRequest),
+            ("testContinuation", testContinuation),
+            ("testUpgrade", testUpgrade),
+            ("testResetStreamsKeepCountingUntilTheirHandlersReturn", testResetStreamsKeepCountingUntilTheirHandlersReturn),
+            ("testRapidReset", testRapidReset),
+            ("testUnreadBodiesAreCredited", testUnreadBodiesAreCredited),
+        ]
+    }
+}
+
+/// Client speaking frames directly, to send what `Client` never would.
+private final class RawConnection {
+    let stream: TCPStream
+    let reader: FrameReader
+    let encoder = HPACKEncoder()
+    let decoder = HPACKDecoder()
+    let deadline = 10.seconds.fromNow()
+
+    /// Fields of the last header block read
+    var fields: [HeaderField] = []
+
+    init(port: Int) throws {
+        stream = try TCPStream(host: "127.0.0.1", port: port, deadline: deadline)
+        try stream.open(deadline: deadline)
+        reader = FrameReader(stream: stream, maximumFrameSize: 16 * 1024)
+    }
+
+    static func requestFields(method: String = "GET", path: String = "/") -> [HeaderField] {
+        return [(":method", method), (":scheme", "http"), (":path", path), (":authority", "127.0.0.1")]
+    }
+
+    func start() throws {
+        var output = FrameReader.preface
+        Frame(.settings).encode(into: &output)
+        try write(output)
+    }
+
+    func headers(on id: UInt32, method: String = "GET", endStream: Bool) throws {
+        var block: [UInt8] = []
+        encoder.encode(RawConnection.requestFields(method: method), into: &block)
+        try write(Frame(.headers, flags: endStream ? [.endHeaders, .endStream] : .endHeaders, stream: id, payload: block))
+    }
+
+    func write(_ frame: Frame) throws {
+        var output: [UInt8] = []
+        frame.encode(into: &output)
+        try write(output)
+    }
+
+    func write(_ bytes: [UInt8]) throws {
+        try bytes.withUnsafeBytes {
+            try stream.write($0, deadline: deadline)
+        }
+    }
+
+    /// Reads an HTTP/1.1 response head a byte at a time, so no frame
+    /// after it is consumed.
+    func readHead() throws -> String {
+        let byte = UnsafeMutableRawBufferPointer.allocate(byteCount: 1, alignment: 1)
+
+        defer {
+            byte.deallocate()
+        }
+
+        var head: [UInt8] = []
+
+        while !head.reversed().starts(with: Array("\n\r\n\r".utf8)) {
+            let read = try stream.read(byte, deadline: deadline)
+
+            guard let value = read.first else {
+                break
+            }
+
+            head.append(value)
+        }
+
+        return String(decoding: head, as: UTF8.self)
+    }
+
+    func next(where predicate: (Frame) -> Bool) throws -> Frame {
+        while true {
+            let frame = try reader.read(deadline: deadline)
+
+            if frame.kind == .headers {
+                // Every block is decoded to keep the table in step with
+                // the server's.
+                fields = try decoder.decode(Array(try frame.content()))
+            }
+
+            if predicate(frame) {
+                return frame
+            }
+        }
+    }
+
+    var status: String? {
+        return fields.first(where: { $0.name == ":status" })?.value
+    }
+}
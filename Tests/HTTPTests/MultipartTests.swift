@@ -0,0 +1,113 @@
+import XCTest
+import Core
+import IO
+import Venice
+@testable import HTTP
+
+public class MultipartTests: XCTestCase {
+    func testBoundarySearch() {
+        let search = BoundarySearch(Array("\r\n--abc".utf8))
+
+        Array("xx\r\n--abx\r\n--abc".utf8).withUnsafeBytes { (haystack: UnsafeRawBufferPointer) -> Void in
+            XCTAssertEqual(search.firstIndex(in: haystack), 9)
+        }
+
+        Array("xxxxxxxx\r\n--a".utf8).withUnsafeBytes { (haystack: UnsafeRawBufferPointer) -> Void in
+            XCTAssertNil(search.firstIndex(in: haystack))
+            XCTAssertEqual(search.safePrefixLength(in: haystack), 8)
+        }
+    }
+
+    func testParts() throws {
+        let body = "preamble\r\n" +
+            "--XyZ\r\n" +
+            "Content-Disposition: form-data; name=\"title\"\r\n" +
+            "\r\n" +
+            "Hello\r\n--Xy\r\n" +
+            "--XyZ  \r\n" +
+            "Content-Disposition: form-data; name=\"file\"; filename=\"a \\\"b\\\".txt\"\r\n" +
+            "Content-Type: text/plain\r\n" +
+            "\r\n" +
+            String(repeating: "0123456789", count: 100) + "\r\n" +
+            "--XyZ\r\n" +
+            "Content-Disposition: form-data; name=\"skipped\"\r\n" +
+            "\r\n" +
+            "ignored\r\n" +
+            "--XyZ--\r\n" +
+            "epilogue"
+
+        let parser = MultipartParser(stream: Drip(Array(body.utf8)), boundary: "XyZ", bufferSize: 64)
+
+        let title = try XCTUnwrap(parser.nextPart(deadline: .never))
+        XCTAssertEqual(title.name, "title")
+        XCTAssertNil(title.filename)
+        XCTAssertEqual(try title.spool(deadline: .never).bytes, Array("Hello\r\n--Xy".utf8))
+
+        let file = try XCTUnwrap(parser.nextPart(deadline: .never))
+        XCTAssertEqual(file.name, "file")
+        XCTAssertEqual(file.filename, "a \"b\".txt")
+        XCTAssertEqual(file.contentType?.subtype, "plain")
+
+        let spooled = try file.spool(memoryLimit: 100, deadline: .never)
+
+        guard case let .file(temporary) = spooled.contents else {
+            return XCTFail("Part was not spooled to disk")
+        }
+
+        let buffer = WritableBuffer()
+        try pipe(from: temporary, to: buffer, deadline: .never)
+        XCTAssertEqual(buffer.buffer, Array(String(repeating: "0123456789", count: 100).utf8))
+
+        let skipped = try XCTUnwrap(parser.nextPart(deadline: .never))
+        XCTAssertEqual(skipped.name, "skipped")
+
+        XCTAssertNil(try parser.nextPart(deadline: .never))
+    }
+
+    func testTruncatedBody() throws {
+        let body = "--XyZ\r\nContent-Disposition: form-data; name=\"a\"\r\n\r\nunfinished"
+        let parser = MultipartParser(stream: Drip(Array(body.utf8)), boundary: "XyZ")
+
+        XCTAssertNotNil(try parser.nextPart(deadline: .never))
+        XCTAssertThrowsError(try parser.nextPart(deadline: .never))
+    }
+}
+
+/// Hands out a few bytes at a time, so boundaries straddle reads.
+private final class Drip : Readable {
+    private var bytes: ArraySlice<UInt8>
+
+    init(_ bytes: [UInt8]) {
+        self.bytes = bytes[...]
+    }
+
+    func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        let count = min(buffer.count, bytes.count, 7)
+
+        for index in 0 ..< count {
+            buffer[index] = bytes.removeFirst()
+        }
+
+        return UnsafeRawBufferPointer(rebasing: buffer[0 ..< count])
+    }
+}
+
+extension SpooledBuffer {
+    fileprivate var bytes: [UInt8]? {
+        guard case let .bytes(bytes) = contents else {
+            return nil
+        }
+
+        return bytes
+    }
+}
+
+extension MultipartTests {
+    public static var allTests: [(String, (MultipartTests) -> () throws -> Void)] {
+        return [
+            ("testBoundarySearch", testBoundarySearch),
+            ("testParts", testParts),
+            ("testTruncatedBody", testTruncatedBody),
+        ]
+    }
+}
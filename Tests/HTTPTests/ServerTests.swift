@@ -1,6 +1,8 @@
 import XCTest
 import Media
 import HTTP
+import Core
+import IO
 import Venice
 
 public class ServerTests: XCTestCase {
@@ -43,12 +45,281 @@ public class ServerTests: XCTestCase {
         
         try Coroutine.wakeUp(10.seconds.fromNow())
     }
+    
+    func testEarlyHints() throws {
+        let link = "</app.css>; rel=preload; as=style"
+        
+        let server = Server { request -> Response in
+            XCTAssertTrue(request.acceptsInterimResponses)
+            try? request.sendEarlyHints(links: [link])
+            return Response(status: .ok, body: "Hello")
+        }
+        
+        let coroutine = try Coroutine {
+            do {
+                try server.start(port: 8081)
+            } catch {
+                XCTAssertEqual("\(error)", "Operation canceled")
+            }
+        }
+        
+        try Coroutine.wakeUp(1.second.fromNow())
+        
+        var hints: [Response] = []
+        let client = try Client(uri: "http://127.0.0.1:8081")
+        let request = try Request(method: .get, uri: "/")
+        
+        request.receiveInterimResponse = { response in
+            hints.append(response)
+        }
+        
+        let response = try client.send(request)
+        
+        XCTAssertEqual(response.status, .ok)
+        XCTAssertEqual(hints.count, 1)
+        XCTAssertEqual(hints.first?.status, .earlyHints)
+        XCTAssertEqual(hints.first?.headers["Link"], link)
+        
+        coroutine.cancel()
+        
+        try Coroutine.wakeUp(10.seconds.fromNow())
+    }
+    
+    func testBodyLimits() throws {
+        let limits = BodyLimits(maximumSize: 4, routes: ["/upload": 8])
+        let bytes = Array("0123456789".utf8)
+        
+        try bytes.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) -> Void in
+            let request = try Request(method: .post, uri: "/upload/avatar", body: ReadableBuffer(buffer))
+            XCTAssertEqual(limits.maximumSize(for: request), 8)
+            
+            try request.limitBody(to: 8)
+            XCTAssertThrowsError(try pipe(from: request.body.convertedToReadable(), to: WritableBuffer(), deadline: .never))
+            XCTAssertTrue(request.bodyExceededLimit)
+        }
+        
+        let request = try Request(method: .post, uri: "/", headers: ["Content-Length": "10"], body: ReadableBuffer.empty)
+        XCTAssertEqual(limits.maximumSize(for: request), 4)
+        XCTAssertThrowsError(try request.limitBody(to: 4))
+        XCTAssertTrue(request.bodyExceededLimit)
+    }
+    
+    func testPipelining() throws {
+        var events: [String] = []
+        
+        let server = Server(pipelineDepth: 4) { request -> Response in
+            let path = request.uri.path ?? "/"
+            events.append("start " + path)
+            
+            // The first request finishes last.
+            if path == "/slow" {
+                try? Coroutine.wakeUp(300.milliseconds.fromNow())
+            }
+            
+            events.append("end " + path)
+            return Response(status: .ok, body: path)
+        }
+        
+        let coroutine = try Coroutine {
+            do {
+                try server.start(port: 8084)
+            } catch {
+                XCTAssertEqual("\(error)", "Operation canceled")
+            }
+        }
+        
+        try Coroutine.wakeUp(1.second.fromNow())
+        
+        let deadline = 5.seconds.fromNow()
+        let stream = try TCPStream(host: "127.0.0.1", port: 8084, deadline: deadline)
+        try stream.open(deadline: deadline)
+        
+        try stream.write(
+            "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n" +
+            "GET /fast HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n",
+            deadline: deadline
+        )
+        
+        let buffer = UnsafeMutableRawBufferPointer.allocate(byteCount: 1024, alignment: 1)
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        var received: [UInt8] = []
+        
+        while true {
+            let read = try stream.read(buffer, deadline: deadline)
+            
+            guard !read.isEmpty else {
+                break
+            }
+            
+            received.append(contentsOf: read)
+        }
+        
+        let text = String(decoding: received, as: UTF8.self)
+        let slow = try XCTUnwrap(text.range(of: "/slow"))
+        let fast = try XCTUnwrap(text.range(of: "/fast"))
+        XCTAssertLessThan(slow.lowerBound, fast.lowerBound)
+        
+        // Responses go out in order, but the handlers ran side by side.
+        let fastStarted = try XCTUnwrap(events.firstIndex(of: "start /fast"))
+        let slowEnded = try XCTUnwrap(events.firstIndex(of: "end /slow"))
+        XCTAssertLessThan(fastStarted, slowEnded)
+        
+        try stream.close(deadline: deadline)
+        coroutine.cancel()
+        
+        try Coroutine.wakeUp(10.seconds.fromNow())
+    }
+    
+    func testCancelOnDisconnect() throws {
+        var started = false
+        var outcome: Error?
+        
+        let server = Server { request -> Response in
+            started = true
+            
+            do {
+                try request.cancellation?.run {
+                    try Coroutine.wakeUp(5.seconds.fromNow())
+                }
+            } catch {
+                outcome = error
+            }
+            
+            return Response(status: .ok)
+        }
+        
+        let coroutine = try Coroutine {
+            try? server.start(port: 8086)
+        }
+        
+        defer {
+            coroutine.cancel()
+        }
+        
+        try Coroutine.wakeUp(100.milliseconds.fromNow())
+        
+        let deadline = 5.seconds.fromNow()
+        let stream = try TCPStream(host: "127.0.0.1", port: 8086, deadline: deadline)
+        try stream.open(deadline: deadline)
+        try stream.write("GET / HTTP/1.1\r\nHost: localhost\r\n\r\n", deadline: deadline)
+        
+        try Coroutine.wakeUp(200.milliseconds.fromNow())
+        XCTAssertTrue(started)
+        XCTAssertNil(outcome)
+        
+        // The client gives up while the handler is still running.
+        try stream.close(deadline: deadline)
+        try Coroutine.wakeUp(500.milliseconds.fromNow())
+        
+        guard case CancellationError.cancelled? = outcome else {
+            return XCTFail("Handler was not cancelled: \(String(describing: outcome))")
+        }
+    }
+    
+    func testExpectContinue() throws {
+        let server = Server { request -> Response in
+            // Rejected uploads are answered without reading the body.
+            guard request.uri.path == "/upload" else {
+                return Response(status: .requestEntityTooLarge)
+            }
+            
+            let buffer = UnsafeMutableRawBufferPointer.allocate(byteCount: 16, alignment: 1)
+            
+            defer {
+                buffer.deallocate()
+            }
+            
+            guard let read = try? request.body.convertedToReadable().read(buffer, deadline: 1.second.fromNow()) else {
+                return Response(status: .badRequest)
+            }
+            
+            return Response(status: .ok, body: String(read))
+        }
+        
+        let coroutine = try Coroutine {
+            try? server.start(port: 8088)
+        }
+        
+        defer {
+            coroutine.cancel()
+        }
+        
+        try Coroutine.wakeUp(100.milliseconds.fromNow())
+        
+        let deadline = 5.seconds.fromNow()
+        let upload = try TCPStream(host: "127.0.0.1", port: 8088, deadline: deadline)
+        try upload.open(deadline: deadline)
+        
+        try upload.write(
+            "POST /upload HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n" +
+            "Expect: 100-continue\r\nConnection: close\r\n\r\n",
+            deadline: deadline
+        )
+        
+        // The body is only sent once the handler's first read asks for it.
+        XCTAssertEqual(try readText(from: upload, until: "\r\n\r\n", deadline: deadline), "HTTP/1.1 100 Continue\r\n\r\n")
+        try upload.write("Hello", deadline: deadline)
+        
+        let accepted = try readText(from: upload, until: nil, deadline: deadline)
+        XCTAssert(accepted.hasPrefix("HTTP/1.1 200 OK"))
+        XCTAssert(accepted.hasSuffix("\r\n\r\nHello"))
+        try upload.close(deadline: deadline)
+        
+        let rejected = try TCPStream(host: "127.0.0.1", port: 8088, deadline: deadline)
+        try rejected.open(deadline: deadline)
+        
+        try rejected.write(
+            "POST /reject HTTP/1.1\r\nHost: localhost\r\nContent-Length: 5\r\n" +
+            "Expect: 100-continue\r\n\r\n",
+            deadline: deadline
+        )
+        
+        // No 100 Continue goes out, and as the client may still send the
+        // body, the server closes the connection after its answer.
+        let answer = try readText(from: rejected, until: nil, deadline: deadline)
+        XCTAssert(answer.hasPrefix("HTTP/1.1 413"))
+        XCTAssert(answer.contains("Connection: close\r\n"))
+        try rejected.close(deadline: deadline)
+    }
+    
+    /// Reads until `terminator` was read or, if `nil`, the server closes
+    /// the connection.
+    private func readText(from stream: TCPStream, until terminator: String?, deadline: Deadline) throws -> String {
+        let byte = UnsafeMutableRawBufferPointer.allocate(byteCount: 1, alignment: 1)
+        
+        defer {
+            byte.deallocate()
+        }
+        
+        var text = ""
+        
+        while terminator.map({ !text.hasSuffix($0) }) ?? true {
+            let read = try stream.read(byte, deadline: deadline)
+            
+            guard !read.isEmpty else {
+                break
+            }
+            
+            text += String(decoding: read, as: UTF8.self)
+        }
+        
+        return text
+    }
 }
 
 extension ServerTests {
     public static var allTests: [(String, (ServerTests) -> () throws -> Void)] {
         return [
             ("testServer", testServer),
+            ("testEarlyHints", testEarlyHints),
+            ("testBodyLimits", testBodyLimits),
+            ("testPipelining", testPipelining),
+            ("testCancelOnDisconnect", testCancelOnDisconnect),
+            ("testExpectContinue", testExpectContinue),
         ]
     }
 }
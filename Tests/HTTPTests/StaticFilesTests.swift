@@ -0,0 +1,75 @@
+import XCTest
+import Foundation
+import Core
+import HTTP
+
+public class StaticFilesTests: XCTestCase {
+    func testStaticFiles() throws {
+        let root = NSTemporaryDirectory() + "StaticFilesTests-\(getpid())"
+        let manager = FileManager.default
+        try manager.createDirectory(atPath: root, withIntermediateDirectories: true)
+        
+        defer {
+            try? manager.removeItem(atPath: root)
+        }
+        
+        let contents = "Hello, static files!"
+        manager.createFile(atPath: root + "/hello.txt", contents: contents.data(using: .utf8))
+        manager.createFile(atPath: root + "/hello.txt.gz", contents: "gz".data(using: .utf8))
+        
+        let files = StaticFiles(root: root)
+        
+        let response = files.respond(to: try Request(method: .get, uri: "/hello.txt"))
+        XCTAssertEqual(response.status.statusCode, 200)
+        XCTAssertEqual(response.contentLength, contents.utf8.count)
+        XCTAssertEqual(response.headers["Content-Type"], "text/plain")
+        XCTAssertEqual(response.headers["Vary"], "Accept-Encoding")
+        XCTAssertNil(response.headers["Content-Encoding"])
+        XCTAssertEqual(try read(response), contents)
+        
+        guard let etag = response.headers["ETag"], let lastModified = response.headers["Last-Modified"] else {
+            return XCTFail("Missing validators")
+        }
+        
+        let conditional = try Request(method: .get, uri: "/hello.txt", headers: ["If-None-Match": etag])
+        XCTAssertEqual(files.respond(to: conditional).status.statusCode, 304)
+        
+        let since = try Request(method: .get, uri: "/hello.txt", headers: ["If-Modified-Since": lastModified])
+        XCTAssertEqual(files.respond(to: since).status.statusCode, 304)
+        
+        let gzip = try Request(method: .get, uri: "/hello.txt", headers: ["Accept-Encoding": "br;q=0, gzip"])
+        let compressed = files.respond(to: gzip)
+        XCTAssertEqual(compressed.headers["Content-Encoding"], "gzip")
+        XCTAssertEqual(try read(compressed), "gz")
+        
+        let refused = try Request(method: .get, uri: "/hello.txt", headers: ["Accept-Encoding": "gzip;q=0"])
+        XCTAssertNil(files.respond(to: refused).headers["Content-Encoding"])
+        
+        XCTAssertEqual(files.respond(to: try Request(method: .get, uri: "/missing.txt")).status.statusCode, 404)
+        XCTAssertEqual(files.respond(to: try Request(method: .get, uri: "/../etc/passwd")).status.statusCode, 404)
+        XCTAssertEqual(files.respond(to: try Request(method: .delete, uri: "/hello.txt")).status.statusCode, 405)
+    }
+    
+    private func read(_ response: Response) throws -> String {
+        let readable = try response.body.convertedToReadable()
+        
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 1024,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        return String(try readable.read(buffer, deadline: .never))
+    }
+}
+
+extension StaticFilesTests {
+    public static var allTests: [(String, (StaticFilesTests) -> () throws -> Void)] {
+        return [
+            ("testStaticFiles", testStaticFiles),
+        ]
+    }
+}
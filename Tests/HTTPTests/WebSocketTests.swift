@@ -0,0 +1,160 @@
+import XCTest
+import Venice
+@testable import HTTP
+
+public class WebSocketTests: XCTestCase {
+    func testAccept() {
+        // RFC 6455, section 1.3
+        XCTAssertEqual(WebSocket.accept(forKey: "dGhlIHNhbXBsZSBub25jZQ=="), "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=")
+    }
+
+    func testMasking() {
+        let mask = WebSocketMask((0x37, 0xfa, 0x21, 0x3d))
+        let key: [UInt8] = [0x37, 0xfa, 0x21, 0x3d]
+        let original = (0 ..< 100).map({ UInt8(truncatingIfNeeded: $0 &* 7) })
+
+        // Every alignment and starting phase of the word-at-a-time path.
+        for start in 0 ..< 9 {
+            for phase in 0 ..< 4 {
+                var bytes = original
+
+                bytes.withUnsafeMutableBytes { buffer in
+                    _ = mask.apply(to: UnsafeMutableRawBufferPointer(rebasing: buffer[start...]), phase: phase)
+                }
+
+                for index in original.indices {
+                    let expected = index < start ? original[index] : original[index] ^ key[(index - start + phase) % 4]
+                    XCTAssertEqual(bytes[index], expected)
+                }
+            }
+        }
+    }
+
+    func testCloseCodes() {
+        let valid: [UInt16] = [1000, 1001, 1002, 1003, 1007, 1011, 1014, 3000, 4999]
+        let invalid: [UInt16] = [0, 999, 1005, 1006, 1015, 1016, 2999, 5000]
+
+        for code in valid {
+            XCTAssert(WebSocket.CloseCode(rawValue: code).isValid, "\(code)")
+        }
+
+        for code in invalid {
+            XCTAssertFalse(WebSocket.CloseCode(rawValue: code).isValid, "\(code)")
+        }
+    }
+
+    func testPerMessageDeflate() throws {
+        let offer = "permessage-deflate; server_max_window_bits=10, permessage-deflate; client_max_window_bits"
+        let negotiated = PerMessageDeflate.negotiate(offers: offer, level: -1)
+        XCTAssertEqual(negotiated?.response, "permessage-deflate; server_no_context_takeover")
+
+        let deflate = try XCTUnwrap(negotiated).1
+        let compressed = try Array("Hello".utf8).withUnsafeBytes(deflate.compress)
+
+        // RFC 7692, section 7.2.3.1
+        XCTAssertEqual(compressed, [0xf2, 0x48, 0xcd, 0xc9, 0xc9, 0x07, 0x00])
+        XCTAssertEqual(try deflate.decompress(compressed, maximumSize: 5), Array("Hello".utf8))
+        XCTAssertThrowsError(try deflate.decompress(compressed, maximumSize: 4))
+    }
+
+    func testEcho() throws {
+        var configuration = WebSocket.Configuration()
+        configuration.compressionThreshold = 0
+        configuration.maximumFrameSize = 3
+
+        let server = Server { request -> Response in
+            return Response(webSocketUpgradeFor: request, configuration: configuration) { socket in
+                while let message = try socket.receive() {
+                    switch message {
+                    case let .text(text):
+                        try socket.send(text)
+                    case let .binary(bytes):
+                        try socket.send(bytes)
+                    }
+                }
+            }
+        }
+
+        let coroutine = try Coroutine {
+            do {
+                try server.start(port: 8083)
+            } catch {
+                XCTAssertEqual("\(error)", "Operation canceled")
+            }
+        }
+
+        try Coroutine.wakeUp(1.second.fromNow())
+
+        var replies: [WebSocket.Message] = []
+
+        try WebSocket.connect(to: "ws://127.0.0.1:8083/", configuration: configuration) { socket in
+            XCTAssertNotNil(socket.deflate)
+
+            try socket.send("Hello, world")
+            replies.append(try XCTUnwrap(socket.receive(deadline: 1.second.fromNow())))
+
+            try socket.send([1, 2, 3, 4, 5])
+            replies.append(try XCTUnwrap(socket.receive(deadline: 1.second.fromNow())))
+
+            try socket.close()
+            XCTAssertNil(try socket.receive(deadline: 1.second.fromNow()))
+            XCTAssertEqual(socket.closeCode, .normal)
+        }
+
+        guard replies.count == 2, case let .text(text) = replies[0], case let .binary(bytes) = replies[1] else {
+            return XCTFail("Unexpected replies \(replies)")
+        }
+
+        XCTAssertEqual(text, "Hello, world")
+        XCTAssertEqual(bytes, [1, 2, 3, 4, 5])
+
+        coroutine.cancel()
+
+        try Coroutine.wakeUp(10.seconds.fromNow())
+    }
+
+    func testSilentPeer() throws {
+        // The handler never calls `receive`, so no ping is ever answered.
+        let server = Server { request -> Response in
+            return Response(webSocketUpgradeFor: request) { _ in
+                try Coroutine.wakeUp(3.seconds.fromNow())
+            }
+        }
+
+        let coroutine = try Coroutine {
+            try? server.start(port: 8087)
+        }
+
+        defer {
+            coroutine.cancel()
+        }
+
+        try Coroutine.wakeUp(100.milliseconds.fromNow())
+
+        var configuration = WebSocket.Configuration()
+        configuration.pingInterval = 100.milliseconds
+
+        try WebSocket.connect(to: "ws://127.0.0.1:8087/", configuration: configuration) { socket in
+            XCTAssertThrowsError(try socket.receive(deadline: 2.seconds.fromNow())) { error in
+                guard case WebSocketError.connectionClosed = error else {
+                    return XCTFail("Unexpected error \(error)")
+                }
+            }
+
+            XCTAssertFalse(socket.isOpen)
+        }
+    }
+}
+
+extension WebSocketTests {
+    public static var allTests: [(String, (WebSocketTests) -> () throws -> Void)] {
+        return [
+            ("testAccept", testAccept),
+            ("testMasking", testMasking),
+            ("testCloseCodes", testCloseCodes),
+            ("testPerMessageDeflate", testPerMessageDeflate),
+            ("testEcho", testEcho),
+            ("testSilentPeer", testSilentPeer),
+        ]
+    }
+}
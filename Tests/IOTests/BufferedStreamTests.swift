@@ -0,0 +1,100 @@
+import XCTest
+@testable import IO
+@testable import Core
+@testable import Venice
+
+private final class MemoryStream : DuplexStream {
+    var input: [UInt8]
+    var chunkSize: Int
+    var writes: [[UInt8]] = []
+    
+    init(input: String = "", chunkSize: Int = .max) {
+        self.input = Array(input.utf8)
+        self.chunkSize = chunkSize
+    }
+    
+    func open(deadline: Deadline) throws {}
+    func close(deadline: Deadline) throws {}
+    
+    func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        let count = min(buffer.count, chunkSize, input.count)
+        buffer.copyBytes(from: input[0 ..< count])
+        input.removeFirst(count)
+        return UnsafeRawBufferPointer(rebasing: buffer.prefix(count))
+    }
+    
+    func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        writes.append(Array(buffer))
+    }
+}
+
+public class BufferedStreamTests: XCTestCase {
+    func testPeekAndReadExactly() throws {
+        let memory = MemoryStream(input: "GET / HTTP/1.1", chunkSize: 3)
+        let stream = BufferedStream(memory, readBufferSize: 8)
+        
+        let peeked = try stream.peek(5, deadline: .never)
+        XCTAssertEqual(String(peeked), "GET /")
+        
+        let bytes = try stream.readExactly(count: 14, deadline: .never)
+        XCTAssertEqual(String(decoding: bytes, as: UTF8.self), "GET / HTTP/1.1")
+        XCTAssertThrowsError(try stream.readExactly(count: 1, deadline: .never))
+    }
+    
+    func testReadUntil() throws {
+        let memory = MemoryStream(input: "name: value\r\nother: thing\r\n\r\nbody", chunkSize: 5)
+        let stream = BufferedStream(memory, readBufferSize: 8)
+        let delimiter = Array("\r\n".utf8)
+        
+        let first = try stream.readUntil(delimiter: delimiter, deadline: .never)
+        XCTAssertEqual(String(decoding: first, as: UTF8.self), "name: value")
+        
+        let second = try stream.readUntil(delimiter: delimiter, deadline: .never)
+        XCTAssertEqual(String(decoding: second, as: UTF8.self), "other: thing")
+        
+        let empty = try stream.readUntil(delimiter: delimiter, deadline: .never)
+        XCTAssertTrue(empty.isEmpty)
+        
+        XCTAssertThrowsError(try stream.readUntil(delimiter: delimiter, deadline: .never))
+    }
+    
+    func testReadUntilMaximumCount() throws {
+        let memory = MemoryStream(input: "aaaaaaaaaaaaaaaa\n")
+        let stream = BufferedStream(memory, readBufferSize: 8)
+        XCTAssertThrowsError(try stream.readUntil(delimiter: [10], maximumCount: 10, deadline: .never))
+    }
+    
+    func testWriteCoalescing() throws {
+        let memory = MemoryStream()
+        let stream = BufferedStream(memory, writeBufferSize: 8)
+        
+        try stream.write("ab", deadline: .never)
+        try stream.write("cd", deadline: .never)
+        XCTAssertTrue(memory.writes.isEmpty)
+        
+        try stream.write("efghij", deadline: .never)
+        XCTAssertEqual(memory.writes.count, 1)
+        XCTAssertEqual(String(decoding: memory.writes[0], as: UTF8.self), "abcd")
+        
+        try stream.write("0123456789", deadline: .never)
+        XCTAssertEqual(memory.writes.count, 3)
+        XCTAssertEqual(String(decoding: memory.writes[1], as: UTF8.self), "efghij")
+        XCTAssertEqual(String(decoding: memory.writes[2], as: UTF8.self), "0123456789")
+        
+        try stream.write("k", deadline: .never)
+        try stream.flush(deadline: .never)
+        XCTAssertEqual(memory.writes.count, 4)
+        XCTAssertEqual(stream.bufferedWriteCount, 0)
+    }
+}
+
+extension BufferedStreamTests {
+    public static var allTests: [(String, (BufferedStreamTests) -> () throws -> Void)] {
+        return [
+            ("testPeekAndReadExactly", testPeekAndReadExactly),
+            ("testReadUntil", testReadUntil),
+            ("testReadUntilMaximumCount", testReadUntilMaximumCount),
+            ("testWriteCoalescing", testWriteCoalescing),
+        ]
+    }
+}
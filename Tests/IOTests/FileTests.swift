@@ -0,0 +1,160 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import XCTest
+@testable import IO
+@testable import Core
+@testable import Venice
+
+public class FileTests: XCTestCase {
+    let contents = (0 ..< 1024 * 1024).map({ UInt8(truncatingIfNeeded: $0 &* 31) })
+    
+    func testSendfile() throws {
+        let deadline = 1.minute.fromNow()
+        let port = 8012
+        let path = try create("/tmp/zewo-file-tests-sendfile.bin")
+        
+        defer {
+            unlink(path)
+        }
+        
+        let host = try TCPHost(port: port)
+        
+        let coroutine = try Coroutine {
+            do {
+                let stream = try host.accept(deadline: deadline)
+                try File(path: path).write(to: stream, deadline: deadline)
+                try stream.close(deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        let stream = try TCPStream(host: "127.0.0.1", port: port, deadline: deadline)
+        try stream.open(deadline: deadline)
+        XCTAssertEqual(try readAll(from: stream, deadline: deadline), contents)
+        try stream.close(deadline: deadline)
+        coroutine.cancel()
+    }
+    
+    func testPread() throws {
+        let deadline = 1.minute.fromNow()
+        let path = try create("/tmp/zewo-file-tests-pread.bin")
+        
+        defer {
+            unlink(path)
+        }
+        
+        let file = try File(path: path)
+        
+        // Spans several read buffers and starts in the middle of one.
+        let whole = WritableBuffer()
+        try file.write(to: whole, deadline: deadline)
+        XCTAssertEqual(whole.buffer, contents)
+        
+        let range = 1000 ..< File.readBufferSize * 3 + 1000
+        let part = WritableBuffer()
+        try file.write(range, to: part, deadline: deadline)
+        XCTAssertEqual(part.buffer, Array(contents[range]))
+        
+        XCTAssertThrowsError(try file.write(0 ..< contents.count + 1, to: part, deadline: deadline))
+    }
+    
+    func testTruncation() throws {
+        let deadline = 1.minute.fromNow()
+        let port = 8013
+        let path = try create("/tmp/zewo-file-tests-truncated.bin")
+        
+        defer {
+            unlink(path)
+        }
+        
+        let file = try File(path: path)
+        XCTAssertEqual(truncate(path, off_t(contents.count / 2)), 0)
+        
+        XCTAssertThrowsError(try file.write(to: WritableBuffer(), deadline: deadline)) { error in
+            guard case FileError.unexpectedEndOfFile = error else {
+                return XCTFail("Unexpected error \(error)")
+            }
+        }
+        
+        let host = try TCPHost(port: port)
+        
+        let coroutine = try Coroutine {
+            do {
+                let stream = try host.accept(deadline: deadline)
+                
+                XCTAssertThrowsError(try file.write(to: stream, deadline: deadline)) { error in
+                    guard case FileError.unexpectedEndOfFile = error else {
+                        return XCTFail("Unexpected error \(error)")
+                    }
+                }
+                
+                try stream.close(deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        let stream = try TCPStream(host: "127.0.0.1", port: port, deadline: deadline)
+        try stream.open(deadline: deadline)
+        XCTAssertEqual(try readAll(from: stream, deadline: deadline), Array(contents.prefix(contents.count / 2)))
+        try stream.close(deadline: deadline)
+        coroutine.cancel()
+    }
+    
+    private func create(_ path: String) throws -> String {
+        let descriptor = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0o644)
+        
+        guard descriptor != -1 else {
+            throw SystemError.lastOperationError
+        }
+        
+        defer {
+            close(descriptor)
+        }
+        
+        let written = contents.withUnsafeBytes {
+            write(descriptor, $0.baseAddress, $0.count)
+        }
+        
+        XCTAssertEqual(written, contents.count)
+        return path
+    }
+    
+    private func readAll(from stream: TCPStream, deadline: Deadline) throws -> [UInt8] {
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 64 * 1024,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        var bytes: [UInt8] = []
+        
+        while true {
+            let read = try stream.read(buffer, deadline: deadline)
+            
+            guard !read.isEmpty else {
+                return bytes
+            }
+            
+            bytes.append(contentsOf: read)
+        }
+    }
+}
+
+extension FileTests {
+    public static var allTests: [(String, (FileTests) -> () throws -> Void)] {
+        return [
+            ("testSendfile", testSendfile),
+            ("testPread", testPread),
+            ("testTruncation", testTruncation),
+        ]
+    }
+}
@@ -0,0 +1,30 @@
+import XCTest
+import Venice
+import Core
+@testable import IO
+
+public class StallDetectorTests: XCTestCase {
+    func testStall() throws {
+        let detector = StallDetector(interval: 1_000_000, threshold: 50_000_000, sampleStacks: true, metrics: nil)
+        try detector.start()
+        try Coroutine.wakeUp(5.milliseconds.fromNow())
+
+        // Spins rather than sleeps, since sampling interrupts sleeps.
+        detector.run("blocking") {
+            let end = MonotonicClock.now() + 100_000_000
+            while MonotonicClock.now() < end {}
+        }
+
+        try Coroutine.wakeUp(20.milliseconds.fromNow())
+        detector.stop()
+
+        XCTAssertEqual(detector.longestStalls.count, 1)
+        XCTAssertEqual(detector.longestStalls.first?.task, "blocking")
+        XCTAssertGreaterThanOrEqual(detector.longestStalls.first?.duration ?? 0, 50_000_000)
+        XCTAssertFalse(detector.longestStalls.first?.stack.isEmpty ?? true)
+    }
+
+    public static var allTests = [
+        ("testStall", testStall),
+    ]
+}
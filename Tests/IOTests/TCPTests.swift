@@ -86,14 +86,211 @@ public class TCPTests: XCTestCase {
         try channel.receive(deadline: deadline)
         coroutine.cancel()
     }
+
+    func testSocketOptions() throws {
+        let deadline = 1.minute.fromNow()
+        let port = 8007
+        let channel = try Channel<Void>()
+        
+        let options = SocketOptions(
+            noDelay: true,
+            cork: true,
+            sendBufferSize: 64 * 1024,
+            receiveBufferSize: 64 * 1024
+        )
+        
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 10,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        let coroutine = try Coroutine {
+            do {
+                let host = try TCPHost(port: port, reusePort: true, options: options)
+                let stream = try host.accept(deadline: deadline) as! TCPStream
+                try stream.cork()
+                try stream.write("Yo ", deadline: deadline)
+                try stream.write("client!", deadline: deadline)
+                try stream.uncork()
+                try stream.close(deadline: deadline)
+                try channel.send(deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        let stream = try TCPStream(host: "127.0.0.1", port: port, options: options, deadline: deadline)
+        try stream.open(deadline: deadline)
+        var received = ""
+        
+        while received.utf8.count < 10 {
+            let read: String = try stream.read(buffer, deadline: deadline)
+            XCTAssertFalse(read.isEmpty)
+            received += read
+        }
+        
+        XCTAssertEqual(received, "Yo client!")
+        try stream.close(deadline: deadline)
+        try channel.receive(deadline: deadline)
+        coroutine.cancel()
+    }
+
+    func testPipe() throws {
+        let deadline = 1.minute.fromNow()
+        let port = 8010
+        let count = 256 * 1024
+        let channel = try Channel<Int>()
+        let payload = [UInt8](repeating: 42, count: count)
+        
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 4096,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        let host = try TCPHost(port: port)
+        
+        let coroutine = try Coroutine {
+            do {
+                let source = try host.accept(deadline: deadline)
+                let destination = try host.accept(deadline: deadline)
+                let copied = try pipe(from: source, to: destination, deadline: deadline)
+                try source.close(deadline: deadline)
+                try destination.close(deadline: deadline)
+                try channel.send(copied, deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        let source = try TCPStream(host: "127.0.0.1", port: port, deadline: deadline)
+        try source.open(deadline: deadline)
+        let destination = try TCPStream(host: "127.0.0.1", port: port, deadline: deadline)
+        try destination.open(deadline: deadline)
+        
+        let writer = try Coroutine {
+            do {
+                try payload.withUnsafeBytes {
+                    try source.write($0, deadline: deadline)
+                }
+                
+                try source.close(deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        var received = 0
+        
+        while true {
+            let read = try destination.read(buffer, deadline: deadline)
+            
+            guard !read.isEmpty else {
+                break
+            }
+            
+            XCTAssertTrue(read.allSatisfy({ $0 == 42 }))
+            received += read.count
+        }
+        
+        XCTAssertEqual(received, count)
+        XCTAssertEqual(try channel.receive(deadline: deadline), count)
+        try destination.close(deadline: deadline)
+        writer.cancel()
+        coroutine.cancel()
+    }
 }
 
 extension TCPTests {
+    func testConcurrentPipes() throws {
+        let deadline = 1.minute.fromNow()
+        let group = Coroutine.Group()
+        let first = Collector()
+        let second = Collector()
+        
+        try group.addCoroutine {
+            XCTAssertEqual(try? pipe(from: Filler(byte: 1, count: 3), to: first, deadline: deadline), 3 * 1024)
+        }
+        
+        try group.addCoroutine {
+            XCTAssertEqual(try? pipe(from: Filler(byte: 2, count: 3), to: second, deadline: deadline), 3 * 1024)
+        }
+        
+        try Coroutine.wakeUp(100.milliseconds.fromNow())
+        group.cancel()
+        
+        XCTAssertEqual(first.bytes, [UInt8](repeating: 1, count: 3 * 1024))
+        XCTAssertEqual(second.bytes, [UInt8](repeating: 2, count: 3 * 1024))
+    }
+    
+    func testAcceptBatch() throws {
+        let deadline = 1.minute.fromNow()
+        let port = 8011
+        let host = try TCPHost(port: port)
+        var clients: [TCPStream] = []
+        
+        // Connections complete in the listen backlog before any is accepted.
+        for _ in 0 ..< 4 {
+            let client = try TCPStream(host: "127.0.0.1", port: port, deadline: deadline)
+            try client.open(deadline: deadline)
+            clients.append(client)
+        }
+        
+        XCTAssertEqual(try host.accept(upTo: 3, deadline: deadline).count, 3)
+        XCTAssertEqual(try host.accept(upTo: 3, deadline: deadline).count, 1)
+        
+        for client in clients {
+            try client.close(deadline: deadline)
+        }
+    }
+    
     public static var allTests: [(String, (TCPTests) -> () throws -> Void)] {
         return [
             ("testConnectionRefused", testConnectionRefused),
             ("testReadWriteClosedSocket", testReadWriteClosedSocket),
             ("testClientServer", testClientServer),
+            ("testSocketOptions", testSocketOptions),
+            ("testPipe", testPipe),
+            ("testConcurrentPipes", testConcurrentPipes),
+            ("testAcceptBatch", testAcceptBatch),
         ]
     }
 }
+
+/// Fills reads with `byte`, parking after each so copies interleave.
+private final class Filler : Readable {
+    let byte: UInt8
+    var count: Int
+    
+    init(byte: UInt8, count: Int) {
+        self.byte = byte
+        self.count = count
+    }
+    
+    func read(_ buffer: UnsafeMutableRawBufferPointer, deadline: Deadline) throws -> UnsafeRawBufferPointer {
+        guard count > 0 else {
+            return UnsafeRawBufferPointer(start: nil, count: 0)
+        }
+        
+        count -= 1
+        let length = min(buffer.count, 1024)
+        UnsafeMutableRawBufferPointer(rebasing: buffer[0 ..< length]).initializeMemory(as: UInt8.self, repeating: byte)
+        try Coroutine.wakeUp(1.milliseconds.fromNow())
+        return UnsafeRawBufferPointer(start: buffer.baseAddress, count: length)
+    }
+}
+
+private final class Collector : Writable {
+    var bytes: [UInt8] = []
+    
+    func write(_ buffer: UnsafeRawBufferPointer, deadline: Deadline) throws {
+        bytes.append(contentsOf: buffer)
+    }
+}
@@ -0,0 +1,54 @@
+import XCTest
+@testable import IO
+@testable import Core
+@testable import Venice
+
+public class URingTests: XCTestCase {
+    func testClientServer() throws {
+        #if os(Linux)
+            let deadline = 1.minute.fromNow()
+            let port = 8008
+            let channel = try Channel<Void>()
+            let host = try SocketBackend.ioUring.host(port: port)
+            
+            let buffer = UnsafeMutableRawBufferPointer.allocate(
+                byteCount: 10,
+                alignment: MemoryLayout<UInt8>.alignment
+            )
+            
+            defer {
+                buffer.deallocate()
+            }
+            
+            let coroutine = try Coroutine {
+                do {
+                    let stream = try host.accept(deadline: deadline)
+                    try stream.write("Yo client!", deadline: deadline)
+                    let read: String = try stream.read(buffer, deadline: deadline)
+                    XCTAssertEqual(read, "Yo server!")
+                    try stream.close(deadline: deadline)
+                    try channel.send(deadline: deadline)
+                } catch {
+                    XCTFail("\(error)")
+                }
+            }
+            
+            let stream = try SocketBackend.ioUring.stream(host: "127.0.0.1", port: port, deadline: deadline)
+            try stream.open(deadline: deadline)
+            let read: String = try stream.read(buffer, deadline: deadline)
+            XCTAssertEqual(read, "Yo client!")
+            try stream.write("Yo server!", deadline: deadline)
+            try stream.close(deadline: deadline)
+            try channel.receive(deadline: deadline)
+            coroutine.cancel()
+        #endif
+    }
+}
+
+extension URingTests {
+    public static var allTests: [(String, (URingTests) -> () throws -> Void)] {
+        return [
+            ("testClientServer", testClientServer),
+        ]
+    }
+}
@@ -0,0 +1,111 @@
+#if os(Linux)
+    import Glibc
+#else
+    import Darwin.C
+#endif
+
+import XCTest
+@testable import IO
+@testable import Core
+@testable import Venice
+
+public class UnixTests: XCTestCase {
+    func testConnectionRefused() throws {
+        let deadline = 1.minute.fromNow()
+        let connection = UnixStream(path: "/tmp/zewo-unix-tests-missing.sock")
+        XCTAssertThrowsError(try connection.open(deadline: deadline))
+    }
+    
+    func testClientServer() throws {
+        try clientServer(path: "/tmp/zewo-unix-tests.sock")
+    }
+    
+    func testAbstractNamespace() throws {
+        #if os(Linux)
+            try clientServer(path: "@zewo-unix-tests")
+        #endif
+    }
+    
+    func testOnlySocketsAreReplaced() throws {
+        let path = "/tmp/zewo-unix-tests-file.sock"
+        let file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0o600)
+        XCTAssertNotEqual(file, -1)
+        close(file)
+        
+        defer {
+            unlink(path)
+        }
+        
+        XCTAssertThrowsError(try UnixHost(path: path)) { error in
+            guard case SystemError.addressAlreadyInUse = error else {
+                return XCTFail("\(error)")
+            }
+        }
+        
+        XCTAssertEqual(access(path, F_OK), 0)
+    }
+    
+    func testSuccessorKeepsItsSocket() throws {
+        let path = "/tmp/zewo-unix-tests-handover.sock"
+        var predecessor: UnixHost? = try UnixHost(path: path)
+        var successor: UnixHost? = try UnixHost(path: path)
+        
+        // Going away, the predecessor must not remove the successor's socket.
+        XCTAssertNotNil(predecessor)
+        predecessor = nil
+        XCTAssertEqual(access(path, F_OK), 0)
+        
+        XCTAssertNotNil(successor)
+        successor = nil
+        XCTAssertEqual(access(path, F_OK), -1)
+    }
+    
+    private func clientServer(path: String) throws {
+        let deadline = 1.minute.fromNow()
+        let channel = try Channel<Void>()
+        let host = try UnixHost(path: path)
+        
+        let buffer = UnsafeMutableRawBufferPointer.allocate(
+            byteCount: 10,
+            alignment: MemoryLayout<UInt8>.alignment
+        )
+        
+        defer {
+            buffer.deallocate()
+        }
+        
+        let coroutine = try Coroutine {
+            do {
+                let stream = try host.accept(deadline: deadline)
+                try stream.write("Yo client!", deadline: deadline)
+                let read: String = try stream.read(buffer, deadline: deadline)
+                XCTAssertEqual(read, "Yo server!")
+                try stream.close(deadline: deadline)
+                try channel.send(deadline: deadline)
+            } catch {
+                XCTFail("\(error)")
+            }
+        }
+        
+        let stream = UnixStream(path: path)
+        try stream.open(deadline: deadline)
+        let read: String = try stream.read(buffer, deadline: deadline)
+        XCTAssertEqual(read, "Yo client!")
+        try stream.write("Yo server!", deadline: deadline)
+        try stream.close(deadline: deadline)
+        try channel.receive(deadline: deadline)
+        coroutine.cancel()
+    }
+}
+
+extension UnixTests {
+    public static var allTests: [(String, (UnixTests) -> () throws -> Void)] {
+        return [
+            ("testConnectionRefused", testConnectionRefused),
+            ("testClientServer", testClientServer),
+            ("testAbstractNamespace", testAbstractNamespace),
+            ("testOnlySocketsAreReplaced", testOnlySocketsAreReplaced),
+            ("testSuccessorKeepsItsSocket", testSuccessorKeepsItsSocket),
+        ]
+    }
+}
@@ -5,13 +5,30 @@ import IOTests
 import MediaTests
     
 XCTMain([
+    testCase(AsyncLogAppenderTests.allTests),
+    testCase(MemoryAccountTests.allTests),
+    testCase(MetricsTests.allTests),
     testCase(StringTests.allTests),
     testCase(SystemErrorTests.allTests),
+    testCase(TraceTests.allTests),
+    testCase(ByteRangeTests.allTests),
     testCase(ClientTests.allTests),
+    testCase(CompressionTests.allTests),
+    testCase(EventHubTests.allTests),
+    testCase(HTTP2Tests.allTests),
+    testCase(HPACKTests.allTests),
+    testCase(MultipartTests.allTests),
     testCase(ServerTests.allTests),
+    testCase(StaticFilesTests.allTests),
+    testCase(WebSocketTests.allTests),
+    testCase(BufferedStreamTests.allTests),
+    testCase(FileTests.allTests),
     testCase(IPTests.allTests),
+    testCase(StallDetectorTests.allTests),
     testCase(TCPTests.allTests),
     testCase(TLSTests.allTests),
+    testCase(UnixTests.allTests),
+    testCase(URingTests.allTests),
     testCase(JSONTests.allTests),
     testCase(MapTests.allTests),
 ])